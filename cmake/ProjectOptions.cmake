@@ -40,4 +40,7 @@ if (NOT MYSQL_LIB_DIR)
 endif()
 
 # Folder Structure Options
-option(WITH_FOLDER_STRUCTURE    "Build source tree"                            1)
\ No newline at end of file
+option(WITH_FOLDER_STRUCTURE    "Build source tree"                            1)
+
+# Tests
+option(WITH_TESTS               "Build the tests and benchmarks"               1)
\ No newline at end of file
@@ -28,4 +28,11 @@ if( WITH_FOLDER_STRUCTURE )
 else()
   set_property(GLOBAL PROPERTY USE_FOLDERS OFF)
   message("- Compile with folder structure    : No")
+endif()
+
+if( WITH_TESTS )
+  enable_testing()
+  message("- Build tests and benchmarks       : Yes")
+else()
+  message("- Build tests and benchmarks       : No")
 endif()
\ No newline at end of file
@@ -29,28 +29,16 @@
 class AuthConnectionHandler : public Common::TcpServer
 {
 public:
-    AuthConnectionHandler(asio::io_service& io_service, i32 port) : Common::TcpServer(io_service, port) { }
+    AuthConnectionHandler(Common::IoServicePool& ioServicePool, i32 port, bool reusePort) : Common::TcpServer(ioServicePool, port, reusePort) { }
 private:
-    void StartListening() override
-    {
-        asio::ip::tcp::socket* socket = new asio::ip::tcp::socket(_ioService);
-        _acceptor.async_accept(*socket, std::bind(&AuthConnectionHandler::HandleNewConnection, this, socket, std::placeholders::_1));
-    }
-
     void HandleNewConnection(asio::ip::tcp::socket* socket, const asio::error_code& error_code) override
     {
         if (!error_code)
         {
-            _workerThread->_mutex.lock();
-
             socket->non_blocking(true);
-            AuthConnection* connection = new AuthConnection(socket);
+            std::shared_ptr<AuthConnection> connection = std::make_shared<AuthConnection>(socket);
+            AddConnection(connection);
             connection->Start();
-
-            _connections.push_back(connection);
-            _workerThread->_mutex.unlock();
         }
-
-        StartListening();
     }
 };
\ No newline at end of file
@@ -161,11 +161,11 @@ bool AuthConnection::HandleCommandChallenge()
 
     PreparedStatement stmt("SELECT guid, salt, verifier FROM accounts WHERE username={s};");
     stmt.Bind(username);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this](amy::result_set& results, DatabaseConnector& connector) { HandleCommandChallengeCallback(results); });
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this()](PreparedResultSet& results) { HandleCommandChallengeCallback(results); }, GetDispatcher(), SQL_PRIORITY_HIGH);
 
     return true;
 }
-void AuthConnection::HandleCommandChallengeCallback(amy::result_set& results)
+void AuthConnection::HandleCommandChallengeCallback(PreparedResultSet& results)
 {
     /* Logon Challenge Data Structure
 
@@ -186,7 +186,7 @@ void AuthConnection::HandleCommandChallengeCallback(amy::result_set& results)
         return;
     }
 
-    amy::row resultRow = results[0];
+    PreparedResultSet::Row resultRow = results[0];
     accountGuid = resultRow[0].GetU32();
     std::string dbSalt = resultRow[1].GetString();
     std::string dbVerifier = resultRow[2].GetString();
@@ -326,7 +326,7 @@ bool AuthConnection::HandleCommandProof()
         PreparedStatement stmt("UPDATE accounts SET sessionkey={s} WHERE username={s};");
         stmt.Bind(K.BN2Hex());
         stmt.Bind(username);
-        DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, proofM2](amy::result_set& results, DatabaseConnector& connector)
+        DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this(), proofM2](PreparedResultSet&)
         {
             /* Logon Proof Data Structure
 
@@ -349,7 +349,7 @@ bool AuthConnection::HandleCommandProof()
 
             Send(dataStore);
             _status = STATUS_AUTHED;
-        });
+        }, GetDispatcher(), SQL_PRIORITY_HIGH);
     }
     else
     {
@@ -383,11 +383,11 @@ bool AuthConnection::HandleCommandReconnectChallenge()
 
     PreparedStatement stmt("SELECT guid, sessionKey FROM accounts WHERE username={s};");
     stmt.Bind(username);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this](amy::result_set& results, DatabaseConnector& connector) { HandleCommandReconnectChallengeCallback(results); });
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this()](PreparedResultSet& results) { HandleCommandReconnectChallengeCallback(results); }, GetDispatcher(), SQL_PRIORITY_HIGH);
 
     return true;
 }
-void AuthConnection::HandleCommandReconnectChallengeCallback(amy::result_set& results)
+void AuthConnection::HandleCommandReconnectChallengeCallback(PreparedResultSet& results)
 {
     /* Logon Proof Data Structure
 
@@ -409,7 +409,7 @@ void AuthConnection::HandleCommandReconnectChallengeCallback(amy::result_set& re
         return;
     }
 
-    amy::row resultRow = results[0];
+    PreparedResultSet::Row resultRow = results[0];
     accountGuid = resultRow[0].GetU32();
     K.Hex2BN(resultRow[1].GetString().c_str());
 
@@ -464,20 +464,36 @@ bool AuthConnection::HandleCommandRealmserverList()
 
     PreparedStatement realmCharacterCount("SELECT realmId, characters FROM realm_characters WHERE account={u};");
     realmCharacterCount.Bind(accountGuid);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, realmCharacterCount, [this](amy::result_set& result, DatabaseConnector& connector)
+
+    struct RealmListQuery
+    {
+        PreparedResultSet characterCounts;
+        PreparedResultSet realms;
+        bool succeeded = false;
+    };
+    std::shared_ptr<RealmListQuery> query = std::make_shared<RealmListQuery>();
+
+    // Both lookups run on the SQL worker, the packet is built back on this connection's io_service
+    DatabaseConnector::RunAsync(DATABASE_TYPE::AUTHSERVER, [realmCharacterCount, query](DatabaseConnector& connector)
+    {
+        connector.Query(realmCharacterCount, query->characterCounts);
+        query->succeeded = connector.Query(PreparedStatement("SELECT id, name, address, type, flags, timezone, population FROM realms;"), query->realms);
+    },
+    [this, self = shared_from_this(), query]()
     {
         std::vector<u8> realmCharacterData(MAX_REALM_COUNT);
         std::fill(realmCharacterData.begin(), realmCharacterData.end(), 0);
 
-        for (auto row : result)
+        for (auto row : query->characterCounts)
         {
             realmCharacterData[row[0].GetU8()] = row[1].GetU8();
         }
 
-        amy::result_set realmserverListResultData;
-        if (!connector.Query("SELECT id, name, address, type, flags, timezone, population FROM realms;", realmserverListResultData))
+        if (!query->succeeded)
             return;
 
+        PreparedResultSet& realmserverListResultData = query->realms;
+
         /* Logon Proof Data Structure
 
            - Type: u8,      Name: Packet Command
@@ -544,7 +560,7 @@ bool AuthConnection::HandleCommandRealmserverList()
 
         Send(dataStore);
         _status = STATUS_AUTHED;
-    });
+    }, GetDispatcher(), SQL_PRIORITY_HIGH);
 
     return true;
 }
\ No newline at end of file
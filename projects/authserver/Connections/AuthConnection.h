@@ -135,10 +135,10 @@ public:
     void HandleRead() override;
 
     bool HandleCommandChallenge();
-    void HandleCommandChallengeCallback(amy::result_set& results);
+    void HandleCommandChallengeCallback(PreparedResultSet& results);
 
     bool HandleCommandReconnectChallenge();
-    void HandleCommandReconnectChallengeCallback(amy::result_set& results);
+    void HandleCommandReconnectChallengeCallback(PreparedResultSet& results);
     bool HandleCommandProof();
     bool HandleCommandReconnectProof();
     bool HandleCommandRealmserverList();
@@ -53,6 +53,12 @@ i32 main()
     DatabaseConnectionDetails dbConnections[DATABASE_TYPE::COUNT];
     dbConnections[DATABASE_TYPE::AUTHSERVER] = DatabaseConnectionDetails(ConfigHandler::GetJsonObjectByKey("auth_database"));
 
+    PreparedStatementSettings preparedStatementSettings;
+    preparedStatementSettings.enabled = ConfigHandler::GetOption<bool>("preparedStatements", true);
+    preparedStatementSettings.maxCachedStatements = ConfigHandler::GetOption<u32>("maxCachedStatements", 256);
+    DatabaseConnector::SetupPreparedStatements(preparedStatementSettings);
+    DatabaseConnector::SetupAsyncWorkers(ConfigHandler::GetOption<u32>("asyncWorkers", 2));
+
     /* Pass Database Information to Setup */
     DatabaseConnector::Setup(dbConnections);
 
@@ -63,15 +69,12 @@ i32 main()
         return 0;
     }
 
-    asio::io_service io_service(2);
-    AuthConnectionHandler authConnectionHandler(io_service, ConfigHandler::GetOption<u16>("port", 3724));
+    Common::IoServicePool ioServicePool(ConfigHandler::GetOption<u16>("networkThreads", 1));
+    AuthConnectionHandler authConnectionHandler(ioServicePool, ConfigHandler::GetOption<u16>("port", 3724), ConfigHandler::GetOption<bool>("reusePort", false));
     authConnectionHandler.Start();
 
     srand(static_cast<u32>(time(NULL)));
-    std::thread run_thread([&]
-    {
-        io_service.run();
-    });
+    ioServicePool.Run();
 
     NC_LOG_SUCCESS("Authserver running on port: %u", authConnectionHandler.GetPort());
 
@@ -39,7 +39,10 @@ json::value_type ConfigHandler::FindOptionInArray(std::string optionName, json::
 
         if (itr.value().is_structured())
         {
-            return FindOptionInArray(optionName, itr.value());
+            // Keys are iterated alphabetically, so a nested value that doesn't hold the option must not end the search
+            json::value_type nestedValue = FindOptionInArray(optionName, itr.value());
+            if (!nestedValue.is_null())
+                return nestedValue;
         }
     }
 
@@ -23,36 +23,99 @@
 */
 
 #include "ArcFour.h"
+#include <cstring>
+#include <algorithm>
 
-ArcFour::ArcFour(size_t size) : _CIPHER_CONTEXT(EVP_CIPHER_CTX_new())
+ArcFour::ArcFour(size_t size) : _keyLength(size), _i(0), _j(0), _keystreamPos(KeystreamBlockSize)
 {
-    EVP_CIPHER_CTX_init(_CIPHER_CONTEXT);
-    EVP_EncryptInit_ex(_CIPHER_CONTEXT, EVP_rc4(), nullptr, nullptr, nullptr);
-    EVP_CIPHER_CTX_set_key_length(_CIPHER_CONTEXT, static_cast<i32>(size));
+    for (u32 i = 0; i < 256; i++)
+    {
+        _state[i] = static_cast<u8>(i);
+    }
 }
 
-ArcFour::ArcFour(u8* seed, size_t size) : _CIPHER_CONTEXT(EVP_CIPHER_CTX_new())
+ArcFour::ArcFour(u8* seed, size_t size) : _keyLength(size), _i(0), _j(0), _keystreamPos(KeystreamBlockSize)
 {
-    EVP_CIPHER_CTX_init(_CIPHER_CONTEXT);
-
-    EVP_EncryptInit_ex(_CIPHER_CONTEXT, EVP_rc4(), nullptr, nullptr, nullptr);
-    EVP_CIPHER_CTX_set_key_length(_CIPHER_CONTEXT, static_cast<i32>(size));
-    EVP_EncryptInit_ex(_CIPHER_CONTEXT, nullptr, nullptr, seed, nullptr);
+    Setup(seed);
 }
 
 ArcFour::~ArcFour()
 {
-    EVP_CIPHER_CTX_free(_CIPHER_CONTEXT);
 }
 
 void ArcFour::Setup(u8* seed)
 {
-    EVP_EncryptInit_ex(_CIPHER_CONTEXT, nullptr, nullptr, seed, nullptr);
+    for (u32 i = 0; i < 256; i++)
+    {
+        _state[i] = static_cast<u8>(i);
+    }
+
+    u8 j = 0;
+    for (u32 i = 0; i < 256; i++)
+    {
+        j = static_cast<u8>(j + _state[i] + seed[i % _keyLength]);
+        std::swap(_state[i], _state[j]);
+    }
+
+    _i = 0;
+    _j = 0;
+
+    // Throw away anything prefetched with the previous key
+    _keystreamPos = KeystreamBlockSize;
+}
+
+void ArcFour::RefillKeystream()
+{
+    u8 i = _i;
+    u8 j = _j;
+    for (size_t k = 0; k < KeystreamBlockSize; k++)
+    {
+        i = static_cast<u8>(i + 1);
+        u8 si = _state[i];
+        j = static_cast<u8>(j + si);
+        u8 sj = _state[j];
+        _state[i] = sj;
+        _state[j] = si;
+        _keystream[k] = _state[static_cast<u8>(si + sj)];
+    }
+
+    _i = i;
+    _j = j;
+    _keystreamPos = 0;
+}
+
+void ArcFour::GenerateKeystream(size_t size, u8* keystream)
+{
+    while (size > 0)
+    {
+        if (_keystreamPos == KeystreamBlockSize)
+            RefillKeystream();
+
+        size_t count = std::min(size, KeystreamBlockSize - _keystreamPos);
+        std::memcpy(keystream, &_keystream[_keystreamPos], count);
+
+        _keystreamPos += count;
+        keystream += count;
+        size -= count;
+    }
 }
 
 void ArcFour::UpdateEncryption(size_t size, u8* data)
 {
-    i32 out = 0;
-    EVP_EncryptUpdate(_CIPHER_CONTEXT, data, &out, data, static_cast<i32>(size));
-    EVP_EncryptFinal_ex(_CIPHER_CONTEXT, data, &out);
+    while (size > 0)
+    {
+        if (_keystreamPos == KeystreamBlockSize)
+            RefillKeystream();
+
+        size_t count = std::min(size, KeystreamBlockSize - _keystreamPos);
+        u8* keystream = &_keystream[_keystreamPos];
+        for (size_t k = 0; k < count; k++)
+        {
+            data[k] ^= keystream[k];
+        }
+
+        _keystreamPos += count;
+        data += count;
+        size -= count;
+    }
 }
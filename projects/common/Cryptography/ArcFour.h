@@ -22,13 +22,16 @@
 # SOFTWARE.
 */
 #pragma once
-#include <openssl/evp.h>
 #include <stdint.h>
+#include <cstddef>
 #include "../NovusTypes.h"
 
+// RC4 stream cipher, keystream is generated in blocks ahead of time so short packet headers only cost an XOR
 class ArcFour 
 {
     public:
+        static constexpr size_t KeystreamBlockSize = 512;
+
         ArcFour(size_t size);
         ArcFour(u8* seed, size_t size);
         ~ArcFour();
@@ -36,6 +39,17 @@ class ArcFour
         void Setup(u8* seed);
         void UpdateEncryption(size_t size, u8* data);
 
+        // Copies the next size bytes of keystream into keystream and advances the cipher as if they had been used for encryption
+        void GenerateKeystream(size_t size, u8* keystream);
+
     private:
-        EVP_CIPHER_CTX* _CIPHER_CONTEXT;
+        void RefillKeystream();
+
+        size_t _keyLength;
+        u8 _state[256];
+        u8 _i;
+        u8 _j;
+
+        u8 _keystream[KeystreamBlockSize];
+        size_t _keystreamPos;
 };
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "StreamCrypto.h"
 
 #include <cstring>
+#include <memory>
 
 #include "HMAC.h"
 #include "BigNumber.h"
@@ -81,3 +82,34 @@ void StreamCrypto::Encrypt(u8* data, size_t size)
 
     _sEncrypt.UpdateEncryption(size, data);
 }
+
+void StreamCrypto::EncryptBatch(u8* const* data, const size_t* sizes, size_t count)
+{
+    if (!_valid)
+        return;
+
+    size_t totalSize = 0;
+    for (size_t i = 0; i < count; i++)
+        totalSize += sizes[i];
+
+    // Server packet headers are at most 5 bytes, so a flush of queued packets normally fits on the stack
+    u8 localKeystream[1024];
+    std::unique_ptr<u8[]> heapKeystream;
+    u8* keystream = localKeystream;
+    if (totalSize > sizeof(localKeystream))
+    {
+        heapKeystream.reset(new u8[totalSize]);
+        keystream = heapKeystream.get();
+    }
+
+    _sEncrypt.GenerateKeystream(totalSize, keystream);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        u8* buffer = data[i];
+        for (size_t j = 0; j < sizes[i]; j++)
+        {
+            buffer[j] ^= *keystream++;
+        }
+    }
+}
@@ -33,6 +33,8 @@ class StreamCrypto
         void SetupServer(BigNumber* key, u8* encryptionKey, u8* decryptionKey);
         void Decrypt(u8* data, size_t size);
         void Encrypt(u8* data, size_t size);
+        // Encrypts count buffers in order with a single keystream fetch, the result is identical to calling Encrypt on each of them
+        void EncryptBatch(u8* const* data, const size_t* sizes, size_t count);
 
         bool IsValid() const { return _valid; }
 
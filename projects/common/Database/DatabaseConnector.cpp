@@ -1,11 +1,17 @@
 #include "DatabaseConnector.h"
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
 #include <amy/placeholders.hpp>
 
 DatabaseConnectionDetails DatabaseConnector::_connections[];
 bool                     DatabaseConnector::_initialized = false;
+PreparedStatementSettings DatabaseConnector::_preparedStatementSettings;
+DatabaseStats DatabaseConnector::_stats;
 SharedPool<DatabaseConnector> DatabaseConnector::_connectorPools[];
-moodycamel::ConcurrentQueue<AsyncSQLJob> DatabaseConnector::_asyncJobQueue(1024);
+u32 DatabaseConnector::_asyncWorkersPerDatabase = 2;
+AsyncSQLLanes DatabaseConnector::_asyncLanes[];
 
 void DatabaseConnector::Setup(DatabaseConnectionDetails connections[])
 {
@@ -16,9 +22,28 @@ void DatabaseConnector::Setup(DatabaseConnectionDetails connections[])
     }
     _initialized = true;
 
-    // Create Async SQL thread
-    std::thread asyncThread(AsyncSQLThreadMain);
-    asyncThread.detach();
+    // Every used database gets its own pool of async workers, each holding its own connection
+    for (i32 i = 0; i < DATABASE_TYPE::COUNT; i++)
+    {
+        if (!_connections[i].isUsed)
+            continue;
+
+        for (u32 j = 0; j < _asyncWorkersPerDatabase; j++)
+        {
+            std::thread asyncWorker(AsyncSQLWorkerMain, static_cast<DATABASE_TYPE>(i));
+            asyncWorker.detach();
+        }
+    }
+}
+
+void DatabaseConnector::SetupPreparedStatements(const PreparedStatementSettings& settings)
+{
+    _preparedStatementSettings = settings;
+}
+
+static u64 GetElapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 // Static Connector creation
@@ -44,15 +69,16 @@ bool DatabaseConnector::Borrow(DATABASE_TYPE type, std::shared_ptr<DatabaseConne
     }
     assert(_connections[type].isUsed);
 
-    // If we are out of connectors, create one!
-    if (_connectorPools[type].empty())
+    // If we are out of connectors, create one! Another thread can grab it before we do, so keep going until we get one
+    SharedPool<DatabaseConnector>::ptr_type connector;
+    while (!_connectorPools[type].try_acquire(connector))
     {
         DatabaseConnector* newConnector = new DatabaseConnector();
         newConnector->_Connect(type);
         _connectorPools[type].add(std::unique_ptr<DatabaseConnector>(newConnector));
     }
 
-    out = _connectorPools[type].acquire();
+    out = std::move(connector);
 
     return true;
 }
@@ -65,94 +91,201 @@ void DatabaseConnector::Borrow(DATABASE_TYPE type, std::function<void(std::share
     }
     assert(_connections[type].isUsed);
 
-    // If we are out of connectors, create one!
-    if (_connectorPools[type].empty())
+    // If we are out of connectors, create one! Another thread can grab it before we do, so keep going until we get one
+    SharedPool<DatabaseConnector>::ptr_type connector;
+    while (!_connectorPools[type].try_acquire(connector))
     {
         DatabaseConnector* newConnector = new DatabaseConnector();
         newConnector->_Connect(type);
         _connectorPools[type].add(std::unique_ptr<DatabaseConnector>(newConnector));
     }
 
-    std::shared_ptr<DatabaseConnector> ptr(_connectorPools[type].acquire());
+    std::shared_ptr<DatabaseConnector> ptr(std::move(connector));
     func(ptr);
     return;
 }
 
 // Static Asyncs
-void DatabaseConnector::QueryAsync(DATABASE_TYPE type, std::string sql, std::function<void(amy::result_set& result, DatabaseConnector& connector)> const& func)
+void DatabaseConnector::_EnqueueAsync(DATABASE_TYPE type, SQL_PRIORITY priority, AsyncSQLJob& job)
 {
     assert(_connections[type].isUsed);
 
+    job.queueTime = std::chrono::steady_clock::now();
+    job.priority = priority;
+
+    if (job.orderKey != 0)
+    {
+        AsyncSQLLanes& lanes = _asyncLanes[type];
+        std::lock_guard<std::mutex> lock(lanes.orderedMutex);
+
+        auto itr = lanes.orderedJobs.find(job.orderKey);
+        if (itr != lanes.orderedJobs.end())
+        {
+            // An earlier job with this key hasn't finished, the worker finishing it queues this one
+            itr->second.push_back(std::move(job));
+            return;
+        }
+
+        lanes.orderedJobs[job.orderKey];
+    }
+
+    _PushAsync(type, job);
+}
+void DatabaseConnector::_PushAsync(DATABASE_TYPE type, AsyncSQLJob& job)
+{
+    AsyncSQLLanes& lanes = _asyncLanes[type];
+    SQL_PRIORITY priority = job.priority;
+    lanes.queues[priority].enqueue(std::move(job));
+    lanes.semaphore.Signal();
+}
+void DatabaseConnector::_ReleaseOrderKey(DATABASE_TYPE type, u64 orderKey)
+{
+    AsyncSQLLanes& lanes = _asyncLanes[type];
+    AsyncSQLJob next;
+    {
+        std::lock_guard<std::mutex> lock(lanes.orderedMutex);
+
+        auto itr = lanes.orderedJobs.find(orderKey);
+        assert(itr != lanes.orderedJobs.end());
+        if (itr->second.empty())
+        {
+            lanes.orderedJobs.erase(itr);
+            return;
+        }
+
+        next = std::move(itr->second.front());
+        itr->second.pop_front();
+    }
+
+    // The key stays claimed, so nothing queued after this job can overtake it
+    _PushAsync(type, next);
+}
+void DatabaseConnector::RunAsync(DATABASE_TYPE type, std::function<void(DatabaseConnector& connector)> const& work, std::function<void()> const& callback, SQLCallbackDispatcher const& dispatcher, SQL_PRIORITY priority)
+{
     AsyncSQLJob job;
-    job.type = type;
-    job.sql = sql;
-    job.func = func;
-    _asyncJobQueue.enqueue(job);
+    job.work = work;
+    job.callback = callback;
+    job.dispatcher = dispatcher;
+    _EnqueueAsync(type, priority, job);
 }
-void DatabaseConnector::ExecuteAsync(DATABASE_TYPE type, std::string sql)
+void DatabaseConnector::RunAsyncOrdered(DATABASE_TYPE type, u64 orderKey, std::function<void(DatabaseConnector& connector)> const& work, std::function<void()> const& callback, SQLCallbackDispatcher const& dispatcher, SQL_PRIORITY priority)
 {
-    assert(_connections[type].isUsed);
+    AsyncSQLJob job;
+    job.work = work;
+    job.callback = callback;
+    job.dispatcher = dispatcher;
+    job.orderKey = orderKey;
+    _EnqueueAsync(type, priority, job);
+}
+void DatabaseConnector::QueryAsync(DATABASE_TYPE type, const PreparedStatement& statement, std::function<void(PreparedResultSet& results)> const& callback, SQLCallbackDispatcher const& dispatcher, SQL_PRIORITY priority)
+{
+    // The results have to outlive the worker since the callback might run on another thread
+    std::shared_ptr<PreparedResultSet> results = std::make_shared<PreparedResultSet>();
 
     AsyncSQLJob job;
-    job.type = type;
-    job.sql = sql;
-    job.func = nullptr;
-    _asyncJobQueue.enqueue(job);
+    job.work = [statement, results](DatabaseConnector& connector) { connector.Query(statement, *results); };
+    job.callback = [results, callback]() { callback(*results); };
+    job.dispatcher = dispatcher;
+    _EnqueueAsync(type, priority, job);
+}
+void DatabaseConnector::ExecuteAsync(DATABASE_TYPE type, std::string sql, SQL_PRIORITY priority)
+{
+    AsyncSQLJob job;
+    job.work = [sql](DatabaseConnector& connector) { connector.Execute(sql); };
+    _EnqueueAsync(type, priority, job);
+}
+void DatabaseConnector::ExecuteAsync(DATABASE_TYPE type, const PreparedStatement& statement, SQL_PRIORITY priority)
+{
+    AsyncSQLJob job;
+    job.work = [statement](DatabaseConnector& connector) { connector.Execute(statement); };
+    _EnqueueAsync(type, priority, job);
+}
+
+static u32 GetLatencyBucket(u64 microseconds)
+{
+    u32 bucket = 0;
+    while (bucket < SQL_LATENCY_BUCKETS - 1 && (1ull << bucket) <= microseconds)
+    {
+        bucket++;
+    }
+
+    return bucket;
 }
 
-void DatabaseConnector::AsyncSQLThreadMain()
+u64 DatabaseConnector::GetQueueLatencyPercentile(SQL_PRIORITY priority, f64 percentile)
 {
+    u64 buckets[SQL_LATENCY_BUCKETS];
+    u64 total = 0;
+    for (u32 i = 0; i < SQL_LATENCY_BUCKETS; i++)
+    {
+        buckets[i] = _stats.queueLatency[priority][i].load();
+        total += buckets[i];
+    }
+
+    if (total == 0)
+        return 0;
+
+    u64 target = static_cast<u64>(std::ceil(total * percentile / 100.0));
+    u64 count = 0;
+    for (u32 i = 0; i < SQL_LATENCY_BUCKETS; i++)
+    {
+        count += buckets[i];
+        if (count >= target)
+            return 1ull << i;
+    }
+
+    return 1ull << (SQL_LATENCY_BUCKETS - 1);
+}
+
+void DatabaseConnector::AsyncSQLWorkerMain(DATABASE_TYPE type)
+{
+    std::unique_ptr<DatabaseConnector> connector;
+    if (!DatabaseConnector::Create(type, connector))
+    {
+        NC_LOG_FATAL("Connecting to database failed!");
+    }
+
+    AsyncSQLLanes& lanes = _asyncLanes[type];
     AsyncSQLJob job;
-    amy::result_set results;
-    size_t tries = 0;
 
-    std::unique_ptr<DatabaseConnector> connectors[DATABASE_TYPE::COUNT];
-    for (size_t i = 0; i < DATABASE_TYPE::COUNT; i++)
+    while (true)
     {
-        if (_connections[i].isUsed)
+        // Sleeps until a job is queued for this database, every signal is matched by exactly one job
+        lanes.semaphore.Wait();
+
+        // Higher lanes are always drained first. A job can briefly be invisible while its producer
+        // is still publishing it, so keep looking until the job we were woken for turns up
+        u32 priority = 0;
+        while (!lanes.queues[priority].try_dequeue(job))
         {
-            if (!DatabaseConnector::Create((DATABASE_TYPE)i, connectors[i]))
+            priority++;
+            if (priority == SQL_PRIORITY_COUNT)
             {
-                NC_LOG_FATAL("Connecting to database failed!");
+                priority = 0;
+                std::this_thread::yield();
             }
         }
-    }
 
-    // This thread will just spin and try to execute any AsyncSQLJobs in the queue.
-    // When the queue is empty, it will first retry immediately 10 times, after that it will retry 10 times a second for 9 seconds, and after that it will decrease to 2 checks a second
-    // When the thread finds something in the queue, this behavior is reset.
-    // This behavior should give us a good mix between short wait times and not consuming 100% of a CPU core.
-    while (true)
-    {
-        if (_asyncJobQueue.try_dequeue(job))
-        {
-            tries = 0;
+        u64 waitedUs = GetElapsedNs(job.queueTime) / 1000;
+        _stats.asyncJobs[priority]++;
+        _stats.queueLatency[priority][GetLatencyBucket(waitedUs)]++;
 
-            bool isQuery = job.func != nullptr;
+        job.work(*connector);
 
-            if (isQuery)
-            {
-                connectors[job.type]->Query(job.sql, results);
-                job.func(results, *(connectors[job.type]));
-            }
+        if (job.callback)
+        {
+            if (job.dispatcher)
+                job.dispatcher(std::move(job.callback));
             else
-            {
-                connectors[job.type]->Execute(job.sql);
-            }
+                job.callback();
         }
-        else
-        {
-            if (tries > 100)
-            {
-                std::this_thread::sleep_for(std::chrono::microseconds(500)); // Sleep for 0.5 second, 2 checks a second
-                continue; // This continue makes sure that we don't increase tries more than we need to, preventing any possible overflows
-            }
-            if (tries > 10)
-                std::this_thread::sleep_for(std::chrono::microseconds(100)); // Sleep for 0.1 second, 10 checks a second
 
-            tries++;
-            continue;
-        }
+        // Hand the key to the next job waiting on it only once this one's callback is queued, so callbacks keep the same order
+        if (job.orderKey != 0)
+            _ReleaseOrderKey(type, job.orderKey);
+
+        // Drop the captures now instead of holding on to them until the next job arrives
+        job = AsyncSQLJob();
     }
 }
 
@@ -164,7 +297,10 @@ DatabaseConnector::DatabaseConnector()
 
 DatabaseConnector::~DatabaseConnector()
 {
-
+    for (auto& itr : _statements)
+    {
+        mysql_stmt_close(itr.second.statement);
+    }
 }
 
 bool DatabaseConnector::_Connect(DATABASE_TYPE type)
@@ -190,29 +326,373 @@ bool DatabaseConnector::_Connect(DATABASE_TYPE type)
 
 bool DatabaseConnector::Execute(std::string sql)
 {
+    auto start = std::chrono::steady_clock::now();
+
     std::error_code error;
     _connector->query(sql, error);
 
     if (error)
     {
         NC_LOG_ERROR(error.message());
+        _stats.failures++;
         return false;
     }
 
+    _stats.textStatements++;
+    _stats.textTimeNs += GetElapsedNs(start);
     return true;
 }
 
+bool DatabaseConnector::Execute(const PreparedStatement& statement)
+{
+    if (_ShouldPrepare(statement))
+        return ExecuteStatement(statement, nullptr);
+
+    return Execute(statement.Get());
+}
+
 bool DatabaseConnector::Query(std::string sql, amy::result_set& results)
 {
+    auto start = std::chrono::steady_clock::now();
+
     std::error_code error;
     _connector->query(sql, error);
 
     if (error)
     {
         NC_LOG_ERROR(_connector->error_message(error));
+        _stats.failures++;
         return false;
     }
 
     results = _connector->store_result();
+
+    _stats.textStatements++;
+    _stats.textTimeNs += GetElapsedNs(start);
     return true;
 }
+
+bool DatabaseConnector::Query(const PreparedStatement& statement, PreparedResultSet& results)
+{
+    if (_ShouldPrepare(statement))
+        return ExecuteStatement(statement, &results);
+
+    results.clear();
+
+    amy::result_set textResults;
+    if (!Query(statement.Get(), textResults))
+        return false;
+
+    // The text protocol only gives us strings, fields convert them when they are read
+    results._affectedRows = textResults.affected_rows();
+    for (const amy::row& row : textResults)
+    {
+        results._fieldCount = row.size();
+        for (const amy::field& field : row)
+        {
+            results._fields.emplace_back();
+            if (!field.is_null())
+            {
+                PreparedField& preparedField = results._fields.back();
+                preparedField._type = PreparedField::Type::STRING;
+                preparedField._stringValue.assign(field.data(), field.size());
+            }
+        }
+        results._rowCount++;
+    }
+
+    return true;
+}
+
+bool DatabaseConnector::ExecuteStatement(const PreparedStatement& statement, PreparedResultSet* results)
+{
+    if (!statement.Verify())
+    {
+        NC_LOG_ERROR("Found unbound tokens in statement: %s", statement.GetTemplate().c_str());
+        _stats.failures++;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    MYSQL_STMT* mysqlStatement = _GetStatement(statement);
+    if (!mysqlStatement)
+    {
+        _stats.failures++;
+        return false;
+    }
+
+    const std::vector<PreparedParameter>& parameters = statement.GetParameters();
+    size_t parameterCount = parameters.size();
+
+    if (mysql_stmt_param_count(mysqlStatement) != parameterCount)
+    {
+        NC_LOG_ERROR("Statement expects %lu parameters but %zu were bound: %s", mysql_stmt_param_count(mysqlStatement), parameterCount, statement.GetTemplate().c_str());
+        _stats.failures++;
+        return false;
+    }
+
+    _binds.assign(parameterCount, MYSQL_BIND());
+    _lengths.assign(parameterCount, 0);
+
+    for (size_t i = 0; i < parameterCount; i++)
+    {
+        const PreparedParameter& parameter = parameters[i];
+        MYSQL_BIND& bind = _binds[i];
+
+        switch (parameter.type)
+        {
+            case PreparedParameterType::STRING:
+                _lengths[i] = static_cast<unsigned long>(parameter.stringValue.size());
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer = const_cast<char*>(parameter.stringValue.data());
+                bind.buffer_length = _lengths[i];
+                bind.length = &_lengths[i];
+                break;
+            case PreparedParameterType::SIGNED:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = const_cast<i64*>(&parameter.signedValue);
+                break;
+            case PreparedParameterType::UNSIGNED:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = const_cast<u64*>(&parameter.unsignedValue);
+                bind.is_unsigned = 1;
+                break;
+            case PreparedParameterType::FLOAT:
+                bind.buffer_type = MYSQL_TYPE_FLOAT;
+                bind.buffer = const_cast<f32*>(&parameter.floatValue);
+                break;
+            case PreparedParameterType::DOUBLE:
+                bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                bind.buffer = const_cast<f64*>(&parameter.doubleValue);
+                break;
+        }
+    }
+
+    if (parameterCount > 0 && mysql_stmt_bind_param(mysqlStatement, _binds.data()))
+    {
+        NC_LOG_ERROR("Failed to bind parameters for statement: %s (%s)", statement.GetTemplate().c_str(), mysql_stmt_error(mysqlStatement));
+        _stats.failures++;
+        return false;
+    }
+
+    if (mysql_stmt_execute(mysqlStatement) != 0)
+    {
+        NC_LOG_ERROR("Failed to execute statement: %s (%s)", statement.GetTemplate().c_str(), mysql_stmt_error(mysqlStatement));
+
+        // The handle might not survive whatever went wrong (a reconnect drops every server side statement), so prepare it again next time
+        _CloseStatement(statement.GetId());
+        _stats.failures++;
+        return false;
+    }
+
+    bool succeeded = true;
+    if (results)
+    {
+        succeeded = _FetchResults(mysqlStatement, *results);
+    }
+    else if (mysql_stmt_field_count(mysqlStatement) > 0)
+    {
+        mysql_stmt_free_result(mysqlStatement);
+    }
+
+    if (!succeeded)
+    {
+        _stats.failures++;
+        return false;
+    }
+
+    _stats.preparedStatements++;
+    _stats.preparedTimeNs += GetElapsedNs(start);
+    return true;
+}
+
+bool DatabaseConnector::_ShouldPrepare(const PreparedStatement& statement)
+{
+    if (!_preparedStatementSettings.enabled || statement.IsOneOff())
+        return false;
+
+    auto itr = _statements.find(statement.GetId());
+    if (itr != _statements.end())
+    {
+        // Two templates hashing to the same id would keep replacing each other, the newcomer stays on plain text
+        return itr->second.statementTemplate == statement.GetTemplate();
+    }
+
+    return _statements.size() < _preparedStatementSettings.maxCachedStatements;
+}
+
+MYSQL_STMT* DatabaseConnector::_GetStatement(const PreparedStatement& statement)
+{
+    auto itr = _statements.find(statement.GetId());
+    if (itr != _statements.end())
+    {
+        if (itr->second.statementTemplate == statement.GetTemplate())
+            return itr->second.statement;
+
+        _CloseStatement(statement.GetId());
+    }
+
+    MYSQL_STMT* mysqlStatement = mysql_stmt_init(_connector->native());
+    if (!mysqlStatement)
+    {
+        NC_LOG_ERROR("Failed to allocate a statement handle for: %s", statement.GetTemplate().c_str());
+        return nullptr;
+    }
+
+    std::string sql = statement.GetParameterizedSql();
+    if (mysql_stmt_prepare(mysqlStatement, sql.c_str(), static_cast<unsigned long>(sql.size())) != 0)
+    {
+        NC_LOG_ERROR("Failed to prepare statement: %s (%s)", sql.c_str(), mysql_stmt_error(mysqlStatement));
+        mysql_stmt_close(mysqlStatement);
+        return nullptr;
+    }
+
+    // Makes mysql_stmt_store_result fill in max_length, so we can size string buffers before fetching
+    MySQLBool updateMaxLength = 1;
+    mysql_stmt_attr_set(mysqlStatement, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+
+    CachedStatement& cachedStatement = _statements[statement.GetId()];
+    cachedStatement.statementTemplate = statement.GetTemplate();
+    cachedStatement.statement = mysqlStatement;
+
+    _stats.statementsCached++;
+    return mysqlStatement;
+}
+
+void DatabaseConnector::_CloseStatement(u32 id)
+{
+    auto itr = _statements.find(id);
+    if (itr == _statements.end())
+        return;
+
+    mysql_stmt_close(itr->second.statement);
+    _statements.erase(itr);
+}
+
+bool DatabaseConnector::_FetchResults(MYSQL_STMT* statement, PreparedResultSet& results)
+{
+    results.clear();
+
+    u32 fieldCount = mysql_stmt_field_count(statement);
+    if (fieldCount == 0)
+    {
+        results._affectedRows = mysql_stmt_affected_rows(statement);
+        return true;
+    }
+
+    if (mysql_stmt_store_result(statement) != 0)
+    {
+        NC_LOG_ERROR("Failed to store statement results (%s)", mysql_stmt_error(statement));
+        return false;
+    }
+
+    MYSQL_RES* metadata = mysql_stmt_result_metadata(statement);
+    if (!metadata)
+    {
+        NC_LOG_ERROR("Failed to get statement result metadata (%s)", mysql_stmt_error(statement));
+        mysql_stmt_free_result(statement);
+        return false;
+    }
+    MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+
+    _binds.assign(fieldCount, MYSQL_BIND());
+    _lengths.assign(fieldCount, 0);
+    _nulls.assign(fieldCount, 0);
+
+    // Integer and floating point columns are fetched straight into 8 byte slots, everything else as a string
+    size_t bufferSize = 0;
+    for (u32 i = 0; i < fieldCount; i++)
+    {
+        MYSQL_BIND& bind = _binds[i];
+
+        switch (fields[i].type)
+        {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_LONGLONG:
+            case MYSQL_TYPE_YEAR:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer_length = sizeof(u64);
+                bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+                break;
+            case MYSQL_TYPE_FLOAT:
+            case MYSQL_TYPE_DOUBLE:
+                bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                bind.buffer_length = sizeof(f64);
+                break;
+            default:
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer_length = fields[i].max_length + 1;
+                break;
+        }
+
+        bind.length = &_lengths[i];
+        bind.is_null = &_nulls[i];
+        bufferSize += (bind.buffer_length + 7) & ~static_cast<size_t>(7);
+    }
+
+    _resultBuffer.resize(bufferSize);
+
+    size_t offset = 0;
+    for (u32 i = 0; i < fieldCount; i++)
+    {
+        _binds[i].buffer = &_resultBuffer[offset];
+        offset += (_binds[i].buffer_length + 7) & ~static_cast<size_t>(7);
+    }
+
+    if (mysql_stmt_bind_result(statement, _binds.data()))
+    {
+        NC_LOG_ERROR("Failed to bind statement results (%s)", mysql_stmt_error(statement));
+        mysql_free_result(metadata);
+        mysql_stmt_free_result(statement);
+        return false;
+    }
+
+    results._fieldCount = fieldCount;
+    results._fields.reserve(static_cast<size_t>(mysql_stmt_num_rows(statement)) * fieldCount);
+
+    int status;
+    while ((status = mysql_stmt_fetch(statement)) == 0 || status == MYSQL_DATA_TRUNCATED)
+    {
+        for (u32 i = 0; i < fieldCount; i++)
+        {
+            results._fields.emplace_back();
+            if (_nulls[i])
+                continue;
+
+            PreparedField& field = results._fields.back();
+            const MYSQL_BIND& bind = _binds[i];
+
+            switch (bind.buffer_type)
+            {
+                case MYSQL_TYPE_LONGLONG:
+                    field._type = bind.is_unsigned ? PreparedField::Type::UNSIGNED : PreparedField::Type::SIGNED;
+                    std::memcpy(&field._unsignedValue, bind.buffer, sizeof(u64));
+                    break;
+                case MYSQL_TYPE_DOUBLE:
+                    field._type = PreparedField::Type::DOUBLE;
+                    std::memcpy(&field._doubleValue, bind.buffer, sizeof(f64));
+                    break;
+                default:
+                    field._type = PreparedField::Type::STRING;
+                    field._stringValue.assign(static_cast<const char*>(bind.buffer), _lengths[i]);
+                    break;
+            }
+        }
+        results._rowCount++;
+    }
+    results._affectedRows = results._rowCount;
+
+    if (status != MYSQL_NO_DATA)
+    {
+        NC_LOG_ERROR("Failed to fetch statement results (%s)", mysql_stmt_error(statement));
+    }
+
+    mysql_free_result(metadata);
+    mysql_stmt_free_result(statement);
+
+    return status == MYSQL_NO_DATA;
+}
@@ -26,14 +26,21 @@
 #include <string>
 #include <functional>
 #include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
 
 #include "json.hpp"
 #include <amy/connector.hpp>
+#include <robin_hood.h>
 #include "../Utils/DebugHandler.h"
 #include "../Utils/SharedPool.h"
 #include "../Utils/ConcurrentQueue.h"
+#include "../Utils/Semaphore.h"
 #include "../NovusTypes.h"
 #include "PreparedStatement.h"
+#include "PreparedResultSet.h"
+#include "SQLCallbackQueue.h"
 
 enum DATABASE_TYPE
 {
@@ -44,6 +51,18 @@ enum DATABASE_TYPE
     COUNT
 };
 
+// Async jobs are picked up by lane, a worker only takes a lower priority job when every lane above it is empty
+enum SQL_PRIORITY
+{
+    SQL_PRIORITY_HIGH, // Logins and anything else a player is waiting on
+    SQL_PRIORITY_NORMAL,
+    SQL_PRIORITY_LOW, // Background saves
+    SQL_PRIORITY_COUNT
+};
+
+// Queue latency bucket i counts jobs that waited less than 2^i microseconds
+constexpr u32 SQL_LATENCY_BUCKETS = 32;
+
 using json = nlohmann::json;
 struct DatabaseConnectionDetails
 {
@@ -66,65 +85,133 @@ struct DatabaseConnectionDetails
     bool isUsed = false;
 };
 
+struct PreparedStatementSettings
+{
+    bool enabled = true; // When disabled, PreparedStatements are sent as plain text queries
+    u32 maxCachedStatements = 256; // Per connector, nothing is evicted, so once the first templates fill it every new one runs as a plain text query
+};
+
+struct DatabaseStats
+{
+    std::atomic<u64> textStatements;
+    std::atomic<u64> textTimeNs;
+    std::atomic<u64> preparedStatements;
+    std::atomic<u64> preparedTimeNs;
+    std::atomic<u64> statementsCached;
+    std::atomic<u64> failures;
+
+    std::atomic<u64> asyncJobs[SQL_PRIORITY_COUNT];
+    std::atomic<u64> queueLatency[SQL_PRIORITY_COUNT][SQL_LATENCY_BUCKETS];
+};
+
 class DatabaseConnector;
 struct AsyncSQLJob
 {
     AsyncSQLJob()
     {
-        type = DATABASE_TYPE::AUTHSERVER;
-        sql = "";
-        func = nullptr;
+        work = nullptr;
+        callback = nullptr;
+        dispatcher = nullptr;
+        priority = SQL_PRIORITY_NORMAL;
+        orderKey = 0;
     }
 
-    DATABASE_TYPE type;
-    std::string sql;
-    std::function<void(amy::result_set&, DatabaseConnector&)> func;
+    std::function<void(DatabaseConnector&)> work; // Runs on a worker with that worker's connector
+    std::function<void()> callback; // Handed to the dispatcher once work is done, without a dispatcher it runs on the worker
+    SQLCallbackDispatcher dispatcher;
+    SQL_PRIORITY priority;
+    u64 orderKey; // 0 when the job may run alongside any other
+    std::chrono::steady_clock::time_point queueTime;
+};
+
+struct AsyncSQLLanes
+{
+    moodycamel::ConcurrentQueue<AsyncSQLJob> queues[SQL_PRIORITY_COUNT];
+    Semaphore semaphore; // Signalled once per queued job
+
+    // An order key is in here while one of its jobs is queued or running, later jobs with that key wait behind it
+    std::mutex orderedMutex;
+    robin_hood::unordered_map<u64, std::deque<AsyncSQLJob>> orderedJobs;
 };
 
+// my_bool was replaced by bool in MySQL 8, use whatever MYSQL_BIND points to
+using MySQLBool = std::remove_pointer_t<decltype(MYSQL_BIND::is_null)>;
+
 class DatabaseConnector
 {
 public:
     // Initialization
     static void Setup(DatabaseConnectionDetails connections[]);
+    static void SetupPreparedStatements(const PreparedStatementSettings& settings);
+    static void SetupAsyncWorkers(u32 workersPerDatabase) { _asyncWorkersPerDatabase = workersPerDatabase > 0 ? workersPerDatabase : 1; }
+    static const PreparedStatementSettings& GetPreparedStatementSettings() { return _preparedStatementSettings; }
+    static const DatabaseStats& GetStats() { return _stats; }
+    static u64 GetQueueLatencyPercentile(SQL_PRIORITY priority, f64 percentile); // Percentile from 0 to 100, returns an upper bound in microseconds
 
     // Static Connector creation
     static bool Create(DATABASE_TYPE type, std::unique_ptr<DatabaseConnector>& out);
     static bool Borrow(DATABASE_TYPE type, std::shared_ptr<DatabaseConnector>& out);
     static void Borrow(DATABASE_TYPE type, std::function<void(std::shared_ptr<DatabaseConnector>& connector)> const& func);
 
-    // Async main function
-    static void AsyncSQLThreadMain();
+    // Async worker main function, every used DATABASE_TYPE gets its own pool of these
+    static void AsyncSQLWorkerMain(DATABASE_TYPE type);
 
     // Static Async functions
-    static void QueryAsync(DATABASE_TYPE type, std::string sql, std::function<void(amy::result_set& results, DatabaseConnector& connector)> const& func);
-    static void ExecuteAsync(DATABASE_TYPE type, std::string sql);
+    static void RunAsync(DATABASE_TYPE type, std::function<void(DatabaseConnector& connector)> const& work, std::function<void()> const& callback, SQLCallbackDispatcher const& dispatcher = nullptr, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL);
+    // Jobs sharing an order key, like a character guid, run one after another in the order they were queued, whatever their priority
+    static void RunAsyncOrdered(DATABASE_TYPE type, u64 orderKey, std::function<void(DatabaseConnector& connector)> const& work, std::function<void()> const& callback, SQLCallbackDispatcher const& dispatcher = nullptr, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL);
 
-    static void QueryAsync(DATABASE_TYPE type, PreparedStatement statement, std::function<void(amy::result_set& results, DatabaseConnector& connector)> const& func) { QueryAsync(type, statement.Get(), func); }
-    static void ExecuteAsync(DATABASE_TYPE type, PreparedStatement statement) { ExecuteAsync(type, statement.Get()); }
+    static void QueryAsync(DATABASE_TYPE type, const PreparedStatement& statement, std::function<void(PreparedResultSet& results)> const& callback, SQLCallbackDispatcher const& dispatcher = nullptr, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL);
+    static void ExecuteAsync(DATABASE_TYPE type, std::string sql, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL);
+    static void ExecuteAsync(DATABASE_TYPE type, const PreparedStatement& statement, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL);
 
 
     bool Execute(std::string sql);
-    inline bool Execute(PreparedStatement statement) { return Execute(statement.Get()); }
-    inline void ExecuteAsync(std::string sql) { ExecuteAsync(_type, sql); }
-    inline void ExecuteAsync(PreparedStatement statement) { ExecuteAsync(_type, statement.Get()); }
+    bool Execute(const PreparedStatement& statement);
+    inline void ExecuteAsync(std::string sql, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL) { ExecuteAsync(_type, sql, priority); }
+    inline void ExecuteAsync(const PreparedStatement& statement, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL) { ExecuteAsync(_type, statement, priority); }
 
     bool Query(std::string sql, amy::result_set& results);
-    inline bool Query(PreparedStatement statement, amy::result_set& results) { return Query(statement.Get(), results); }
-    inline void QueryAsync(std::string sql, std::function<void(amy::result_set& results, DatabaseConnector& connector)> const& func) { QueryAsync(_type, sql, func); }
-    inline void QueryAsync(PreparedStatement statement, std::function<void(amy::result_set& results, DatabaseConnector& connector)> const& func) { QueryAsync(_type, statement.Get(), func); }
+    inline bool Query(const PreparedStatement& statement, amy::result_set& results) { return Query(statement.Get(), results); }
+    bool Query(const PreparedStatement& statement, PreparedResultSet& results);
+    inline void QueryAsync(const PreparedStatement& statement, std::function<void(PreparedResultSet& results)> const& callback, SQLCallbackDispatcher const& dispatcher = nullptr, SQL_PRIORITY priority = SQL_PRIORITY_NORMAL) { QueryAsync(_type, statement, callback, dispatcher, priority); }
+
+    // Runs the statement through the binary protocol regardless of PreparedStatementSettings::enabled, results may be nullptr
+    bool ExecuteStatement(const PreparedStatement& statement, PreparedResultSet* results);
 
     ~DatabaseConnector();
 private:
     DatabaseConnector(); // Constructor is private because we don't want to allow newing these, use Create to aquire a smartpointer.
     bool _Connect(DATABASE_TYPE type);
+    bool _ShouldPrepare(const PreparedStatement& statement);
+    MYSQL_STMT* _GetStatement(const PreparedStatement& statement);
+    void _CloseStatement(u32 id);
+    bool _FetchResults(MYSQL_STMT* statement, PreparedResultSet& results);
+    static void _EnqueueAsync(DATABASE_TYPE type, SQL_PRIORITY priority, AsyncSQLJob& job);
+    static void _PushAsync(DATABASE_TYPE type, AsyncSQLJob& job);
+    static void _ReleaseOrderKey(DATABASE_TYPE type, u64 orderKey);
+
+    struct CachedStatement
+    {
+        std::string statementTemplate;
+        MYSQL_STMT* statement;
+    };
 
     DATABASE_TYPE _type;
     amy::connector* _connector;
 
+    robin_hood::unordered_map<u32, CachedStatement> _statements;
+    std::vector<MYSQL_BIND> _binds;
+    std::vector<unsigned long> _lengths;
+    std::vector<MySQLBool> _nulls;
+    std::vector<u8> _resultBuffer;
+
     static DatabaseConnectionDetails _connections[DATABASE_TYPE::COUNT];
     static bool _initialized;
+    static PreparedStatementSettings _preparedStatementSettings;
+    static DatabaseStats _stats;
 
     static SharedPool<DatabaseConnector> _connectorPools[DATABASE_TYPE::COUNT];
-    static std::thread* _asyncThread;
-    static moodycamel::ConcurrentQueue<AsyncSQLJob> _asyncJobQueue;
+    static u32 _asyncWorkersPerDatabase;
+    static AsyncSQLLanes _asyncLanes[DATABASE_TYPE::COUNT];
 };
\ No newline at end of file
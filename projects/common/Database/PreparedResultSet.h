@@ -0,0 +1,186 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include "../NovusTypes.h"
+
+// A single column value, numeric columns are decoded straight from the binary protocol while
+// text protocol results keep the server's string and convert on access
+class PreparedField
+{
+public:
+    bool is_null() const { return _type == Type::NONE; }
+
+    u8 GetU8() const { return static_cast<u8>(GetUnsigned()); }
+    u16 GetU16() const { return static_cast<u16>(GetUnsigned()); }
+    u32 GetU32() const { return static_cast<u32>(GetUnsigned()); }
+    u64 GetU64() const { return GetUnsigned(); }
+    i8 GetI8() const { return static_cast<i8>(GetSigned()); }
+    i16 GetI16() const { return static_cast<i16>(GetSigned()); }
+    i32 GetI32() const { return static_cast<i32>(GetSigned()); }
+    i64 GetI64() const { return GetSigned(); }
+    f32 GetF32() const { return static_cast<f32>(GetDouble()); }
+    f64 GetF64() const { return GetDouble(); }
+
+    std::string GetString() const
+    {
+        assert(!is_null());
+        switch (_type)
+        {
+            case Type::UNSIGNED: return std::to_string(_unsignedValue);
+            case Type::SIGNED: return std::to_string(_signedValue);
+            case Type::DOUBLE: return std::to_string(_doubleValue);
+            default: return _stringValue;
+        }
+    }
+
+private:
+    friend class PreparedResultSet;
+    friend class DatabaseConnector;
+
+    enum class Type : u8
+    {
+        NONE,
+        UNSIGNED,
+        SIGNED,
+        DOUBLE,
+        STRING
+    };
+
+    u64 GetUnsigned() const
+    {
+        assert(!is_null());
+        switch (_type)
+        {
+            case Type::UNSIGNED: return _unsignedValue;
+            case Type::SIGNED: return static_cast<u64>(_signedValue);
+            case Type::DOUBLE: return static_cast<u64>(_doubleValue);
+            default: return std::strtoull(_stringValue.c_str(), nullptr, 10);
+        }
+    }
+    i64 GetSigned() const
+    {
+        assert(!is_null());
+        switch (_type)
+        {
+            case Type::UNSIGNED: return static_cast<i64>(_unsignedValue);
+            case Type::SIGNED: return _signedValue;
+            case Type::DOUBLE: return static_cast<i64>(_doubleValue);
+            default: return std::strtoll(_stringValue.c_str(), nullptr, 10);
+        }
+    }
+    f64 GetDouble() const
+    {
+        assert(!is_null());
+        switch (_type)
+        {
+            case Type::UNSIGNED: return static_cast<f64>(_unsignedValue);
+            case Type::SIGNED: return static_cast<f64>(_signedValue);
+            case Type::DOUBLE: return _doubleValue;
+            default: return std::strtod(_stringValue.c_str(), nullptr);
+        }
+    }
+
+    Type _type = Type::NONE;
+    union
+    {
+        u64 _unsignedValue = 0;
+        i64 _signedValue;
+        f64 _doubleValue;
+    };
+    std::string _stringValue;
+};
+
+// Rows of typed fields, filled by DatabaseConnector::Query for PreparedStatements
+class PreparedResultSet
+{
+public:
+    class Row
+    {
+    public:
+        Row(const PreparedField* fields, u32 fieldCount) : _fields(fields), _fieldCount(fieldCount) { }
+
+        const PreparedField& operator[](u32 index) const
+        {
+            assert(index < _fieldCount);
+            return _fields[index];
+        }
+        u32 size() const { return _fieldCount; }
+
+    private:
+        const PreparedField* _fields;
+        u32 _fieldCount;
+    };
+
+    class const_iterator
+    {
+    public:
+        const_iterator(const PreparedResultSet* resultSet, size_t row) : _resultSet(resultSet), _row(row) { }
+
+        Row operator*() const { return (*_resultSet)[_row]; }
+        const_iterator& operator++() { _row++; return *this; }
+        bool operator==(const const_iterator& other) const { return _row == other._row; }
+        bool operator!=(const const_iterator& other) const { return _row != other._row; }
+
+    private:
+        const PreparedResultSet* _resultSet;
+        size_t _row;
+    };
+
+    Row operator[](size_t index) const
+    {
+        assert(index < _rowCount);
+        return Row(&_fields[index * _fieldCount], _fieldCount);
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _rowCount); }
+
+    size_t size() const { return _rowCount; }
+    bool empty() const { return _rowCount == 0; }
+    u32 field_count() const { return _fieldCount; }
+
+    // Matches amy::result_set, this is the number of returned rows for SELECT statements
+    u64 affected_rows() const { return _affectedRows; }
+
+    void clear()
+    {
+        _fields.clear();
+        _fieldCount = 0;
+        _rowCount = 0;
+        _affectedRows = 0;
+    }
+
+private:
+    friend class DatabaseConnector;
+
+    std::vector<PreparedField> _fields;
+    u32 _fieldCount = 0;
+    size_t _rowCount = 0;
+    u64 _affectedRows = 0;
+};
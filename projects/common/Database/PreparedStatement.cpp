@@ -3,186 +3,127 @@
 #include <cassert>
 #include <iostream>
 
-PreparedStatement::PreparedStatement(std::string statement)
+PreparedStatement::PreparedStatement(std::string statement, bool isOneOff)
 {
 	_statement = statement;
-}
+    _isOneOff = isOneOff;
 
-PreparedStatement& PreparedStatement::Bind(std::string value)
-{
-	size_t replacePos = _statement.find("{s}");
+    // Hash the template while looking for tokens, the hash doubles as the statement id
+    u32 hash = 2166136261u;
+    for (size_t i = 0; i < _statement.size(); i++)
+    {
+        hash = (hash ^ static_cast<u8>(_statement[i])) * 16777619u;
 
-	if (value.find("'") != 0)
-		value = "'" + value;
+        if (_statement[i] != '{' || i + 2 >= _statement.size() || _statement[i + 2] != '}')
+            continue;
 
-	if (value.find_last_of("'") != value.length() - 1)
-		value += "'";
+        char type = _statement[i + 1];
+        if (type == 's' || type == 'i' || type == 'u' || type == 'f' || type == 'd')
+        {
+            _tokens.push_back({ i, type, false });
+        }
+    }
 
-	if (replacePos != std::string::npos)
-	{
-		_statement.replace(replacePos, 3, value);
-	}
-	else
-	{
-		std::cout << "Error: Could not find token {s} in statement: " << _statement << std::endl;
-		assert(false);
-	}
-	
-	return *this;
+    _id = hash;
+    _parameters.resize(_tokens.size());
 }
 
-PreparedStatement& PreparedStatement::Bind(u8 value)
+PreparedStatement& PreparedStatement::BindParameter(char token, PreparedParameter& parameter)
 {
-    size_t replacePos = _statement.find("{u}");
-
-    if (replacePos != std::string::npos)
-    {
-        _statement.replace(replacePos, 3, std::to_string(value));
-    }
-    else
+    // Like the old find and replace, a value fills the first unbound token of its type
+    for (size_t i = 0; i < _tokens.size(); i++)
     {
-        std::cout << "Error: Could not find token {u} in statement: " << _statement << std::endl;
-        assert(false);
+        if (_tokens[i].type == token && !_tokens[i].isBound)
+        {
+            _tokens[i].isBound = true;
+            _parameters[i] = std::move(parameter);
+            return *this;
+        }
     }
 
+    std::cout << "Error: Could not find token {" << token << "} in statement: " << _statement << std::endl;
+    assert(false);
+
     return *this;
 }
 
-PreparedStatement& PreparedStatement::Bind(u16 value)
+PreparedStatement& PreparedStatement::Bind(std::string value)
 {
-    size_t replacePos = _statement.find("{u}");
-
-    if (replacePos != std::string::npos)
-    {
-        _statement.replace(replacePos, 3, std::to_string(value));
-    }
-    else
-    {
-        std::cout << "Error: Could not find token {u} in statement: " << _statement << std::endl;
-        assert(false);
-    }
+    PreparedParameter parameter;
+    parameter.type = PreparedParameterType::STRING;
+    parameter.stringValue = std::move(value);
 
-    return *this;
+    return BindParameter('s', parameter);
 }
 
-PreparedStatement& PreparedStatement::Bind(i16 value)
+PreparedStatement& PreparedStatement::Bind(u8 value)
 {
-    size_t replacePos = _statement.find("{i}");
-
-    if (replacePos != std::string::npos)
-    {
-        _statement.replace(replacePos, 3, std::to_string(value));
-    }
-    else
-    {
-        std::cout << "Error: Could not find token {i} in statement: " << _statement << std::endl;
-        assert(false);
-    }
-
-    return *this;
+    return Bind(static_cast<u64>(value));
 }
 
-PreparedStatement& PreparedStatement::Bind(i32 value)
+PreparedStatement& PreparedStatement::Bind(u16 value)
 {
-	size_t replacePos = _statement.find("{i}");
-
-	if (replacePos != std::string::npos)
-	{
-		_statement.replace(replacePos, 3, std::to_string(value));
-	}
-	else
-	{
-		std::cout << "Error: Could not find token {i} in statement: " << _statement << std::endl;
-		assert(false);
-	}
+    return Bind(static_cast<u64>(value));
+}
 
-	return *this;
+PreparedStatement& PreparedStatement::Bind(i16 value)
+{
+    return Bind(static_cast<i32>(value));
 }
 
 PreparedStatement& PreparedStatement::Bind(u32 value)
 {
-    size_t replacePos = _statement.find("{u}");
+    return Bind(static_cast<u64>(value));
+}
 
-    if (replacePos != std::string::npos)
-    {
-        _statement.replace(replacePos, 3, std::to_string(value));
-    }
-    else
-    {
-        std::cout << "Error: Could not find token {u} in statement: " << _statement << std::endl;
-        assert(false);
-    }
+PreparedStatement& PreparedStatement::Bind(i32 value)
+{
+    PreparedParameter parameter;
+    parameter.type = PreparedParameterType::SIGNED;
+    parameter.signedValue = value;
 
-    return *this;
+    return BindParameter('i', parameter);
 }
 
 PreparedStatement& PreparedStatement::Bind(f32 value)
 {
-	size_t replacePos = _statement.find("{f}");
+    PreparedParameter parameter;
+    parameter.type = PreparedParameterType::FLOAT;
+    parameter.floatValue = value;
 
-	if (replacePos != std::string::npos)
-	{
-		_statement.replace(replacePos, 3, std::to_string(value));
-	}
-	else
-	{
-		std::cout << "Error: Could not find token {f} in statement: " << _statement << std::endl;
-		assert(false);
-	}
-
-	return *this;
+    return BindParameter('f', parameter);
 }
 
 PreparedStatement& PreparedStatement::Bind(f64 value)
 {
-	size_t replacePos = _statement.find("{d}");
-
-	if (replacePos != std::string::npos)
-	{
-		_statement.replace(replacePos, 3, std::to_string(value));
-	}
-	else
-	{
-		std::cout << "Error: Could not find token {d} in statement: " << _statement << std::endl;
-		assert(false);
-	}
+    PreparedParameter parameter;
+    parameter.type = PreparedParameterType::DOUBLE;
+    parameter.doubleValue = value;
 
-	return *this;
+    return BindParameter('d', parameter);
 }
 
 PreparedStatement& PreparedStatement::Bind(u64 value)
 {
-    size_t replacePos = _statement.find("{u}");
+    PreparedParameter parameter;
+    parameter.type = PreparedParameterType::UNSIGNED;
+    parameter.unsignedValue = value;
 
-    if (replacePos != std::string::npos)
-    {
-        _statement.replace(replacePos, 3, std::to_string(value));
-    }
-    else
-    {
-        std::cout << "Error: Could not find token {u} in statement: " << _statement << std::endl;
-        assert(false);
-    }
-
-    return *this;
+    return BindParameter('u', parameter);
 }
 
-bool PreparedStatement::Verify()
+bool PreparedStatement::Verify() const
 {
-	size_t pos = _statement.find("{s}");
-	if (pos == std::string::npos)
-		pos = _statement.find("{i}");
-	if (pos == std::string::npos)
-		pos = _statement.find("{u}");
-	if (pos == std::string::npos)
-		pos = _statement.find("{f}");
-	if (pos == std::string::npos)
-		pos = _statement.find("{d}");
-
-	return pos == std::string::npos;
+    for (const Token& token : _tokens)
+    {
+        if (!token.isBound)
+            return false;
+    }
+
+	return true;
 }
 
-std::string PreparedStatement::Get()
+std::string PreparedStatement::Get() const
 {
 	if (!Verify())
 	{
@@ -190,5 +131,69 @@ std::string PreparedStatement::Get()
 		assert(false);
 	}
 
-	return _statement;
-}
\ No newline at end of file
+    std::string statement;
+    statement.reserve(_statement.size() + _tokens.size() * 8);
+
+    size_t position = 0;
+    for (size_t i = 0; i < _tokens.size(); i++)
+    {
+        statement.append(_statement, position, _tokens[i].position - position);
+        position = _tokens[i].position + 3;
+
+        if (!_tokens[i].isBound)
+        {
+            statement.append(_statement, _tokens[i].position, 3);
+            continue;
+        }
+
+        const PreparedParameter& parameter = _parameters[i];
+        switch (parameter.type)
+        {
+            case PreparedParameterType::STRING:
+            {
+                const std::string& value = parameter.stringValue;
+
+                if (value.find("'") != 0)
+                    statement += "'";
+
+                statement += value;
+
+                if (value.empty() || value.find_last_of("'") != value.length() - 1)
+                    statement += "'";
+                break;
+            }
+            case PreparedParameterType::SIGNED:
+                statement += std::to_string(parameter.signedValue);
+                break;
+            case PreparedParameterType::UNSIGNED:
+                statement += std::to_string(parameter.unsignedValue);
+                break;
+            case PreparedParameterType::FLOAT:
+                statement += std::to_string(parameter.floatValue);
+                break;
+            case PreparedParameterType::DOUBLE:
+                statement += std::to_string(parameter.doubleValue);
+                break;
+        }
+    }
+    statement.append(_statement, position, std::string::npos);
+
+	return statement;
+}
+
+std::string PreparedStatement::GetParameterizedSql() const
+{
+    std::string sql;
+    sql.reserve(_statement.size());
+
+    size_t position = 0;
+    for (const Token& token : _tokens)
+    {
+        sql.append(_statement, position, token.position - position);
+        sql += '?';
+        position = token.position + 3;
+    }
+    sql.append(_statement, position, std::string::npos);
+
+    return sql;
+}
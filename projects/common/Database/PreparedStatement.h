@@ -24,6 +24,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "../NovusTypes.h"
 
 // Valid type/tokens
@@ -33,10 +34,33 @@
 // {f} - f32
 // {d} - f64
 
+enum class PreparedParameterType : u8
+{
+    STRING,
+    SIGNED,
+    UNSIGNED,
+    FLOAT,
+    DOUBLE
+};
+
+struct PreparedParameter
+{
+    PreparedParameterType type = PreparedParameterType::UNSIGNED;
+    union
+    {
+        i64 signedValue;
+        u64 unsignedValue = 0;
+        f32 floatValue;
+        f64 doubleValue;
+    };
+    std::string stringValue;
+};
+
 class PreparedStatement
 {
 public:
-	PreparedStatement(std::string statement);
+    // One-off statements have SQL that changes between uses, like a spliced in list, they always go over the text protocol instead of taking a cache slot
+	PreparedStatement(std::string statement, bool isOneOff = false);
 
     PreparedStatement& Bind(std::string value);
     PreparedStatement& Bind(u8 value);
@@ -48,9 +72,36 @@ public:
 	PreparedStatement& Bind(f64 value);
     PreparedStatement& Bind(u64 value);
 
-	bool Verify();
-	std::string Get();
+	bool Verify() const;
+
+    // Returns the statement with every token replaced by its value, for the text protocol
+	std::string Get() const;
+
+    // Returns the statement with every token replaced by a ? placeholder, for server side prepared statements
+    std::string GetParameterizedSql() const;
+
+    const std::string& GetTemplate() const { return _statement; }
+
+    // Identifies the statement template, connectors cache their server side statement under this id
+    u32 GetId() const { return _id; }
+    bool IsOneOff() const { return _isOneOff; }
+
+    // Parameters are stored in placeholder order, no matter which order they were bound in
+    const std::vector<PreparedParameter>& GetParameters() const { return _parameters; }
 
 private:
+    PreparedStatement& BindParameter(char token, PreparedParameter& parameter);
+
+    struct Token
+    {
+        size_t position;
+        char type;
+        bool isBound;
+    };
+
 	std::string _statement;
+    std::vector<Token> _tokens;
+    std::vector<PreparedParameter> _parameters;
+    u32 _id;
+    bool _isOneOff;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <functional>
+#include "../Utils/ConcurrentQueue.h"
+
+// Receives a finished database callback and decides which thread runs it
+using SQLCallbackDispatcher = std::function<void(std::function<void()>&& callback)>;
+
+// Holds database callbacks for a thread that polls for them, like the world tick, instead of letting them run on the SQL workers
+class SQLCallbackQueue
+{
+public:
+    SQLCallbackDispatcher GetDispatcher()
+    {
+        return [this](std::function<void()>&& callback) { _callbacks.enqueue(std::move(callback)); };
+    }
+
+    // Runs every queued callback on the calling thread
+    size_t Run()
+    {
+        size_t count = 0;
+
+        std::function<void()> callback;
+        while (_callbacks.try_dequeue(callback))
+        {
+            callback();
+            count++;
+        }
+
+        return count;
+    }
+
+private:
+    moodycamel::ConcurrentQueue<std::function<void()>> _callbacks;
+};
@@ -27,18 +27,66 @@
 #include <iostream>
 #include <string>
 #include <functional>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
 #include <asio.hpp>
 #include <asio/placeholders.hpp>
 #include "ByteBuffer.h"
+#include "PacketPool.h"
 #include "DataStore.h"
 
 namespace Common
 {
+    struct SocketSendStats
+    {
+        std::atomic<u64> packetsQueued = 0; // Number of calls to Send
+        std::atomic<u64> bytesQueued = 0;
+        std::atomic<u64> bytesSent = 0;
+        std::atomic<u64> writeCalls = 0; // Number of async_write_some calls issued, each one being a single gathered write
+        std::atomic<u64> partialWrites = 0; // Number of writes that had to be resumed
+        std::atomic<u64> packetsCoalesced = 0; // Packets superseded by a newer one while the peer was backpressured
+        std::atomic<u64> stallDisconnects = 0;
+        std::atomic<u64> overflowDisconnects = 0; // Closed for queueing past the hard send ceiling
+        std::atomic<u64> sharedPayloadBytes = 0; // Bytes written straight from payloads shared with other sockets instead of copied in
+    };
+
+    // A range of a slab waiting to be written, shared payloads are referenced by every socket sending them rather than copied
+    struct SendSegment
+    {
+        PacketHandle buffer;
+        size_t offset;
+        size_t size;
+    };
+
     class BaseSocket : public std::enable_shared_from_this<BaseSocket>
     {
     public:
         virtual bool Start() = 0;
-        virtual void Close(asio::error_code error) { _socket->close(); _isClosed = true; std::cout << "Closed: " << error.message().c_str() << std::endl; }
+        virtual ~BaseSocket() { delete _socket; }
+
+        virtual void Close(asio::error_code error)
+        {
+            if (_isClosed.exchange(true))
+                return;
+
+            {
+                // The pending wait holds a reference to the socket, don't keep it alive until the stall timeout
+                std::lock_guard<std::mutex> lock(_sendMutex);
+                _isSendStalled = false;
+                _sendStallTimer.cancel();
+            }
+
+            asio::error_code closeError;
+            _socket->close(closeError);
+            std::cout << "Closed: " << error.message().c_str() << std::endl;
+
+            // Lets the owner drop its reference, the socket itself is freed once its last pending handler has run
+            if (_closeCallback)
+                _closeCallback();
+        }
         virtual void HandleRead() = 0;
 
         asio::ip::tcp::socket* socket()
@@ -46,25 +94,55 @@ namespace Common
             return _socket;
         }
 
+        // Hands work to the io_service this socket is pinned to, so it never runs alongside the socket's own handlers
+        std::function<void(std::function<void()>&&)> GetDispatcher()
+        {
+            auto executor = _socket->get_executor();
+            return [executor](std::function<void()>&& callback) { asio::post(executor, std::move(callback)); };
+        }
+
         void Send(DataStore& dataStore)
         {
             if (!dataStore.IsEmpty())
             {
-                _socket->async_write_some(asio::buffer(dataStore.GetInternalData(), dataStore.WrittenData),
-                    std::bind(&BaseSocket::HandleInternalWrite, this, std::placeholders::_1, std::placeholders::_2));
+                QueueSend(dataStore.GetInternalData(), dataStore.WrittenData);
             }
         }
         void Send(ByteBuffer& buffer)
         {
             if (!buffer.empty())
             {
-                _socket->async_write_some(asio::buffer(buffer.GetReadPointer(), buffer.GetActualSize()),
-                   std::bind(&BaseSocket::HandleInternalWrite, this, std::placeholders::_1, std::placeholders::_2));
+                QueueSend(buffer.GetReadPointer(), buffer.GetActualSize());
             }
         }
         bool IsClosed() { return _isClosed; }
+        void SetCloseCallback(std::function<void()> callback) { _closeCallback = callback; }
+
+        // Once more than highWaterMark bytes are waiting to be written the socket counts as backpressured, staying that way for longer than stallTimeout closes it.
+        // Queueing a packet that would take it past maxPendingBytes closes it straight away, zero disables either limit
+        void SetSendLimits(size_t highWaterMark, size_t maxPendingBytes, std::chrono::milliseconds stallTimeout)
+        {
+            _sendHighWaterMark = highWaterMark;
+            _sendMaxPendingBytes = maxPendingBytes;
+            _sendStallTimeout = stallTimeout;
+        }
+        size_t GetPendingSendBytes() const { return _sendPendingBytes; }
+        bool IsSendBackpressured() const { return _sendHighWaterMark > 0 && _sendPendingBytes > _sendHighWaterMark; }
+
+        const SocketSendStats& GetSendStats() const { return _sendStats; }
+        static SocketSendStats& GetGlobalSendStats()
+        {
+            static SocketSendStats globalSendStats;
+            return globalSendStats;
+        }
+        // Outbound bytes live in slabs from this pool, payloads that are encoded once and sent to many sockets should be built in one as well
+        static PacketPool& GetSendPool()
+        {
+            static PacketPool sendPool;
+            return sendPool;
+        }
     protected:
-        BaseSocket(asio::ip::tcp::socket* socket) : _socket(socket), _byteBuffer(), _isClosed(false)
+        BaseSocket(asio::ip::tcp::socket* socket) : _socket(socket), _byteBuffer(), _isClosed(false), _sendQueue(), _sendInFlight(), _sendGather(), _sendInFlightOffset(0), _isWriting(false), _sendPendingBytes(0), _sendHighWaterMark(0), _sendMaxPendingBytes(0), _sendStallTimeout(0), _isSendStalled(false), _sendStallTimer(socket->get_executor().context())
         {
             _byteBuffer.Resize(4096);
         }
@@ -79,7 +157,7 @@ namespace Common
             _byteBuffer.RecalculateSize();
 
             _socket->async_read_some(asio::buffer(_byteBuffer.GetWritePointer(), _byteBuffer.GetSpaceLeft()),
-                std::bind(&BaseSocket::HandleInternalRead, this, std::placeholders::_1, std::placeholders::_2));
+                std::bind(&BaseSocket::HandleInternalRead, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
         }
         void HandleInternalRead(asio::error_code error, size_t bytes)
         {
@@ -93,18 +171,202 @@ namespace Common
             _byteBuffer.WriteBytes(bytes);
             HandleRead();
         }
+        void QueueSend(u8 const* data, size_t size)
+        {
+            if (size == 0)
+                return;
+
+            // The caller's buffer is usually a temporary, so the queue owns a copy of the bytes until they are written
+            SendSegment segment;
+            segment.buffer = GetSendPool().Acquire(0);
+            segment.buffer->Append(data, size);
+            segment.offset = 0;
+            segment.size = size;
+
+            QueueSendSegments(&segment, 1);
+        }
+        // Queues the segments as one packet, their slabs are held until the bytes have been written
+        void QueueSendSegments(SendSegment* segments, size_t count)
+        {
+            size_t size = 0;
+            for (size_t i = 0; i < count; i++)
+                size += segments[i].size;
+
+            if (size == 0)
+                return;
+
+            std::unique_lock<std::mutex> lock(_sendMutex);
+            if (_isClosed)
+                return;
+
+            // Dropping a packet would desync the client, a peer this far behind is closed instead
+            if (_sendMaxPendingBytes > 0 && _sendPendingBytes + size > _sendMaxPendingBytes)
+            {
+                lock.unlock();
+
+                _sendStats.overflowDisconnects++;
+                GetGlobalSendStats().overflowDisconnects++;
+                Close(asio::error::no_buffer_space);
+                return;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (segments[i].size)
+                    _sendQueue.push_back(std::move(segments[i]));
+            }
+            _sendPendingBytes += size;
+
+            _sendStats.packetsQueued++;
+            _sendStats.bytesQueued += size;
+            GetGlobalSendStats().packetsQueued++;
+            GetGlobalSendStats().bytesQueued += size;
+
+            if (!_isSendStalled && IsSendBackpressured())
+                StartSendStall();
+
+            // Only one write may be in flight, packets queued meanwhile are picked up by the next gathered write
+            if (!_isWriting)
+            {
+                _isWriting = true;
+                _sendInFlight.swap(_sendQueue);
+                _sendInFlightOffset = 0;
+                AsyncWrite();
+            }
+        }
+
+        // Must be called with _sendMutex held, the timer closes the socket unless the writes drain below the high water mark first
+        void StartSendStall()
+        {
+            _isSendStalled = true;
+            if (_sendStallTimeout.count() <= 0)
+                return;
+
+            _sendStallTimer.expires_after(_sendStallTimeout);
+            _sendStallTimer.async_wait(std::bind(&BaseSocket::HandleSendStallTimer, shared_from_this(), ++_sendStallGeneration, std::placeholders::_1));
+        }
+        // Must be called with _sendMutex held
+        void StopSendStall()
+        {
+            if (!_isSendStalled)
+                return;
+
+            _isSendStalled = false;
+            _sendStallTimer.cancel();
+        }
+        void HandleSendStallTimer(u32 generation, asio::error_code error)
+        {
+            if (error == asio::error::operation_aborted)
+                return;
+
+            {
+                // A wait that completed just as the stall ended can't be cancelled anymore, it must not close a later stall early
+                std::lock_guard<std::mutex> lock(_sendMutex);
+                if (!_isSendStalled || generation != _sendStallGeneration)
+                    return;
+            }
+
+            _sendStats.stallDisconnects++;
+            GetGlobalSendStats().stallDisconnects++;
+            Close(asio::error::timed_out);
+        }
+
+        // Must be called with _sendMutex held
+        void AsyncWrite()
+        {
+            // Gather everything in flight that has not been written yet, skipping the part of a partial write that already went out
+            _sendGather.clear();
+            size_t skip = _sendInFlightOffset;
+            for (SendSegment& segment : _sendInFlight)
+            {
+                if (skip >= segment.size)
+                {
+                    skip -= segment.size;
+                    continue;
+                }
+
+                _sendGather.push_back(asio::buffer(segment.buffer->GetDataPointer() + segment.offset + skip, segment.size - skip));
+                skip = 0;
+            }
+
+            _sendStats.writeCalls++;
+            GetGlobalSendStats().writeCalls++;
+            _socket->async_write_some(_sendGather, std::bind(&BaseSocket::HandleInternalWrite, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+        }
         void HandleInternalWrite(asio::error_code error, std::size_t transferedBytes)
         {
             if (error)
             {
+                {
+                    std::lock_guard<std::mutex> lock(_sendMutex);
+                    _isWriting = false;
+                    _sendInFlight.clear();
+                    _sendQueue.clear();
+                    _sendPendingBytes = 0;
+                }
+
                 Close(error);
+                return;
+            }
+
+            _sendStats.bytesSent += transferedBytes;
+            GetGlobalSendStats().bytesSent += transferedBytes;
+
+            std::lock_guard<std::mutex> lock(_sendMutex);
+            _sendInFlightOffset += transferedBytes;
+            _sendPendingBytes -= transferedBytes;
+
+            if (!IsSendBackpressured())
+                StopSendStall();
+
+            size_t inFlightSize = 0;
+            for (SendSegment& segment : _sendInFlight)
+                inFlightSize += segment.size;
+
+            if (_sendInFlightOffset < inFlightSize)
+            {
+                _sendStats.partialWrites++;
+                GetGlobalSendStats().partialWrites++;
+                AsyncWrite();
+                return;
             }
+
+            _sendInFlight.clear();
+            _sendInFlightOffset = 0;
+
+            if (_sendQueue.empty() || _isClosed)
+            {
+                _isWriting = false;
+                return;
+            }
+
+            _sendInFlight.swap(_sendQueue);
+            AsyncWrite();
         }
 
         ByteBuffer& GetByteBuffer() { return _byteBuffer; }
         ByteBuffer _byteBuffer;
 
-        bool _isClosed;
+        std::atomic<bool> _isClosed;
         asio::ip::tcp::socket* _socket;
+        std::function<void()> _closeCallback;
+
+        // Outbound queue, _sendQueue collects packets while _sendInFlight is being written
+        std::mutex _sendMutex;
+        std::vector<SendSegment> _sendQueue;
+        std::vector<SendSegment> _sendInFlight;
+        std::vector<asio::const_buffer> _sendGather;
+        size_t _sendInFlightOffset;
+        bool _isWriting;
+        SocketSendStats _sendStats;
+
+        // Bytes queued or in flight that have not been written yet
+        std::atomic<size_t> _sendPendingBytes;
+        size_t _sendHighWaterMark;
+        size_t _sendMaxPendingBytes;
+        std::chrono::milliseconds _sendStallTimeout;
+        bool _isSendStalled;
+        u32 _sendStallGeneration = 0; // Bumped every time the stall timer is armed
+        asio::steady_timer _sendStallTimer;
     };
 }
@@ -24,25 +24,66 @@
 #pragma once
 
 #include "../NovusTypes.h"
-#include <vector>
+#include "ByteBufferPool.h"
 #include <cassert>
 #include <cstring>
 #include <string>
+#include <algorithm>
 
 namespace Common
 {
     class ByteBuffer
     {
     public:
-        ByteBuffer() : _readPos(0), _writePos(0)
+        // Small packets live in the inline storage, larger ones draw their block from the thread local ByteBufferPool
+        static constexpr size_t InlineCapacity = 128;
+
+        ByteBuffer() : _readPos(0), _writePos(0), _data(_inlineData), _size(0), _capacity(InlineCapacity) { }
+        ByteBuffer(size_t reserveSize) : _readPos(0), _writePos(0), _data(_inlineData), _size(0), _capacity(InlineCapacity)
+        {
+            Reserve(reserveSize);
+        }
+        ByteBuffer(const ByteBuffer& other) : _readPos(other._readPos), _writePos(other._writePos), _data(_inlineData), _size(0), _capacity(InlineCapacity)
+        {
+            Reserve(other._size);
+            if (other._size)
+                std::memcpy(_data, other._data, other._size);
+            _size = other._size;
+        }
+        ByteBuffer(ByteBuffer&& other) noexcept : _readPos(other._readPos), _writePos(other._writePos), _data(_inlineData), _size(0), _capacity(InlineCapacity)
         {
-            _bufferData.reserve(4096);
+            Steal(other);
         }
-        ByteBuffer(size_t reserveSize) : _readPos(0), _writePos(0)
+        virtual ~ByteBuffer()
         {
-            _bufferData.reserve(reserveSize);
+            FreeStorage();
+        }
+
+        ByteBuffer& operator=(const ByteBuffer& other)
+        {
+            if (this != &other)
+            {
+                _size = 0;
+                Reserve(other._size);
+                if (other._size)
+                    std::memcpy(_data, other._data, other._size);
+                _size = other._size;
+                _readPos = other._readPos;
+                _writePos = other._writePos;
+            }
+            return *this;
+        }
+        ByteBuffer& operator=(ByteBuffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                FreeStorage();
+                _readPos = other._readPos;
+                _writePos = other._writePos;
+                Steal(other);
+            }
+            return *this;
         }
-        virtual ~ByteBuffer() { }
 
         void ReadPackedGUID(u64& guid)
         {
@@ -65,17 +106,17 @@ namespace Common
         template <typename T>
         void Read(T& destination)
         {
-            destination = *(reinterpret_cast<T const*>(&_bufferData[_readPos]));
+            destination = *(reinterpret_cast<T const*>(&_data[_readPos]));
             _readPos += sizeof(T);
         }
         template <typename T>
         T ReadAt(size_t position)
         {
-            return *(reinterpret_cast<T const*>(&_bufferData[position]));
+            return *(reinterpret_cast<T const*>(&_data[position]));
         }
         void Read(void* destination, size_t length)
         {
-            memcpy(destination, &_bufferData[_readPos], length);
+            memcpy(destination, &_data[_readPos], length);
             _readPos += length;
         }
         void Read(std::string& value)
@@ -97,7 +138,7 @@ namespace Common
         }
         char Read(size_t position)
         {
-            char val = *(reinterpret_cast<char const*>(&_bufferData[position]));
+            char val = *(reinterpret_cast<char const*>(&_data[position]));
             return val;
         }
 
@@ -111,7 +152,7 @@ namespace Common
         {
             if (size)
             {
-                std::memcpy(&_bufferData[_writePos], data, size);
+                std::memcpy(&_data[_writePos], data, size);
                 WriteBytes(size);
             }
         }
@@ -123,8 +164,8 @@ namespace Common
         template <typename T>
         void WriteAt(T const value, size_t position)
         {
-            assert(_bufferData.size() > position);
-            std::memcpy(&_bufferData[position], reinterpret_cast<const u8*>(&value), sizeof(T));
+            assert(_size > position);
+            std::memcpy(&_data[position], reinterpret_cast<const u8*>(&value), sizeof(T));
         }
 
         template <typename T>
@@ -134,7 +175,7 @@ namespace Common
         }
         void _replace(size_t position, u8 const* src, size_t content)
         {
-            std::memcpy(&_bufferData[position], src, content);
+            std::memcpy(&_data[position], src, content);
         }
 
         void Append(ByteBuffer const& buffer)
@@ -165,25 +206,21 @@ namespace Common
         }
 
         void Append(u8 const* value, size_t size)
+        {
+            std::memcpy(PrepareWrite(size), value, size);
+        }
+        // Makes room for size bytes at the write position and moves past them, the caller fills in the returned region
+        u8* PrepareWrite(size_t size)
         {
             size_t const newSize = _writePos + size;
-            if (_bufferData.capacity() < newSize)
-            {
-                if (newSize < 100)
-                    _bufferData.reserve(300);
-                else if (newSize < 750)
-                    _bufferData.reserve(2500);
-                else if (newSize < 6000)
-                    _bufferData.reserve(10000);
-                else
-                    _bufferData.reserve(400000);
-            }
-
-            if (_bufferData.size() < newSize)
-                _bufferData.resize(newSize);
+            // Grows geometrically, the bytes are overwritten right away so there is no need to zero them
+            Reserve(newSize);
+            if (_size < newSize)
+                _size = newSize;
 
-            std::memcpy(&_bufferData[_writePos], value, size);
+            u8* region = &_data[_writePos];
             _writePos = newSize;
+            return region;
         }
         void ResetPos()
         {
@@ -195,19 +232,36 @@ namespace Common
         {
             _readPos = 0;
             _writePos = 0;
-            _bufferData.clear();
+            _size = 0;
         }
         void Resize(size_t newSize)
         {
-            _bufferData.resize(newSize);
+            Reserve(newSize);
+            if (newSize > _size)
+                std::memset(_data + _size, 0, newSize - _size);
+            _size = newSize;
+        }
+        void Reserve(size_t newCapacity)
+        {
+            if (newCapacity <= _capacity)
+                return;
+
+            size_t capacity = std::max(newCapacity, _capacity * 2);
+            u8* newData = ByteBufferPool::Allocate(capacity);
+            if (_size)
+                std::memcpy(newData, _data, _size);
+
+            FreeStorage();
+            _data = newData;
+            _capacity = capacity;
         }
         u8* data()
         {
-            return _bufferData.data();
+            return _data;
         }
         u8 const* data() const
         {
-            return _bufferData.data();
+            return _data;
         }
 
         void WriteBytes(size_t size)
@@ -235,20 +289,56 @@ namespace Common
         {
             if (GetSpaceLeft() == 0)
             {
-                _bufferData.resize(static_cast<u64>(_bufferData.size() * 1.5f));
+                Resize(static_cast<size_t>(_size * 1.5f));
             }
         }
 
-        u8* GetDataPointer() { return _bufferData.data(); }
-        u8* GetReadPointer() { return _bufferData.data() + _readPos; }
-        u8* GetWritePointer() { return _bufferData.data() + _writePos; }
+        u8* GetDataPointer() { return _data; }
+        u8* GetReadPointer() { return _data + _readPos; }
+        u8* GetWritePointer() { return _data + _writePos; }
         u32 GetActualSize() { return static_cast<u32>(_writePos - _readPos); }
-        u32 GetSpaceLeft() { return static_cast<u32>(_bufferData.size() - _writePos); }
-        u32 size() const { return static_cast<u32>(_bufferData.size()); }
-        bool empty() const { return _bufferData.empty(); }
+        u32 GetSpaceLeft() { return static_cast<u32>(_size - _writePos); }
+        u32 size() const { return static_cast<u32>(_size); }
+        bool empty() const { return _size == 0; }
 
         size_t _readPos, _writePos;
     private:
-        std::vector<u8> _bufferData;
+        bool IsInline() const { return _data == _inlineData; }
+        void FreeStorage()
+        {
+            if (!IsInline())
+                ByteBufferPool::Free(_data, _capacity);
+
+            _data = _inlineData;
+            _capacity = InlineCapacity;
+        }
+        // Takes over other's heap block or copies its inline bytes, other is left empty
+        void Steal(ByteBuffer& other)
+        {
+            if (other.IsInline())
+            {
+                if (other._size)
+                    std::memcpy(_inlineData, other._inlineData, other._size);
+                _data = _inlineData;
+                _capacity = InlineCapacity;
+            }
+            else
+            {
+                _data = other._data;
+                _capacity = other._capacity;
+                other._data = other._inlineData;
+                other._capacity = InlineCapacity;
+            }
+
+            _size = other._size;
+            other._size = 0;
+            other._readPos = 0;
+            other._writePos = 0;
+        }
+
+        u8* _data;
+        size_t _size;
+        size_t _capacity;
+        u8 _inlineData[InlineCapacity];
     };
 }
@@ -0,0 +1,139 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Common
+{
+    // Thread local size class pools backing the heap storage of ByteBuffer, blocks are kept by whichever thread frees them
+    namespace ByteBufferPool
+    {
+        constexpr size_t MinBlockSize = 256;
+        constexpr size_t NumSizeClasses = 9; // 256 bytes up to 64 KB, anything larger goes straight to the heap
+        constexpr size_t MaxFreeBlocksPerClass = 64;
+
+        struct PoolStats
+        {
+            std::atomic<u64> heapAllocations = 0;
+            std::atomic<u64> pooledAllocations = 0;
+        };
+        inline PoolStats& GetStats()
+        {
+            static PoolStats stats;
+            return stats;
+        }
+
+        enum ThreadCacheState : u8
+        {
+            THREAD_CACHE_UNUSED,
+            THREAD_CACHE_ALIVE,
+            THREAD_CACHE_DESTROYED
+        };
+        // Buffers owned by statics can be freed after the thread local cache is gone, they then bypass the pool
+        inline ThreadCacheState& GetThreadCacheState()
+        {
+            thread_local ThreadCacheState state = THREAD_CACHE_UNUSED;
+            return state;
+        }
+
+        struct ThreadCache
+        {
+            ThreadCache() { GetThreadCacheState() = THREAD_CACHE_ALIVE; }
+            ~ThreadCache()
+            {
+                GetThreadCacheState() = THREAD_CACHE_DESTROYED;
+
+                for (std::vector<u8*>& sizeClassBlocks : freeBlocks)
+                {
+                    for (u8* block : sizeClassBlocks)
+                        delete[] block;
+                }
+            }
+
+            std::vector<u8*> freeBlocks[NumSizeClasses];
+        };
+        inline ThreadCache& GetThreadCache()
+        {
+            thread_local ThreadCache cache;
+            return cache;
+        }
+
+        inline size_t GetSizeClass(size_t size)
+        {
+            size_t sizeClass = 0;
+            size_t blockSize = MinBlockSize;
+            while (blockSize < size && sizeClass < NumSizeClasses)
+            {
+                blockSize <<= 1;
+                sizeClass++;
+            }
+            return sizeClass;
+        }
+
+        // Rounds capacity up to the block size that was actually handed out
+        inline u8* Allocate(size_t& capacity)
+        {
+            size_t sizeClass = GetSizeClass(capacity);
+            if (sizeClass >= NumSizeClasses || GetThreadCacheState() == THREAD_CACHE_DESTROYED)
+            {
+                GetStats().heapAllocations++;
+                return new u8[capacity];
+            }
+
+            capacity = MinBlockSize << sizeClass;
+
+            std::vector<u8*>& freeBlocks = GetThreadCache().freeBlocks[sizeClass];
+            if (!freeBlocks.empty())
+            {
+                u8* block = freeBlocks.back();
+                freeBlocks.pop_back();
+
+                GetStats().pooledAllocations++;
+                return block;
+            }
+
+            GetStats().heapAllocations++;
+            return new u8[capacity];
+        }
+        inline void Free(u8* block, size_t capacity)
+        {
+            size_t sizeClass = GetSizeClass(capacity);
+            if (sizeClass < NumSizeClasses && capacity == (MinBlockSize << sizeClass) && GetThreadCacheState() != THREAD_CACHE_DESTROYED)
+            {
+                std::vector<u8*>& freeBlocks = GetThreadCache().freeBlocks[sizeClass];
+                if (freeBlocks.size() < MaxFreeBlocksPerClass)
+                {
+                    freeBlocks.push_back(block);
+                    return;
+                }
+            }
+
+            delete[] block;
+        }
+    }
+}
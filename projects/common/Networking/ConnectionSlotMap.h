@@ -0,0 +1,121 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Common
+{
+    class BaseSocket;
+
+    struct ConnectionHandle
+    {
+        u32 index = 0;
+        u32 generation = 0;
+    };
+
+    // Generation indexed slots for live connections, a freed slot bumps its generation so stale handles never match a newer connection
+    class ConnectionSlotMap
+    {
+    public:
+        ConnectionSlotMap() : _liveCount(0) { }
+
+        ConnectionHandle Insert(std::shared_ptr<BaseSocket> connection)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            u32 index;
+            if (!_freeSlots.empty())
+            {
+                index = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            else
+            {
+                index = static_cast<u32>(_slots.size());
+                _slots.emplace_back();
+            }
+
+            Slot& slot = _slots[index];
+            slot.connection = std::move(connection);
+            _liveCount++;
+
+            return ConnectionHandle{ index, slot.generation };
+        }
+
+        bool Remove(ConnectionHandle handle)
+        {
+            // Dropping the last reference destroys the connection, so make sure that happens outside of the lock
+            std::shared_ptr<BaseSocket> removedConnection;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (handle.index >= _slots.size())
+                    return false;
+
+                Slot& slot = _slots[handle.index];
+                if (slot.generation != handle.generation || !slot.connection)
+                    return false;
+
+                removedConnection = std::move(slot.connection);
+                slot.connection = nullptr;
+                slot.generation++;
+                _freeSlots.push_back(handle.index);
+                _liveCount--;
+            }
+
+            return true;
+        }
+
+        std::shared_ptr<BaseSocket> Get(ConnectionHandle handle)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (handle.index >= _slots.size())
+                return nullptr;
+
+            Slot& slot = _slots[handle.index];
+            if (slot.generation != handle.generation)
+                return nullptr;
+
+            return slot.connection;
+        }
+
+        u32 GetLiveCount() const { return _liveCount.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot
+        {
+            std::shared_ptr<BaseSocket> connection;
+            u32 generation = 0;
+        };
+
+        std::vector<Slot> _slots;
+        std::vector<u32> _freeSlots;
+        std::mutex _mutex;
+        std::atomic<u32> _liveCount;
+    };
+}
@@ -0,0 +1,91 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include <asio.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Common
+{
+    // A pool of single threaded io_services, each connection is pinned to one of them so its handlers never run concurrently
+    class IoServicePool
+    {
+    public:
+        IoServicePool(size_t threadCount) : _nextIoService(0)
+        {
+            if (threadCount == 0)
+                threadCount = 1;
+
+            for (size_t i = 0; i < threadCount; i++)
+            {
+                std::unique_ptr<asio::io_service> ioService = std::make_unique<asio::io_service>(1);
+                _works.push_back(std::make_unique<asio::io_service::work>(*ioService));
+                _ioServices.push_back(std::move(ioService));
+            }
+        }
+        ~IoServicePool()
+        {
+            Stop();
+        }
+
+        void Run()
+        {
+            for (size_t i = 0; i < _ioServices.size(); i++)
+            {
+                asio::io_service* ioService = _ioServices[i].get();
+                _threads.push_back(std::thread([ioService]()
+                {
+                    ioService->run();
+                }));
+            }
+        }
+        void Stop()
+        {
+            _works.clear();
+            for (std::unique_ptr<asio::io_service>& ioService : _ioServices)
+                ioService->stop();
+
+            for (std::thread& thread : _threads)
+            {
+                if (thread.joinable())
+                    thread.join();
+            }
+            _threads.clear();
+        }
+
+        asio::io_service& GetIoService(size_t index) { return *_ioServices[index % _ioServices.size()]; }
+        asio::io_service& GetNextIoService() { return GetIoService(_nextIoService++); }
+        size_t GetSize() const { return _ioServices.size(); }
+
+    private:
+        std::vector<std::unique_ptr<asio::io_service>> _ioServices;
+        std::vector<std::unique_ptr<asio::io_service::work>> _works;
+        std::vector<std::thread> _threads;
+        std::atomic<size_t> _nextIoService;
+    };
+}
@@ -0,0 +1,62 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../../NovusTypes.h"
+#include "Opcode.h"
+#include <array>
+
+namespace Common
+{
+    enum OpcodeThread : u8
+    {
+        OPCODE_THREAD_NONE = 0, // No handler, the packet is dropped once it has been read
+        OPCODE_THREAD_NETWORK = 1, // Handled by the connection on the io thread that read it
+        OPCODE_THREAD_TICK = 2 // Forwarded to the world tick
+    };
+
+    enum OpcodeCost : u8
+    {
+        OPCODE_COST_LOW = 0,
+        OPCODE_COST_MEDIUM = 1,
+        OPCODE_COST_HIGH = 2,
+        OPCODE_COST_COUNT
+    };
+
+    template <typename Handler>
+    struct OpcodeHandler
+    {
+        OpcodeThread thread = OPCODE_THREAD_NONE;
+        OpcodeCost cost = OPCODE_COST_LOW;
+        u16 minSize = 0; // Payload size, the opcode itself is not included
+        u16 maxSize = 0;
+        Handler handler = nullptr;
+
+        bool IsValidSize(size_t size) const { return size >= minSize && size <= maxSize; }
+    };
+
+    // Indexed directly by opcode, callers make sure the opcode is below NUM_MSG_TYPES before looking it up
+    template <typename Handler>
+    using OpcodeTable = std::array<OpcodeHandler<Handler>, Opcode::NUM_MSG_TYPES>;
+}
@@ -0,0 +1,153 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include "../Utils/ConcurrentQueue.h"
+#include "ByteBuffer.h"
+#include <atomic>
+
+namespace Common
+{
+    class PacketPool;
+
+    // A ByteBuffer owned by a PacketPool, the reference count is intrusive so handing a slab around never allocates
+    class PacketSlab : public ByteBuffer
+    {
+    public:
+        PacketSlab(PacketPool* pool) : ByteBuffer(), _refCount(0), _pool(pool) { }
+
+    private:
+        friend class PacketHandle;
+        friend class PacketPool;
+
+        std::atomic<u32> _refCount;
+        PacketPool* _pool;
+    };
+
+    // Reference counted handle to a PacketSlab, the slab goes back to its pool when the last handle lets go of it
+    class PacketHandle
+    {
+    public:
+        PacketHandle() : _slab(nullptr) { }
+        PacketHandle(const PacketHandle& other) : _slab(other._slab) { AddRef(); }
+        PacketHandle(PacketHandle&& other) noexcept : _slab(other._slab) { other._slab = nullptr; }
+        ~PacketHandle() { Reset(); }
+
+        PacketHandle& operator=(const PacketHandle& other)
+        {
+            if (_slab != other._slab)
+            {
+                Reset();
+                _slab = other._slab;
+                AddRef();
+            }
+            return *this;
+        }
+        PacketHandle& operator=(PacketHandle&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                _slab = other._slab;
+                other._slab = nullptr;
+            }
+            return *this;
+        }
+
+        ByteBuffer* operator->() const { return _slab; }
+        ByteBuffer& operator*() const { return *_slab; }
+        ByteBuffer* get() const { return _slab; }
+        explicit operator bool() const { return _slab != nullptr; }
+
+        inline void Reset();
+
+    private:
+        friend class PacketPool;
+        explicit PacketHandle(PacketSlab* slab) : _slab(slab) { AddRef(); }
+
+        void AddRef()
+        {
+            if (_slab)
+                _slab->_refCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        PacketSlab* _slab;
+    };
+
+    class PacketPool
+    {
+    public:
+        PacketPool() : _freeSlabs(256), _slabsAllocated(0), _slabsAcquired(0) { }
+        ~PacketPool()
+        {
+            PacketSlab* slab = nullptr;
+            while (_freeSlabs.try_dequeue(slab))
+                delete slab;
+        }
+
+        // Returns a slab sized to hold exactly size bytes with both positions reset, only allocates when the pool has run dry
+        PacketHandle Acquire(size_t size)
+        {
+            PacketSlab* slab = nullptr;
+            if (!_freeSlabs.try_dequeue(slab))
+            {
+                slab = new PacketSlab(this);
+                _slabsAllocated++;
+            }
+
+            slab->Resize(size);
+            slab->ResetPos();
+            _slabsAcquired++;
+
+            return PacketHandle(slab);
+        }
+
+        u64 GetSlabsAllocated() const { return _slabsAllocated; }
+        u64 GetSlabsAcquired() const { return _slabsAcquired; }
+        size_t GetFreeSlabs() const { return _freeSlabs.size_approx(); }
+
+    private:
+        friend class PacketHandle;
+        void Recycle(PacketSlab* slab)
+        {
+            _freeSlabs.enqueue(slab);
+        }
+
+        moodycamel::ConcurrentQueue<PacketSlab*> _freeSlabs;
+        std::atomic<u64> _slabsAllocated;
+        std::atomic<u64> _slabsAcquired;
+    };
+
+    void PacketHandle::Reset()
+    {
+        if (_slab)
+        {
+            if (_slab->_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                _slab->_pool->Recycle(_slab);
+
+            _slab = nullptr;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include "ByteBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace Common
+{
+    namespace Schema
+    {
+        template <typename MemberPointer>
+        struct MemberType;
+
+        template <typename Class, typename Type>
+        struct MemberType<Type Class::*>
+        {
+            using type = Type;
+        };
+
+        template <auto Member>
+        using MemberTypeOf = typename MemberType<decltype(Member)>::type;
+
+        // Bounded counterparts of ByteBuffer::ReadPackedGUID and ByteBuffer::Read(std::string&) for the variable length parts around a schema
+        inline bool ReadPackedGuid(ByteBuffer& buffer, u64& guid)
+        {
+            if (buffer._readPos >= buffer.size())
+                return false;
+
+            u8 guidMask = buffer.GetDataPointer()[buffer._readPos];
+            size_t guidSize = 1;
+            for (u8 mask = guidMask; mask != 0; mask &= mask - 1)
+                guidSize++;
+
+            if (buffer.size() - buffer._readPos < guidSize)
+                return false;
+
+            buffer.ReadPackedGUID(guid);
+            return true;
+        }
+
+        inline bool ReadString(ByteBuffer& buffer, std::string& value, size_t maxLength)
+        {
+            u8* begin = buffer.GetReadPointer();
+            size_t available = buffer.size() - buffer._readPos;
+            u8* terminator = static_cast<u8*>(std::memchr(begin, 0, std::min(available, maxLength + 1)));
+            if (!terminator)
+                return false;
+
+            value.assign(reinterpret_cast<char*>(begin), terminator - begin);
+            buffer._readPos += (terminator - begin) + 1;
+            return true;
+        }
+    }
+
+    /*
+        Describes a fixed size run of struct members as they appear on the wire, in the order the members are listed:
+
+            typedef Common::PacketSchema<Data, &Data::flags, &Data::x, &Data::y> DataSchema;
+
+        Reading does a single bounds check for the whole run and writing grows the buffer once before copying every field in.
+    */
+    template <typename T, auto... Members>
+    struct PacketSchema
+    {
+        static_assert(sizeof...(Members) > 0, "A schema needs at least one member");
+        static_assert((std::is_trivially_copyable<Schema::MemberTypeOf<Members>>::value && ...), "Schema members are copied as raw bytes");
+
+        static constexpr size_t Size = (sizeof(Schema::MemberTypeOf<Members>) + ...);
+
+        // Leaves both buffer and value untouched when fewer than Size bytes are left to read
+        static bool Read(ByteBuffer& buffer, T& value)
+        {
+            if (buffer.size() < buffer._readPos || buffer.size() - buffer._readPos < Size)
+                return false;
+
+            const u8* source = buffer.GetReadPointer();
+            ((std::memcpy(&(value.*Members), source, sizeof(value.*Members)), source += sizeof(value.*Members)), ...);
+            buffer._readPos += Size;
+            return true;
+        }
+
+        static void Write(ByteBuffer& buffer, const T& value)
+        {
+            u8* destination = buffer.PrepareWrite(Size);
+            ((std::memcpy(destination, &(value.*Members), sizeof(value.*Members)), destination += sizeof(value.*Members)), ...);
+        }
+    };
+}
@@ -24,61 +24,86 @@
 #pragma once
 
 #include <asio.hpp>
+#include <memory>
 #include "BaseSocket.h"
+#include "IoServicePool.h"
+#include "ConnectionSlotMap.h"
 
 namespace Common
 {
-    struct WorkerThread
-    {
-        std::thread _thread;
-        std::mutex _mutex;
-        std::vector<Common::BaseSocket*>* _connections;
-    };
-
-    static void WorkerThreadMain(WorkerThread* thread)
-    {
-        while (true)
-        {
-            thread->_mutex.lock();
-            // Remove closed sessions
-            if (thread->_connections->size() > 0)
-            {
-                thread->_connections->erase(std::remove_if(thread->_connections->begin(), thread->_connections->end(), [](Common::BaseSocket* connection)
-                {
-                    return connection->IsClosed();
-                }), thread->_connections->end());
-            }
-
-            thread->_mutex.unlock();
-            std::this_thread::sleep_for(std::chrono::milliseconds(5000));
-        }
-    }
-
     class TcpServer
     {
     public:
-        TcpServer(asio::io_service& io_service, i32 port) : _acceptor(io_service, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)), _ioService(io_service)
+        TcpServer(IoServicePool& ioServicePool, i32 port, bool reusePort = false) : _ioServicePool(ioServicePool)
         {
-            _workerThread = new WorkerThread();
-            _workerThread->_connections = &_connections;
-            _workerThread->_thread = std::thread(WorkerThreadMain, _workerThread);
+            // With SO_REUSEPORT every shard gets its own acceptor and the kernel spreads incoming connections between them
+            size_t acceptorCount = 1;
+#ifdef SO_REUSEPORT
+            if (reusePort)
+                acceptorCount = ioServicePool.GetSize();
+#else
+            reusePort = false;
+#endif
+
+            asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
+            for (size_t i = 0; i < acceptorCount; i++)
+            {
+                std::unique_ptr<asio::ip::tcp::acceptor> acceptor = std::make_unique<asio::ip::tcp::acceptor>(ioServicePool.GetIoService(i));
+                acceptor->open(endpoint.protocol());
+                acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+                if (reusePort)
+                    acceptor->set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+                acceptor->bind(endpoint);
+                acceptor->listen();
+
+                _acceptors.push_back(std::move(acceptor));
+            }
         }
 
         void Start()
         {
-            StartListening();
+            for (size_t i = 0; i < _acceptors.size(); i++)
+            {
+                StartListening(i);
+            }
         }
         u16 GetPort()
         {
-            return _acceptor.local_endpoint().port();
+            return _acceptors[0]->local_endpoint().port();
+        }
+        u32 GetConnectionCount() const
+        {
+            return _connections.GetLiveCount();
         }
     protected:
-        virtual void StartListening() = 0;
+        void StartListening(size_t acceptorIndex)
+        {
+            // A per shard acceptor keeps its sockets on its own shard, a single acceptor hands them out round robin
+            asio::io_service& ioService = _acceptors.size() > 1 ? _ioServicePool.GetIoService(acceptorIndex) : _ioServicePool.GetNextIoService();
+
+            asio::ip::tcp::socket* socket = new asio::ip::tcp::socket(ioService);
+            _acceptors[acceptorIndex]->async_accept(*socket, [this, socket, acceptorIndex](const asio::error_code& error)
+            {
+                HandleNewConnection(socket, error);
+                StartListening(acceptorIndex);
+            });
+        }
         virtual void HandleNewConnection(asio::ip::tcp::socket* socket, const asio::error_code& error) = 0;
 
-        std::vector<BaseSocket*> _connections;
-        WorkerThread* _workerThread;
-        asio::ip::tcp::acceptor _acceptor;
-        asio::io_service& _ioService;
+        // Registers a freshly accepted connection, it is removed again as soon as it closes
+        void AddConnection(std::shared_ptr<BaseSocket> connection)
+        {
+            ConnectionHandle handle = _connections.Insert(connection);
+            connection->SetCloseCallback([this, handle]()
+            {
+                _connections.Remove(handle);
+            });
+        }
+
+        ConnectionSlotMap _connections;
+        std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> _acceptors;
+        IoServicePool& _ioServicePool;
     };
 }
\ No newline at end of file
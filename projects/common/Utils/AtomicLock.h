@@ -1,5 +1,8 @@
 #pragma once
 #include <atomic>
+#include <cstddef>
+#include <array>
+#include <tuple>
 #include <cassert>
 
 template<typename T>
@@ -19,22 +22,77 @@ std::atomic<i32>& GetReaders()
     static TypeLock<T> typelock;
     return typelock.lock;
 }
+// The address of the writer counter is unique per type, so it doubles as a type key
+template<typename T>
+const void* GetLockKey()
+{
+    return &GetWriters<T>();
+}
+
+// The access a system declared, bound to the thread running it while the system executes
+struct LockScope
+{
+    const void* const* reads;
+    size_t readCount;
+    const void* const* writes;
+    size_t writeCount;
+
+    bool CanWrite(const void* key) const
+    {
+        for (size_t i = 0; i < writeCount; i++)
+        {
+            if (writes[i] == key)
+                return true;
+        }
+        return false;
+    }
+    bool CanRead(const void* key) const
+    {
+        if (CanWrite(key))
+            return true;
+
+        for (size_t i = 0; i < readCount; i++)
+        {
+            if (reads[i] == key)
+                return true;
+        }
+        return false;
+    }
+};
+inline const LockScope*& GetLockScope()
+{
+    thread_local const LockScope* scope = nullptr;
+    return scope;
+}
 
 template<typename T>
 struct WriteLock 
 {
     WriteLock() 
     {
+        // Inside a scope the counters are already held for the whole system, only check that the access was declared
+        if (const LockScope* scope = GetLockScope())
+        {
+            assert(scope->CanWrite(GetLockKey<T>()));
+            return;
+        }
+
         auto writercount = GetWriters<T>().fetch_add(1);
         auto readercount = GetReaders<T>().load();
 
         assert(writercount == 0);
         assert(readercount == 0);
+        counted = true;
     }
     ~WriteLock() 
     {
-        GetWriters<T>()--;
+        if (counted)
+            GetWriters<T>()--;
     }
+    WriteLock(const WriteLock&) = delete;
+    WriteLock& operator=(const WriteLock&) = delete;
+
+    bool counted = false;
 };
 
 template<typename T>
@@ -42,19 +100,94 @@ struct ReadLock
 {
     ReadLock() 
     {
+        if (const LockScope* scope = GetLockScope())
+        {
+            assert(scope->CanRead(GetLockKey<T>()));
+            return;
+        }
+
         auto writercount = GetWriters<T>().load();
         GetReaders<T>()++;
 
         assert(writercount == 0);
+        counted = true;
     }
     ~ReadLock() 
     {
-        GetReaders<T>()--;
+        if (counted)
+            GetReaders<T>()--;
     }
+    ReadLock(const ReadLock&) = delete;
+    ReadLock& operator=(const ReadLock&) = delete;
+
+    bool counted = false;
 };
 
 #define TOKENPASTE(x, y) x ## y
 #define TOKENPASTE2(x, y) TOKENPASTE(x, y)
 
 #define LockWrite(comp) auto  TOKENPASTE2(wmutex, __LINE__) = WriteLock<comp>{};
-#define LockRead(comp) auto  TOKENPASTE2(rmutex, __LINE__) = ReadLock<comp>{};
\ No newline at end of file
+#define LockRead(comp) auto  TOKENPASTE2(rmutex, __LINE__) = ReadLock<comp>{};
+
+/*
+    Systems declare the components and singletons they touch with SystemAccess, the update framework
+    orders them from these declarations and lets everything that doesn't conflict run in parallel.
+    RegistryStorage stands in for the registry itself, read it when iterating a view and write it when creating or
+    destroying entities. The components assigned to or destroyed with those entities have to be declared as written too.
+*/
+struct RegistryStorage {};
+
+template <typename... T>
+struct Reads {};
+template <typename... T>
+struct Writes {};
+
+template <typename ReadList, typename WriteList>
+struct SystemAccess;
+
+template <typename... R, typename... W>
+struct SystemAccess<Reads<R...>, Writes<W...>>
+{
+    static const std::array<const void*, sizeof...(R)>& GetReads()
+    {
+        static const std::array<const void*, sizeof...(R)> reads = { { GetLockKey<R>()... } };
+        return reads;
+    }
+    static const std::array<const void*, sizeof...(W)>& GetWrites()
+    {
+        static const std::array<const void*, sizeof...(W)> writes = { { GetLockKey<W>()... } };
+        return writes;
+    }
+
+    // Holds the counters of every declared type, any overlap the graph should have prevented asserts
+    struct Locks
+    {
+        std::tuple<ReadLock<R>..., WriteLock<W>...> locks;
+    };
+
+    // Binds the declared access to the current thread, so LockRead/LockWrite inside the system only check it
+    struct Scope
+    {
+        Scope()
+        {
+            static const LockScope scope = { GetReads().data(), GetReads().size(), GetWrites().data(), GetWrites().size() };
+            _previousScope = GetLockScope();
+            GetLockScope() = &scope;
+        }
+        ~Scope()
+        {
+            GetLockScope() = _previousScope;
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const LockScope* _previousScope;
+    };
+
+    struct Guard
+    {
+        Locks locks;
+        Scope scope;
+    };
+};
@@ -0,0 +1,95 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+    Bounded lock-free ring for exactly one producer thread and one consumer thread, the capacity is rounded up to a power of two.
+    Each side keeps a cached copy of the other side's index so it only touches the shared cache line when the ring looks full or empty.
+*/
+template <typename T>
+class SPSCQueue
+{
+public:
+    SPSCQueue(size_t capacity) : _slots(RoundUpToPowerOfTwo(capacity)), _mask(_slots.size() - 1), _head(0), _cachedTail(0), _tail(0), _cachedHead(0) { }
+
+    // Producer only, returns false when the ring is full
+    bool TryEnqueue(T&& value)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _cachedTail == _slots.size())
+        {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head - _cachedTail == _slots.size())
+                return false;
+        }
+
+        _slots[head & _mask] = std::move(value);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only, returns false when the ring is empty
+    bool TryDequeue(T& value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _cachedHead)
+        {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail == _cachedHead)
+                return false;
+        }
+
+        value = std::move(_slots[tail & _mask]);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Capacity() const { return _slots.size(); }
+
+private:
+    static size_t RoundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+            result <<= 1;
+
+        return result;
+    }
+
+    std::vector<T> _slots;
+    const size_t _mask;
+
+    // Written by the producer
+    alignas(64) std::atomic<size_t> _head;
+    size_t _cachedTail;
+
+    // Written by the consumer
+    alignas(64) std::atomic<size_t> _tail;
+    size_t _cachedHead;
+};
@@ -9,6 +9,7 @@ class SharedPool
 private:
     struct PoolDeleter
     {
+        PoolDeleter() {}
         explicit PoolDeleter(std::weak_ptr<SharedPool<T>*> pool) : _pool(pool) {}
 
         void operator()(T* ptr)
@@ -51,6 +52,17 @@ public:
         return std::move(tmp);
     }
 
+    bool try_acquire(ptr_type& out)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_pool.empty())
+            return false;
+
+        out = ptr_type(_pool.top().release(), PoolDeleter{std::weak_ptr<SharedPool<T>*>{_thisPtr}});
+        _pool.pop();
+        return true;
+    }
+
     bool empty()
     {
         std::lock_guard<std::mutex> lock(_mutex);
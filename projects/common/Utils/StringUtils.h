@@ -39,6 +39,17 @@ namespace StringUtils
         return escaped;
     }
 
+    // ASCII only, character and channel names never contain anything else
+    inline std::string ToLower(std::string string)
+    {
+        for (char& c : string)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c += 'a' - 'A';
+        }
+        return string;
+    }
+
     template <typename... Args>
     inline i32 FormatString(char* buffer, size_t bufferSize, char const* format, Args... args)
     {
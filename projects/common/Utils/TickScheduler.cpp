@@ -0,0 +1,154 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#include "TickScheduler.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <tracy/Tracy.hpp>
+
+#ifdef __linux__
+#include <time.h>
+#include <errno.h>
+#endif
+
+TickScheduler::TickScheduler(const TickSchedulerSettings& settings)
+    : _settings(settings)
+{
+    _period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(1.0 / std::max(settings.tickRate, 1.0f)));
+    _tickStart = Clock::now();
+    _nextDeadline = _tickStart + _period;
+}
+
+void TickScheduler::Start()
+{
+    _tickStart = Clock::now();
+    _nextDeadline = _tickStart + _period;
+}
+
+void TickScheduler::WaitForNextTick()
+{
+    Clock::time_point workEnd = Clock::now();
+    f32 budgetUsage = std::chrono::duration<f32>(workEnd - _tickStart).count() / std::chrono::duration<f32>(_period).count();
+
+    if (workEnd >= _nextDeadline)
+    {
+        // Whole periods that passed on top of the deadline we missed
+        u64 missedTicks = static_cast<u64>((workEnd - _nextDeadline) / _period);
+
+        if (_settings.overrunPolicy == TICK_OVERRUN_CATCH_UP && missedTicks < _settings.maxCatchUpTicks)
+        {
+            RecordTick(budgetUsage, true, 0);
+            _nextDeadline += _period;
+        }
+        else
+        {
+            RecordTick(budgetUsage, true, missedTicks);
+            _nextDeadline = workEnd + _period;
+        }
+
+        _tickStart = workEnd;
+        return;
+    }
+
+    RecordTick(budgetUsage, false, 0);
+
+    {
+        ZoneScopedNC("Sleep", tracy::Color::AntiqueWhite1)
+        SleepUntil(_nextDeadline - _settings.spinTime);
+    }
+    {
+        ZoneScopedNC("Spin", tracy::Color::AntiqueWhite1)
+        while (Clock::now() < _nextDeadline)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    Clock::time_point wakeTime = Clock::now();
+    RecordJitter(std::chrono::duration<f32, std::micro>(wakeTime - _nextDeadline).count());
+
+    _tickStart = wakeTime;
+    _nextDeadline += _period;
+}
+
+TickStats TickScheduler::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+
+    TickStats stats = _stats;
+    if (_jitterSampleCount > 0)
+    {
+        std::vector<f32> samples(_jitterSamples.begin(), _jitterSamples.begin() + _jitterSampleCount);
+
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        stats.jitterP50 = samples[samples.size() / 2];
+
+        size_t p99Index = (samples.size() * 99) / 100;
+        std::nth_element(samples.begin(), samples.begin() + p99Index, samples.end());
+        stats.jitterP99 = samples[p99Index];
+
+        stats.jitterMax = *std::max_element(samples.begin(), samples.end());
+    }
+
+    return stats;
+}
+
+void TickScheduler::SleepUntil(Clock::time_point deadline)
+{
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC here, sleeping on the absolute deadline means a late wakeup never pushes the next one back
+    std::chrono::nanoseconds sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+
+    timespec deadlineSpec;
+    deadlineSpec.tv_sec = static_cast<time_t>(sinceEpoch.count() / 1000000000);
+    deadlineSpec.tv_nsec = static_cast<long>(sinceEpoch.count() % 1000000000);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadlineSpec, nullptr) == EINTR) { }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+void TickScheduler::RecordTick(f32 budgetUsage, bool overran, u64 skippedTicks)
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+
+    _stats.ticks++;
+    _stats.overruns += overran ? 1 : 0;
+    _stats.skippedTicks += skippedTicks;
+
+    _stats.lastBudgetUsage = budgetUsage;
+    _stats.maxBudgetUsage = std::max(_stats.maxBudgetUsage, budgetUsage);
+    _budgetUsageSum += budgetUsage;
+    _stats.averageBudgetUsage = static_cast<f32>(_budgetUsageSum / _stats.ticks);
+}
+
+void TickScheduler::RecordJitter(f32 jitter)
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+
+    _jitterSamples[_jitterSampleIndex] = jitter;
+    _jitterSampleIndex = (_jitterSampleIndex + 1) % JITTER_SAMPLE_COUNT;
+    _jitterSampleCount = std::min(_jitterSampleCount + 1, JITTER_SAMPLE_COUNT);
+}
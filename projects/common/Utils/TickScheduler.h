@@ -0,0 +1,94 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include "../NovusTypes.h"
+#include <array>
+#include <chrono>
+#include <mutex>
+
+enum TickOverrunPolicy
+{
+    TICK_OVERRUN_CATCH_UP, // Keep the tick grid and run late ticks back to back, up to maxCatchUpTicks behind
+    TICK_OVERRUN_SKIP // Drop the missed ticks and start a new grid from the end of the late tick
+};
+
+struct TickSchedulerSettings
+{
+    f32 tickRate = 30.0f;
+    TickOverrunPolicy overrunPolicy = TICK_OVERRUN_SKIP;
+    u32 maxCatchUpTicks = 5;
+
+    // The last stretch before a deadline is spun instead of slept, the OS wakes us up too coarsely for it
+    std::chrono::microseconds spinTime = std::chrono::microseconds(200);
+};
+
+struct TickStats
+{
+    u64 ticks = 0;
+    u64 overruns = 0;
+    u64 skippedTicks = 0;
+
+    // Fraction of the tick period spent working, above 1 means the tick overran
+    f32 lastBudgetUsage = 0.0f;
+    f32 averageBudgetUsage = 0.0f;
+    f32 maxBudgetUsage = 0.0f;
+
+    // How late we woke up past the deadline in microseconds, over the most recent ticks that slept
+    f32 jitterP50 = 0.0f;
+    f32 jitterP99 = 0.0f;
+    f32 jitterMax = 0.0f;
+};
+
+// Paces a loop at a fixed tick rate against absolute deadlines, so sleep inaccuracy never accumulates into drift
+class TickScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TickScheduler(const TickSchedulerSettings& settings);
+
+    void Start();
+    void WaitForNextTick();
+
+    TickStats GetStats() const;
+
+private:
+    void SleepUntil(Clock::time_point deadline);
+    void RecordTick(f32 budgetUsage, bool overran, u64 skippedTicks);
+    void RecordJitter(f32 jitter);
+
+    static constexpr size_t JITTER_SAMPLE_COUNT = 1024;
+
+    TickSchedulerSettings _settings;
+    Clock::duration _period;
+    Clock::time_point _tickStart;
+    Clock::time_point _nextDeadline;
+
+    mutable std::mutex _statsMutex;
+    TickStats _stats;
+    f64 _budgetUsageSum = 0.0;
+    std::array<f32, JITTER_SAMPLE_COUNT> _jitterSamples;
+    size_t _jitterSampleCount = 0;
+    size_t _jitterSampleIndex = 0;
+};
@@ -0,0 +1,70 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include <algorithm>
+#include <chrono>
+
+// Refills at a fixed rate up to its burst size, a rate of zero or less leaves the bucket unlimited
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket() : _rate(0.0f), _burst(0.0f), _tokens(0.0f), _lastRefill(Clock::now()) { }
+
+    void Setup(f32 rate, f32 burst)
+    {
+        _rate = rate;
+        _burst = std::max(burst, 1.0f);
+        _tokens = _burst;
+        _lastRefill = Clock::now();
+    }
+
+    bool IsLimited() const { return _rate > 0.0f; }
+
+    bool TryConsume(f32 tokens = 1.0f)
+    {
+        if (!IsLimited())
+            return true;
+
+        Clock::time_point now = Clock::now();
+        std::chrono::duration<f32> elapsed = now - _lastRefill;
+        _lastRefill = now;
+        _tokens = std::min(_burst, _tokens + elapsed.count() * _rate);
+
+        if (_tokens < tokens)
+            return false;
+
+        _tokens -= tokens;
+        return true;
+    }
+
+private:
+    f32 _rate;
+    f32 _burst;
+    f32 _tokens;
+    Clock::time_point _lastRefill;
+};
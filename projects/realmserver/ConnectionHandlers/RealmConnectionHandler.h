@@ -29,27 +29,15 @@
 class RealmConnectionHandler : public Common::TcpServer
 {
 public:
-    RealmConnectionHandler(asio::io_service& io_service, i32 port, CharacterDatabaseCache& cache) : Common::TcpServer(io_service, port), _cache(cache) { _instance = this; }
+    RealmConnectionHandler(Common::IoServicePool& ioServicePool, i32 port, bool reusePort, CharacterDatabaseCache& cache) : Common::TcpServer(ioServicePool, port, reusePort), _cache(cache) { _instance = this; }
 
-    void Start()
-    {
-        StartListening();
-    }
 private:
     static RealmConnectionHandler* _instance;
     CharacterDatabaseCache& _cache;
-    void StartListening() override
-    {
-        asio::ip::tcp::socket* socket = new asio::ip::tcp::socket(_ioService);
-        _acceptor.async_accept(*socket, std::bind(&RealmConnectionHandler::HandleNewConnection, this, socket, std::placeholders::_1));
-    }
-
     void HandleNewConnection(asio::ip::tcp::socket* socket, const asio::error_code& error_code) override
     {
         if (!error_code)
         {
-            _workerThread->_mutex.lock();
-
             socket->non_blocking(true);
             {
                 asio::error_code error;
@@ -61,13 +49,9 @@ private:
                 socket->set_option(asio::ip::tcp::no_delay(true), error);
             }
 
-            RealmConnection* connection = new RealmConnection(socket, _cache);
+            std::shared_ptr<RealmConnection> connection = std::make_shared<RealmConnection>(socket, _cache);
+            AddConnection(connection);
             connection->Start();
-
-            _connections.push_back(connection);
-            _workerThread->_mutex.unlock();
         }
-
-        StartListening();
     }
 };
\ No newline at end of file
@@ -24,6 +24,7 @@
 
 #include "RealmConnection.h"
 #include "Networking/ByteBuffer.h"
+#include <Networking/PacketSchema.h>
 #include <Cryptography/BigNumber.h>
 #include <Cryptography/HMAC.h>
 #include <Database/DatabaseConnector.h>
@@ -109,6 +110,96 @@ enum CharacterResponses
     CHAR_DELETE_FAILED_ARENA_CAPTAIN = 75,
 };
 
+// SMSG_CHAR_ENUM, everything that follows a character's guid and name
+struct CharEnumCharacterData
+{
+    u8 race;
+    u8 classId;
+    u8 gender;
+    u8 skin;
+    u8 face;
+    u8 hairStyle;
+    u8 hairColor;
+    u8 facialStyle;
+    u8 level;
+    u32 zoneId;
+    u32 mapId;
+    f32 x;
+    f32 y;
+    f32 z;
+    u32 guildId;
+    u32 characterFlags;
+    u32 customizeFlags;
+    u8 firstLogin;
+    u32 petDisplayId;
+    u32 petLevel;
+    u32 petFamily;
+};
+typedef Common::PacketSchema<CharEnumCharacterData,
+    &CharEnumCharacterData::race, &CharEnumCharacterData::classId, &CharEnumCharacterData::gender,
+    &CharEnumCharacterData::skin, &CharEnumCharacterData::face, &CharEnumCharacterData::hairStyle, &CharEnumCharacterData::hairColor, &CharEnumCharacterData::facialStyle,
+    &CharEnumCharacterData::level, &CharEnumCharacterData::zoneId, &CharEnumCharacterData::mapId,
+    &CharEnumCharacterData::x, &CharEnumCharacterData::y, &CharEnumCharacterData::z,
+    &CharEnumCharacterData::guildId, &CharEnumCharacterData::characterFlags, &CharEnumCharacterData::customizeFlags, &CharEnumCharacterData::firstLogin,
+    &CharEnumCharacterData::petDisplayId, &CharEnumCharacterData::petLevel, &CharEnumCharacterData::petFamily> CharEnumCharacterSchema;
+
+struct CharEnumEquipmentData
+{
+    u32 displayId;
+    u8 inventoryType;
+    u32 enchantAuraId;
+};
+typedef Common::PacketSchema<CharEnumEquipmentData, &CharEnumEquipmentData::displayId, &CharEnumEquipmentData::inventoryType, &CharEnumEquipmentData::enchantAuraId> CharEnumEquipmentSchema;
+
+constexpr u8 CHAR_ENUM_EQUIPMENT_SLOTS = 23;
+constexpr size_t CHAR_ENUM_MAX_NAME_LENGTH = 48; // 12 characters of up to 4 UTF-8 bytes each
+
+void BuildCharEnum(PreparedResultSet& results, Common::ByteBuffer& charEnum)
+{
+    size_t characterSize = sizeof(u64) + CHAR_ENUM_MAX_NAME_LENGTH + 1 + CharEnumCharacterSchema::Size + CHAR_ENUM_EQUIPMENT_SLOTS * CharEnumEquipmentSchema::Size;
+    charEnum.Reserve(1 + results.affected_rows() * characterSize);
+
+    // Number of characters
+    charEnum.Write<u8>(static_cast<u8>(results.affected_rows()));
+
+    /* Template for loading a character */
+    for (const auto& row : results)
+    {
+        charEnum.Write<u64>(row[0].GetU64()); // Guid
+        charEnum.WriteString(row[1].GetString()); // Name
+
+        CharEnumCharacterData character;
+        character.race = row[2].GetU8();
+        character.classId = row[3].GetU8();
+        character.gender = row[4].GetU8();
+        character.skin = row[5].GetU8();
+        character.face = row[6].GetU8();
+        character.hairStyle = row[7].GetU8();
+        character.hairColor = row[8].GetU8();
+        character.facialStyle = row[9].GetU8();
+        character.level = row[10].GetU8();
+        character.zoneId = row[11].GetU16();
+        character.mapId = row[12].GetU16();
+        character.x = row[13].GetF32();
+        character.y = row[14].GetF32();
+        character.z = row[15].GetF32();
+        character.guildId = 0;
+        character.characterFlags = 0;
+        character.customizeFlags = 0;
+        character.firstLogin = 1; // Here we should probably do a playerTime check to determin if its the player's first login
+        character.petDisplayId = 0; // Lich King: 22234
+        character.petLevel = 0;
+        character.petFamily = 0;
+        CharEnumCharacterSchema::Write(charEnum, character);
+
+        CharEnumEquipmentData equipmentDataNull = { 0, 0, 0 };
+        for (u8 i = 0; i < CHAR_ENUM_EQUIPMENT_SLOTS; ++i)
+        {
+            CharEnumEquipmentSchema::Write(charEnum, equipmentDataNull);
+        }
+    }
+}
+
 #pragma pack(push, 1)
 struct sAuthChallenge
 {
@@ -130,6 +221,33 @@ struct sAuthChallenge
 };
 #pragma pack(pop)
 
+// Size of the opcode and payload as announced by the client header
+constexpr u16 MAX_CLIENT_PACKET_SIZE = 10240;
+constexpr u16 MAX_CLIENT_PAYLOAD_SIZE = MAX_CLIENT_PACKET_SIZE - sizeof(u32);
+
+Common::OpcodeTable<bool (RealmConnection::*)()> RealmConnection::InitOpcodeHandlers()
+{
+    Common::OpcodeTable<bool (RealmConnection::*)()> opcodeHandlers;
+
+    opcodeHandlers[Common::Opcode::CMSG_SUSPEND_COMMS_ACK] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 4, 4, &RealmConnection::HandleSuspendCommsAck };
+    opcodeHandlers[Common::Opcode::CMSG_PING] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 8, 8, &RealmConnection::HandlePing };
+    opcodeHandlers[Common::Opcode::CMSG_KEEP_ALIVE] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 0, 0, &RealmConnection::HandleKeepAlive };
+    opcodeHandlers[Common::Opcode::CMSG_AUTH_SESSION] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 57, MAX_CLIENT_PAYLOAD_SIZE, &RealmConnection::HandleAuthSession };
+    opcodeHandlers[Common::Opcode::CMSG_REDIRECT_CLIENT_PROOF] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 29, 64, &RealmConnection::HandleContinueAuthSession };
+    opcodeHandlers[Common::Opcode::CMSG_READY_FOR_ACCOUNT_DATA_TIMES] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 0, 0, &RealmConnection::HandleReadyForAccountDataTimes };
+    opcodeHandlers[Common::Opcode::CMSG_UPDATE_ACCOUNT_DATA] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_MEDIUM, 12, MAX_CLIENT_PAYLOAD_SIZE, &RealmConnection::HandleUpdateAccountData };
+    opcodeHandlers[Common::Opcode::CMSG_REALM_SPLIT] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 4, 4, &RealmConnection::HandleRealmSplit };
+    opcodeHandlers[Common::Opcode::CMSG_CHAR_ENUM] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 0, 0, &RealmConnection::HandleCharEnum };
+    opcodeHandlers[Common::Opcode::CMSG_CHAR_CREATE] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 10, 64, &RealmConnection::HandleCharCreate };
+    opcodeHandlers[Common::Opcode::CMSG_CHAR_DELETE] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 8, 8, &RealmConnection::HandleCharDelete };
+    opcodeHandlers[Common::Opcode::CMSG_PLAYER_LOGIN] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 8, 8, &RealmConnection::HandlePlayerLogin };
+    opcodeHandlers[Common::Opcode::CMSG_CONNECT_TO_FAILED] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 0, 16, &RealmConnection::HandleConnectToFailed };
+
+    return opcodeHandlers;
+}
+
+Common::OpcodeTable<bool (RealmConnection::*)()> const OpcodeHandlers = RealmConnection::InitOpcodeHandlers();
+
 bool RealmConnection::Start()
 {
     BigNumber seed1;
@@ -218,13 +336,16 @@ bool RealmConnection::HandleHeaderRead()
     // Reverse size bytes
     EndianConvertReverse(header->size);
 
-    if (header->size < 4 && header->size > 10240 || header->command >= Common::Opcode::NUM_MSG_TYPES)
-    {
-        std::cout << "header->size < 4: " << (header->size < 4) << ", header->size > 10240: " << (header->size > 10240) << ", header->command >= Common::Opcode::NUM_MSG_TYPES: " << (header->command >= Common::Opcode::NUM_MSG_TYPES) << std::endl;
+    if (header->size < sizeof(header->command) || header->size > MAX_CLIENT_PACKET_SIZE || header->command >= Common::Opcode::NUM_MSG_TYPES)
         return false;
-    }
 
     header->size -= sizeof(header->command);
+
+    // Reject packets the handler could never accept before any of the payload is buffered
+    const RealmOpcodeHandler& opcodeHandler = OpcodeHandlers[header->command];
+    if (opcodeHandler.thread != Common::OPCODE_THREAD_NONE && !opcodeHandler.IsValidSize(header->size))
+        return false;
+
     _packetBuffer.Resize(header->size);
     _packetBuffer.ResetPos();
     return true;
@@ -233,357 +354,307 @@ bool RealmConnection::HandleHeaderRead()
 bool RealmConnection::HandlePacketRead()
 {
     Common::ClientPacketHeader* header = reinterpret_cast<Common::ClientPacketHeader*>(_headerBuffer.GetReadPointer());
-    Common::Opcode opcode = static_cast<Common::Opcode>(header->command);
 
-    printf("Received Opcode: %u\n", opcode);
-    switch (opcode)
-    {
-        case Common::Opcode::CMSG_PLAYER_LOGIN:
-        {
-            Common::ByteBuffer redirectClient;
-            i32 ip = 16777343;
-            i16 port = 9000;
-
-            // 127.0.0.1/1.0.0.127
-            // 2130706433/16777343(https://www.browserling.com/tools/ip-to-dec)
-            redirectClient.Write<i32>(ip);
-            redirectClient.Write<i16>(port);
-            redirectClient.Write<i32>(0); // unk
+    const RealmOpcodeHandler& opcodeHandler = OpcodeHandlers[header->command];
+    if (opcodeHandler.handler == nullptr)
+        return true;
+
+    return (this->*opcodeHandler.handler)();
+}
+
+bool RealmConnection::HandlePlayerLogin()
+{
+    Common::ByteBuffer redirectClient;
+    i32 ip = 16777343;
+    i16 port = 9000;
+
+    // 127.0.0.1/1.0.0.127
+    // 2130706433/16777343(https://www.browserling.com/tools/ip-to-dec)
+    redirectClient.Write<i32>(ip);
+    redirectClient.Write<i16>(port);
+    redirectClient.Write<i32>(0); // unk
 #pragma warning(push)
 #pragma warning(disable: 4312)
-            HMACH hmac(40, sessionKey->BN2BinArray(20).get());
-            hmac.UpdateHash((u8*)&ip, 4);
-            hmac.UpdateHash((u8*)&port, 2);
-            hmac.Finish();
-            redirectClient.Append(hmac.GetData(), 20);
+    HMACH hmac(40, sessionKey->BN2BinArray(20).get());
+    hmac.UpdateHash((u8*)&ip, 4);
+    hmac.UpdateHash((u8*)&port, 2);
+    hmac.Finish();
+    redirectClient.Append(hmac.GetData(), 20);
 #pragma warning(pop)
-            SendPacket(redirectClient, Common::Opcode::SMSG_REDIRECT_CLIENT);
+    SendPacket(redirectClient, Common::Opcode::SMSG_REDIRECT_CLIENT);
 
-            u64 characterGuid = 0;
-            _packetBuffer.Read<u64>(characterGuid);
+    u64 characterGuid = 0;
+    _packetBuffer.Read<u64>(characterGuid);
 
-            DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, [&, characterGuid](std::shared_ptr<DatabaseConnector> & connector)
-            {
-                PreparedStatement stmt("UPDATE characters SET online=1 WHERE guid={u};");
-                stmt.Bind(characterGuid);
-                connector->Execute(stmt);
-
-                
-                /*I'm am not 100% sure where this fits into the picture yet, but I'm sure it has a purpose*/
-                Common::ByteBuffer suspendComms;
-                suspendComms.Write<u32>(1);
-                SendPacket(suspendComms, Common::Opcode::SMSG_SUSPEND_COMMS);
-                
-            });
-            break;
-        }
-        case Common::Opcode::CMSG_CONNECT_TO_FAILED:
-        {
-            Common::ByteBuffer loginFailed(1);
-            loginFailed.Write<u8>(ENTER_FAILED_WORLDSERVER_DOWN);
-            SendPacket(loginFailed, Common::Opcode::SMSG_CHARACTER_LOGIN_FAILED);
-            break;
-        }
-        case Common::Opcode::CMSG_SUSPEND_COMMS_ACK:
-        {
-            u32 response = 0;
-            _packetBuffer.Read<u32>(response);
-            break;
-        }
-        case Common::Opcode::CMSG_PING:
-        {
-            Common::ByteBuffer pong(4);
-            pong.Write<u32>(0);
-            SendPacket(pong, Common::Opcode::SMSG_PONG);
-            break;
-        }
-        case Common::Opcode::CMSG_KEEP_ALIVE:
-            break;
-        case Common::Opcode::CMSG_AUTH_SESSION:
-        {
-            if (account == 0)
-            {
-                HandleAuthSession();
-            }
-            break;
-        }
-        case Common::Opcode::CMSG_REDIRECT_CLIENT_PROOF:
-        {
-            if (account == 0)
-            {
-                HandleContinueAuthSession();
-            }
-            break;
-        }
-        case Common::Opcode::CMSG_READY_FOR_ACCOUNT_DATA_TIMES:
-        {
-            /* Packet Structure */
-            // UInt32:  Server Time (time(nullptr))
-            // UInt8:   Unknown Byte Value
-            // UInt32:  Mask for the account data fields
+    DatabaseConnector::RunAsyncOrdered(DATABASE_TYPE::CHARSERVER, characterGuid, [characterGuid](DatabaseConnector& connector)
+    {
+        PreparedStatement stmt("UPDATE characters SET online=1 WHERE guid={u};");
+        stmt.Bind(characterGuid);
+        connector.Execute(stmt);
+    },
+    [this, self = shared_from_this()]()
+    {
+        /*I'm am not 100% sure where this fits into the picture yet, but I'm sure it has a purpose*/
+        Common::ByteBuffer suspendComms;
+        suspendComms.Write<u32>(1);
+        SendPacket(suspendComms, Common::Opcode::SMSG_SUSPEND_COMMS);
+    }, GetDispatcher(), SQL_PRIORITY_HIGH);
+    return true;
+}
 
-            Common::ByteBuffer accountDataTimes;
+bool RealmConnection::HandleConnectToFailed()
+{
+    Common::ByteBuffer loginFailed(1);
+    loginFailed.Write<u8>(ENTER_FAILED_WORLDSERVER_DOWN);
+    SendPacket(loginFailed, Common::Opcode::SMSG_CHARACTER_LOGIN_FAILED);
+    return true;
+}
 
-            u32 mask = 0x15;
-            accountDataTimes.Write<u32>(static_cast<u32>(time(nullptr)));
-            accountDataTimes.Write<u8>(1); // bitmask blocks count
-            accountDataTimes.Write<u32>(mask); // PER_CHARACTER_CACHE_MASK
+bool RealmConnection::HandleSuspendCommsAck()
+{
+    u32 response = 0;
+    _packetBuffer.Read<u32>(response);
+    return true;
+}
 
-            for (u32 i = 0; i < 8; ++i)
-            {
-                if (mask & (1 << i))
-                    accountDataTimes.Write<u32>(0);
-            }
+bool RealmConnection::HandlePing()
+{
+    Common::ByteBuffer pong(4);
+    pong.Write<u32>(0);
+    SendPacket(pong, Common::Opcode::SMSG_PONG);
+    return true;
+}
 
-            SendPacket(accountDataTimes, Common::Opcode::SMSG_ACCOUNT_DATA_TIMES);
-            break;
-        }
-        case Common::Opcode::CMSG_UPDATE_ACCOUNT_DATA:
-        {
-            u32 type, timestamp, decompressedSize;
-            _packetBuffer.Read(&type, 4);
-            _packetBuffer.Read(&timestamp, 4);
-            _packetBuffer.Read(&decompressedSize, 4);
+bool RealmConnection::HandleKeepAlive()
+{
+    return true;
+}
 
-            if (type > 8)
-            {
-                std::cout << "Bad Type." << std::endl;
-                break;
-            }
+bool RealmConnection::HandleReadyForAccountDataTimes()
+{
+    /* Packet Structure */
+    // UInt32:  Server Time (time(nullptr))
+    // UInt8:   Unknown Byte Value
+    // UInt32:  Mask for the account data fields
 
-            Common::ByteBuffer updateAccountDataComplete(9 + 4 + 4);
-            updateAccountDataComplete.Write<u32>(type);
-            updateAccountDataComplete.Write<u32>(0);
+    Common::ByteBuffer accountDataTimes;
 
-            SendPacket(updateAccountDataComplete, Common::Opcode::SMSG_UPDATE_ACCOUNT_DATA_COMPLETE);
-            break;
-        }
-        case Common::Opcode::CMSG_REALM_SPLIT:
-        {
-            std::string split_date = "01/01/01";
-            u32 unk = 0;
-            _packetBuffer.Read<u32>(unk);
+    u32 mask = 0x15;
+    accountDataTimes.Write<u32>(static_cast<u32>(time(nullptr)));
+    accountDataTimes.Write<u8>(1); // bitmask blocks count
+    accountDataTimes.Write<u32>(mask); // PER_CHARACTER_CACHE_MASK
 
-            Common::ByteBuffer realmSplit;
-            realmSplit.Write<u32>(unk);
-            realmSplit.Write<u32>(0x0); // split states: 0x0 realm normal, 0x1 realm split, 0x2 realm split pending
-            realmSplit.WriteString(split_date);
+    for (u32 i = 0; i < 8; ++i)
+    {
+        if (mask & (1 << i))
+            accountDataTimes.Write<u32>(0);
+    }
 
-            SendPacket(realmSplit, Common::Opcode::SMSG_REALM_SPLIT);
-            break;
-        }
-        case Common::Opcode::CMSG_CHAR_ENUM:
-        {
-            PreparedStatement stmt("SELECT characters.guid, characters.name, characters.race, characters.class, characters.gender, character_visual_data.skin, character_visual_data.face, character_visual_data.hair_style, character_visual_data.hair_color, character_visual_data.facial_style, characters.level, characters.zoneId, characters.mapId, characters.coordinate_x, characters.coordinate_y, characters.coordinate_z FROM characters INNER JOIN character_visual_data ON characters.guid=character_visual_data.guid WHERE characters.account={u};");
-            stmt.Bind(account);
-            DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this](amy::result_set & results, DatabaseConnector & connector)
-                {
-                    Common::ByteBuffer charEnum;
+    SendPacket(accountDataTimes, Common::Opcode::SMSG_ACCOUNT_DATA_TIMES);
+    return true;
+}
 
-                    // Number of characters
-                    charEnum.Write<u8>(static_cast<u8>(results.affected_rows()));
+bool RealmConnection::HandleUpdateAccountData()
+{
+    u32 type, timestamp, decompressedSize;
+    _packetBuffer.Read(&type, 4);
+    _packetBuffer.Read(&timestamp, 4);
+    _packetBuffer.Read(&decompressedSize, 4);
 
-                    /* Template for loading a character */
-                    for (auto& row : results)
-                    {
-                        charEnum.Write<u64>(row[0].GetU64()); // Guid
-                        charEnum.WriteString(row[1].GetString()); // Name
-                        charEnum.Write<u8>(row[2].GetU8()); // Race
-                        charEnum.Write<u8>(row[3].GetU8()); // Class
-                        charEnum.Write<u8>(row[4].GetU8()); // Gender
-
-                        charEnum.Write<u8>(row[5].GetU8()); // Skin
-                        charEnum.Write<u8>(row[6].GetU8()); // Face
-                        charEnum.Write<u8>(row[7].GetU8()); // Hairstyle
-                        charEnum.Write<u8>(row[8].GetU8()); // Haircolor
-                        charEnum.Write<u8>(row[9].GetU8()); // Facialstyle
-
-                        charEnum.Write<u8>(row[10].GetU8()); // Level
-                        charEnum.Write<u32>(row[11].GetU16()); // Zone Id
-                        charEnum.Write<u32>(row[12].GetU16()); // Map Id
-
-                        charEnum.Write<f32>(row[13].GetF32()); // X
-                        charEnum.Write<f32>(row[14].GetF32()); // Y
-                        charEnum.Write<f32>(row[15].GetF32()); // Z
-
-                        charEnum.Write<u32>(0); // Guild Id
-
-                        charEnum.Write<u32>(0); // Character Flags
-                        charEnum.Write<u32>(0); // characterCustomize Flag
-
-                        charEnum.Write<u8>(1); // First Login (Here we should probably do a playerTime check to determin if its the player's first login)
-
-                        charEnum.Write<u32>(0); // Pet Display Id (Lich King: 22234)
-                        charEnum.Write<u32>(0);  // Pet Level
-                        charEnum.Write<u32>(0);  // Pet Family
-
-                        u32 equipmentDataNull = 0;
-                        for (i32 i = 0; i < 23; ++i)
-                        {
-                            charEnum.Write<u32>(equipmentDataNull);
-                            charEnum.Write<u8>(0);
-                            charEnum.Write<u32>(equipmentDataNull);
-                        }
-                    }
+    if (type > 8)
+    {
+        std::cout << "Bad Type." << std::endl;
+        return true;
+    }
 
-                    SendPacket(charEnum, Common::Opcode::SMSG_CHAR_ENUM);
-                });
-            break;
-        }
-        case Common::Opcode::CMSG_CHAR_CREATE:
-        {
-            cCharacterCreateData* createData = new cCharacterCreateData();
-            createData->Read(_packetBuffer);
+    Common::ByteBuffer updateAccountDataComplete(9 + 4 + 4);
+    updateAccountDataComplete.Write<u32>(type);
+    updateAccountDataComplete.Write<u32>(0);
 
-            PreparedStatement stmt("SELECT name FROM characters WHERE name={s};");
-            stmt.Bind(createData->charName);
-            DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this, createData](amy::result_set& results, DatabaseConnector& connector)
-                {
-                    Common::ByteBuffer characterCreateResult;
+    SendPacket(updateAccountDataComplete, Common::Opcode::SMSG_UPDATE_ACCOUNT_DATA_COMPLETE);
+    return true;
+}
 
-                    if (results.affected_rows() > 0)
-                    {
-                        characterCreateResult.Write<u8>(CHAR_CREATE_NAME_IN_USE);
-                        SendPacket(characterCreateResult, Common::Opcode::SMSG_CHAR_CREATE);
-                        delete createData;
-                        return;
-                    }
+bool RealmConnection::HandleRealmSplit()
+{
+    std::string split_date = "01/01/01";
+    u32 unk = 0;
+    _packetBuffer.Read<u32>(unk);
 
-                    /* Convert name to proper format */
-                    std::transform(createData->charName.begin(), createData->charName.end(), createData->charName.begin(), ::tolower);
-                    createData->charName[0] = std::toupper(createData->charName[0]);
+    Common::ByteBuffer realmSplit;
+    realmSplit.Write<u32>(unk);
+    realmSplit.Write<u32>(0x0); // split states: 0x0 realm normal, 0x1 realm split, 0x2 realm split pending
+    realmSplit.WriteString(split_date);
 
-                    CharacterUtils::SpawnPosition spawnPosition;
-                    if (!CharacterUtils::BuildGetDefaultSpawn(_cache.GetDefaultSpawnStorageData(), createData->charRace, createData->charClass, spawnPosition))
-                    {
-                        characterCreateResult.Write<u8>(CHAR_CREATE_DISABLED);
-                        SendPacket(characterCreateResult, Common::Opcode::SMSG_CHAR_CREATE);
-                        delete createData;
-                        return;
-                    }
+    SendPacket(realmSplit, Common::Opcode::SMSG_REALM_SPLIT);
+    return true;
+}
 
-                    PreparedStatement characterBaseData("INSERT INTO characters(account, name, race, gender, class, mapId, zoneId, coordinate_x, coordinate_y, coordinate_z, orientation) VALUES({u}, {s}, {u}, {u}, {u}, {u}, {u}, {f}, {f}, {f}, {f});");
-                    characterBaseData.Bind(account);
-                    characterBaseData.Bind(createData->charName);
-                    characterBaseData.Bind(createData->charRace);
-                    characterBaseData.Bind(createData->charGender);
-                    characterBaseData.Bind(createData->charClass);
-                    characterBaseData.Bind(spawnPosition.mapId);
-                    characterBaseData.Bind(spawnPosition.zoneId);
-                    characterBaseData.Bind(spawnPosition.coordinate_x);
-                    characterBaseData.Bind(spawnPosition.coordinate_y);
-                    characterBaseData.Bind(spawnPosition.coordinate_z);
-                    characterBaseData.Bind(spawnPosition.orientation);
-                    connector.Execute(characterBaseData);
-
-                    // This needs to be non-async as we rely on LAST_INSERT_ID() to retrieve the character's guid
-                    amy::result_set guidResult;
-                    connector.Query("SELECT LAST_INSERT_ID();", guidResult);
-                    u64 characterGuid = guidResult[0][0].as<amy::sql_bigint_unsigned>();
-
-                    PreparedStatement characterVisualData("INSERT INTO character_visual_data(guid, skin, face, facial_style, hair_style, hair_color) VALUES({u}, {u}, {u}, {u}, {u}, {u});");
-                    characterVisualData.Bind(characterGuid);
-                    characterVisualData.Bind(createData->charSkin);
-                    characterVisualData.Bind(createData->charFace);
-                    characterVisualData.Bind(createData->charFacialStyle);
-                    characterVisualData.Bind(createData->charHairStyle);
-                    characterVisualData.Bind(createData->charHairColor);
-                    connector.ExecuteAsync(characterVisualData);
-
-                    // Baseline Skills
-                    std::string skillSql;
-                    if (CharacterUtils::BuildDefaultSkillSQL(_cache.GetDefaultSkillStorageData(), characterGuid, createData->charRace, createData->charClass, skillSql))
-                    {
-                        connector.ExecuteAsync(skillSql);
-                    }
+bool RealmConnection::HandleCharEnum()
+{
+    PreparedStatement stmt("SELECT characters.guid, characters.name, characters.race, characters.class, characters.gender, character_visual_data.skin, character_visual_data.face, character_visual_data.hair_style, character_visual_data.hair_color, character_visual_data.facial_style, characters.level, characters.zoneId, characters.mapId, characters.coordinate_x, characters.coordinate_y, characters.coordinate_z FROM characters INNER JOIN character_visual_data ON characters.guid=character_visual_data.guid WHERE characters.account={u};");
+    stmt.Bind(account);
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this, self = shared_from_this()](PreparedResultSet & results)
+        {
+            Common::ByteBuffer charEnum;
+            BuildCharEnum(results, charEnum);
+            SendPacket(charEnum, Common::Opcode::SMSG_CHAR_ENUM);
+        }, GetDispatcher());
+    return true;
+}
 
-                    // Baseline Spells
-                    std::string spellSql;
-                    if (CharacterUtils::BuildDefaultSpellSQL(_cache.GetDefaultSpellStorageData(), characterGuid, createData->charRace, createData->charClass, spellSql))
-                    {
-                        connector.ExecuteAsync(spellSql);
-                    }
+bool RealmConnection::HandleCharCreate()
+{
+    std::shared_ptr<cCharacterCreateData> createData = std::make_shared<cCharacterCreateData>();
+    createData->Read(_packetBuffer);
 
-                    DatabaseConnector::Borrow(DATABASE_TYPE::AUTHSERVER, [this](std::shared_ptr<DatabaseConnector> & connector)
-                    {
-                            u32 realmId = 1;
-                        PreparedStatement realmCharacterCount("INSERT INTO realm_characters(account, realmid, characters) VALUES({u}, {u}, 1) ON DUPLICATE KEY UPDATE characters = characters + 1;");
-                        realmCharacterCount.Bind(account);
-                        realmCharacterCount.Bind(realmId); // Realm Id
-                        connector->Execute(realmCharacterCount);
-                    });
+    PreparedStatement stmt("SELECT name FROM characters WHERE name={s};");
+    stmt.Bind(createData->charName);
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this, self = shared_from_this(), createData](PreparedResultSet& results)
+        {
+            Common::ByteBuffer characterCreateResult;
 
-                    characterCreateResult.Write<u8>(CHAR_CREATE_SUCCESS);
-                    SendPacket(characterCreateResult, Common::Opcode::SMSG_CHAR_CREATE);
+            if (results.affected_rows() > 0)
+            {
+                characterCreateResult.Write<u8>(CHAR_CREATE_NAME_IN_USE);
+                SendPacket(characterCreateResult, Common::Opcode::SMSG_CHAR_CREATE);
+                return;
+            }
 
-                    delete createData;
-                });
+            /* Convert name to proper format */
+            std::transform(createData->charName.begin(), createData->charName.end(), createData->charName.begin(), ::tolower);
+            createData->charName[0] = std::toupper(createData->charName[0]);
 
-            break;
-        }
-        case Common::Opcode::CMSG_CHAR_DELETE:
-        {
-            u64 guid = 0;
-            _packetBuffer.Read<u64>(guid);
+            CharacterUtils::SpawnPosition spawnPosition;
+            if (!CharacterUtils::BuildGetDefaultSpawn(_cache.GetDefaultSpawnStorageData(), createData->charRace, createData->charClass, spawnPosition))
+            {
+                characterCreateResult.Write<u8>(CHAR_CREATE_DISABLED);
+                SendPacket(characterCreateResult, Common::Opcode::SMSG_CHAR_CREATE);
+                return;
+            }
 
-            PreparedStatement stmt("SELECT account FROM characters WHERE guid={u};");
-            stmt.Bind(guid);
-            DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this, header, guid](amy::result_set& results, DatabaseConnector& connector)
+            // Every write runs on the same worker connection since we rely on LAST_INSERT_ID() to retrieve the character's guid,
+            // the client is only told about the character once all of them went through
+            DatabaseConnector::RunAsync(DATABASE_TYPE::CHARSERVER, [&cache = _cache, accountGuid = account, createData, spawnPosition](DatabaseConnector& connector)
+            {
+                PreparedStatement characterBaseData("INSERT INTO characters(account, name, race, gender, class, mapId, zoneId, coordinate_x, coordinate_y, coordinate_z, orientation) VALUES({u}, {s}, {u}, {u}, {u}, {u}, {u}, {f}, {f}, {f}, {f});");
+                characterBaseData.Bind(accountGuid);
+                characterBaseData.Bind(createData->charName);
+                characterBaseData.Bind(createData->charRace);
+                characterBaseData.Bind(createData->charGender);
+                characterBaseData.Bind(createData->charClass);
+                characterBaseData.Bind(spawnPosition.mapId);
+                characterBaseData.Bind(spawnPosition.zoneId);
+                characterBaseData.Bind(spawnPosition.coordinate_x);
+                characterBaseData.Bind(spawnPosition.coordinate_y);
+                characterBaseData.Bind(spawnPosition.coordinate_z);
+                characterBaseData.Bind(spawnPosition.orientation);
+                connector.Execute(characterBaseData);
+
+                amy::result_set guidResult;
+                connector.Query("SELECT LAST_INSERT_ID();", guidResult);
+                u64 characterGuid = guidResult[0][0].as<amy::sql_bigint_unsigned>();
+
+                PreparedStatement characterVisualData("INSERT INTO character_visual_data(guid, skin, face, facial_style, hair_style, hair_color) VALUES({u}, {u}, {u}, {u}, {u}, {u});");
+                characterVisualData.Bind(characterGuid);
+                characterVisualData.Bind(createData->charSkin);
+                characterVisualData.Bind(createData->charFace);
+                characterVisualData.Bind(createData->charFacialStyle);
+                characterVisualData.Bind(createData->charHairStyle);
+                characterVisualData.Bind(createData->charHairColor);
+                connector.Execute(characterVisualData);
+
+                // Baseline Skills
+                std::string skillSql;
+                if (CharacterUtils::BuildDefaultSkillSQL(cache.GetDefaultSkillStorageData(), characterGuid, createData->charRace, createData->charClass, skillSql))
                 {
-                    Common::ByteBuffer characterDeleteResult;
-
-                    // Char doesn't exist
-                    if (results.affected_rows() == 0)
-                    {
-                        characterDeleteResult.Write<u8>(CHAR_DELETE_FAILED);
-                        SendPacket(characterDeleteResult, Common::Opcode::SMSG_CHAR_DELETE);
-                        return;
-                    }
-
-                    // Prevent deleting other player's characters
-                    u64 characterAccountGuid = results[0][0].as<amy::sql_bigint_unsigned>();
-                    if (account != characterAccountGuid)
-                    {
-                        characterDeleteResult.Write<u8>(CHAR_DELETE_FAILED);
-                        SendPacket(characterDeleteResult, Common::Opcode::SMSG_CHAR_DELETE);
-                        return;
-                    }
+                    connector.Execute(skillSql);
+                }
 
-                    PreparedStatement characterBaseData("DELETE FROM characters WHERE guid={u};");
-                    characterBaseData.Bind(guid);
+                // Baseline Spells
+                std::string spellSql;
+                if (CharacterUtils::BuildDefaultSpellSQL(cache.GetDefaultSpellStorageData(), characterGuid, createData->charRace, createData->charClass, spellSql))
+                {
+                    connector.Execute(spellSql);
+                }
 
-                    PreparedStatement characterVisualData("DELETE FROM character_visual_data WHERE guid={u};");
-                    characterVisualData.Bind(guid);
+                u32 realmId = 1;
+                PreparedStatement realmCharacterCount("INSERT INTO realm_characters(account, realmid, characters) VALUES({u}, {u}, 1) ON DUPLICATE KEY UPDATE characters = characters + 1;");
+                realmCharacterCount.Bind(accountGuid);
+                realmCharacterCount.Bind(realmId); // Realm Id
+                DatabaseConnector::ExecuteAsync(DATABASE_TYPE::AUTHSERVER, realmCharacterCount);
+            },
+            [this, self]()
+            {
+                Common::ByteBuffer characterCreateResult;
+                characterCreateResult.Write<u8>(CHAR_CREATE_SUCCESS);
+                SendPacket(characterCreateResult, Common::Opcode::SMSG_CHAR_CREATE);
+            }, GetDispatcher());
+        }, GetDispatcher());
 
-                    PreparedStatement charcaterSkillStorage("DELETE FROM character_skill_storage WHERE guid={u};");
-                    charcaterSkillStorage.Bind(guid);
+    return true;
+}
 
-                    PreparedStatement charcaterSpellStorage("DELETE FROM character_spell_storage WHERE guid={u};");
-                    charcaterSpellStorage.Bind(guid);
+bool RealmConnection::HandleCharDelete()
+{
+    u64 guid = 0;
+    _packetBuffer.Read<u64>(guid);
 
-                    connector.Execute(characterBaseData);
-                    connector.Execute(characterVisualData);
-                    connector.Execute(charcaterSkillStorage);
-                    connector.Execute(charcaterSpellStorage);
+    PreparedStatement stmt("SELECT account FROM characters WHERE guid={u};");
+    stmt.Bind(guid);
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this, self = shared_from_this(), guid](PreparedResultSet& results)
+        {
+            Common::ByteBuffer characterDeleteResult;
 
-                    DatabaseConnector::Borrow(DATABASE_TYPE::AUTHSERVER, [this, header](std::shared_ptr<DatabaseConnector> & connector)
-                        {
-                            u32 realmId = 1;
-                            PreparedStatement realmCharacterCount("UPDATE realm_characters SET characters=characters-1 WHERE account={u} and realmid={u};");
-                            realmCharacterCount.Bind(account);
-                            realmCharacterCount.Bind(realmId);
-                            connector->Execute(realmCharacterCount);
-                        });
+            // Char doesn't exist
+            if (results.affected_rows() == 0)
+            {
+                characterDeleteResult.Write<u8>(CHAR_DELETE_FAILED);
+                SendPacket(characterDeleteResult, Common::Opcode::SMSG_CHAR_DELETE);
+                return;
+            }
 
-                    characterDeleteResult.Write<u8>(CHAR_DELETE_SUCCESS);
-                    SendPacket(characterDeleteResult, Common::Opcode::SMSG_CHAR_DELETE);
-                });
-            break;
-        }
-        default:
-            break;
-    }
+            // Prevent deleting other player's characters
+            u64 characterAccountGuid = results[0][0].GetU64();
+            if (account != characterAccountGuid)
+            {
+                characterDeleteResult.Write<u8>(CHAR_DELETE_FAILED);
+                SendPacket(characterDeleteResult, Common::Opcode::SMSG_CHAR_DELETE);
+                return;
+            }
 
+            DatabaseConnector::RunAsyncOrdered(DATABASE_TYPE::CHARSERVER, guid, [accountGuid = account, guid](DatabaseConnector& connector)
+            {
+                PreparedStatement characterBaseData("DELETE FROM characters WHERE guid={u};");
+                characterBaseData.Bind(guid);
+
+                PreparedStatement characterVisualData("DELETE FROM character_visual_data WHERE guid={u};");
+                characterVisualData.Bind(guid);
+
+                PreparedStatement charcaterSkillStorage("DELETE FROM character_skill_storage WHERE guid={u};");
+                charcaterSkillStorage.Bind(guid);
+
+                PreparedStatement charcaterSpellStorage("DELETE FROM character_spell_storage WHERE guid={u};");
+                charcaterSpellStorage.Bind(guid);
+
+                connector.Execute(characterBaseData);
+                connector.Execute(characterVisualData);
+                connector.Execute(charcaterSkillStorage);
+                connector.Execute(charcaterSpellStorage);
+
+                u32 realmId = 1;
+                PreparedStatement realmCharacterCount("UPDATE realm_characters SET characters=characters-1 WHERE account={u} and realmid={u};");
+                realmCharacterCount.Bind(accountGuid);
+                realmCharacterCount.Bind(realmId);
+                DatabaseConnector::ExecuteAsync(DATABASE_TYPE::AUTHSERVER, realmCharacterCount);
+            },
+            [this, self]()
+            {
+                Common::ByteBuffer characterDeleteResult;
+                characterDeleteResult.Write<u8>(CHAR_DELETE_SUCCESS);
+                SendPacket(characterDeleteResult, Common::Opcode::SMSG_CHAR_DELETE);
+            }, GetDispatcher());
+        }, GetDispatcher());
     return true;
 }
 
@@ -602,8 +673,11 @@ void RealmConnection::SendPacket(Common::ByteBuffer& packet, Common::Opcode opco
 }
 
 
-void RealmConnection::HandleContinueAuthSession()
+bool RealmConnection::HandleContinueAuthSession()
 {
+    if (account != 0)
+        return true;
+
     std::string username = "";
     u64 dosResponse = 0;
     u8 digest[SHA_DIGEST_LENGTH];
@@ -614,7 +688,7 @@ void RealmConnection::HandleContinueAuthSession()
 
     PreparedStatement stmt("SELECT guid, sessionKey FROM accounts WHERE username={s};");
     stmt.Bind(username);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, username, digest](amy::result_set & results, DatabaseConnector & connector)
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this(), username, digest](PreparedResultSet & results)
     {
         // Make sure the account exist.
         if (results.affected_rows() != 1)
@@ -624,7 +698,7 @@ void RealmConnection::HandleContinueAuthSession()
         }
 
         // We need to try to use the session key that we have, if we don't the client won't be able to read the auth response error.
-        sessionKey->Hex2BN(results[0][1].as<amy::sql_varchar>().c_str());
+        sessionKey->Hex2BN(results[0][1].GetString().c_str());
 
         SHA1Hasher sha;
         u32 t = 0;
@@ -641,7 +715,7 @@ void RealmConnection::HandleContinueAuthSession()
 
 
         _streamCrypto.SetupServer(sessionKey);
-        account = results[0][0].as<amy::sql_int_unsigned>();
+        account = results[0][0].GetU32();
 
         Common::ByteBuffer empty;
         SendPacket(empty, Common::Opcode::SMSG_RESUME_COMMS);
@@ -673,63 +747,22 @@ void RealmConnection::HandleContinueAuthSession()
 
         PreparedStatement stmt("SELECT characters.guid, characters.name, characters.race, characters.class, characters.gender, character_visual_data.skin, character_visual_data.face, character_visual_data.hair_style, character_visual_data.hair_color, character_visual_data.facial_style, characters.level, characters.zoneId, characters.mapId, characters.coordinate_x, characters.coordinate_y, characters.coordinate_z FROM characters INNER JOIN character_visual_data ON characters.guid=character_visual_data.guid WHERE characters.account={u};");
         stmt.Bind(account);
-        DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this](amy::result_set & results, DatabaseConnector & connector)
+        DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [this, self = shared_from_this()](PreparedResultSet & results)
             {
                 Common::ByteBuffer charEnum;
-
-                // Number of characters
-                charEnum.Write<u8>(static_cast<u8>(results.affected_rows()));
-
-                /* Template for loading a character */
-                for (auto& row : results)
-                {
-                    charEnum.Write<u64>(row[0].GetU64()); // Guid
-                    charEnum.WriteString(row[1].GetString()); // Name
-                    charEnum.Write<u8>(row[2].GetU8()); // Race
-                    charEnum.Write<u8>(row[3].GetU8()); // Class
-                    charEnum.Write<u8>(row[4].GetU8()); // Gender
-
-                    charEnum.Write<u8>(row[5].GetU8()); // Skin
-                    charEnum.Write<u8>(row[6].GetU8()); // Face
-                    charEnum.Write<u8>(row[7].GetU8()); // Hairstyle
-                    charEnum.Write<u8>(row[8].GetU8()); // Haircolor
-                    charEnum.Write<u8>(row[9].GetU8()); // Facialstyle
-
-                    charEnum.Write<u8>(row[10].GetU8()); // Level
-                    charEnum.Write<u32>(row[11].GetU16()); // Zone Id
-                    charEnum.Write<u32>(row[12].GetU16()); // Map Id
-
-                    charEnum.Write<f32>(row[13].GetF32()); // X
-                    charEnum.Write<f32>(row[14].GetF32()); // Y
-                    charEnum.Write<f32>(row[15].GetF32()); // Z
-
-                    charEnum.Write<u32>(0); // Guild Id
-
-                    charEnum.Write<u32>(0); // Character Flags
-                    charEnum.Write<u32>(0); // characterCustomize Flag
-
-                    charEnum.Write<u8>(1); // First Login (Here we should probably do a playerTime check to determin if its the player's first login)
-
-                    charEnum.Write<u32>(0); // Pet Display Id (Lich King: 22234)
-                    charEnum.Write<u32>(0);  // Pet Level
-                    charEnum.Write<u32>(0);  // Pet Family
-
-                    u32 equipmentDataNull = 0;
-                    for (i32 i = 0; i < 23; ++i)
-                    {
-                        charEnum.Write<u32>(equipmentDataNull);
-                        charEnum.Write<u8>(0);
-                        charEnum.Write<u32>(equipmentDataNull);
-                    }
-                }
-
+                BuildCharEnum(results, charEnum);
                 SendPacket(charEnum, Common::Opcode::SMSG_CHAR_ENUM);
-            });
-    });
+            }, GetDispatcher(), SQL_PRIORITY_HIGH);
+    }, GetDispatcher(), SQL_PRIORITY_HIGH);
+
+    return true;
 }
 
-void RealmConnection::HandleAuthSession()
+bool RealmConnection::HandleAuthSession()
 {
+    if (account != 0)
+        return true;
+
     /* Read AuthSession Data */
     sessionData.Read(_packetBuffer);
 
@@ -774,7 +807,7 @@ void RealmConnection::HandleAuthSession()
 
     PreparedStatement stmt("SELECT guid, sessionKey FROM accounts WHERE username={s};");
     stmt.Bind(sessionData.accountName);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this](amy::result_set& results, DatabaseConnector& connector)
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this()](PreparedResultSet& results)
     {
         // Make sure the account exist.
         if (results.affected_rows() != 1)
@@ -784,7 +817,7 @@ void RealmConnection::HandleAuthSession()
         }
 
         // We need to try to use the session key that we have, if we don't the client won't be able to read the auth response error.
-        sessionKey->Hex2BN(results[0][1].as<amy::sql_varchar>().c_str());
+        sessionKey->Hex2BN(results[0][1].GetString().c_str());
 
         SHA1Hasher sha;
         u32 t = 0;
@@ -913,5 +946,7 @@ void RealmConnection::HandleAuthSession()
 		redirectClient.Append(hmac.GetData(), 20);
 #pragma warning(pop)
 		SendPacket(redirectClient, Common::Opcode::SMSG_REDIRECT_CLIENT);*/
-    });
+    }, GetDispatcher(), SQL_PRIORITY_HIGH);
+
+    return true;
 }
\ No newline at end of file
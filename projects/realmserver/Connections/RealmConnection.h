@@ -26,6 +26,7 @@
 #include <asio/ip/tcp.hpp>
 #include <Networking/BaseSocket.h>
 #include <Networking/Opcode/Opcode.h>
+#include <Networking/Opcode/OpcodeHandler.h>
 #include <Cryptography/StreamCrypto.h>
 #include <Cryptography/BigNumber.h>
 #include <Cryptography/SHA1.h>
@@ -91,9 +92,14 @@ struct cCharacterCreateData
 };
 #pragma pack(pop)
 
+class RealmConnection;
+typedef Common::OpcodeHandler<bool (RealmConnection::*)()> RealmOpcodeHandler;
+
 class RealmConnection : public Common::BaseSocket
 {
 public:
+    static Common::OpcodeTable<bool (RealmConnection::*)()> InitOpcodeHandlers();
+
     RealmConnection(asio::ip::tcp::socket* socket, CharacterDatabaseCache& cache) : Common::BaseSocket(socket), account(0), _headerBuffer(), _packetBuffer(), _cache(cache)
     {
         _seed = static_cast<u32>(rand());
@@ -108,8 +114,20 @@ public:
     bool HandleHeaderRead();
     bool HandlePacketRead();
 
-    void HandleAuthSession();
-    void HandleContinueAuthSession();
+    // Opcode handlers run on the network thread, returning false closes the connection
+    bool HandlePlayerLogin();
+    bool HandleConnectToFailed();
+    bool HandleSuspendCommsAck();
+    bool HandlePing();
+    bool HandleKeepAlive();
+    bool HandleAuthSession();
+    bool HandleContinueAuthSession();
+    bool HandleReadyForAccountDataTimes();
+    bool HandleUpdateAccountData();
+    bool HandleRealmSplit();
+    bool HandleCharEnum();
+    bool HandleCharCreate();
+    bool HandleCharDelete();
 
     template<size_t T>
     inline void convert(char *val)
@@ -58,6 +58,12 @@ i32 main()
     dbConnections[DATABASE_TYPE::CHARSERVER] = DatabaseConnectionDetails(ConfigHandler::GetJsonObjectByKey("character_database"));
     dbConnections[DATABASE_TYPE::DBC] = DatabaseConnectionDetails(ConfigHandler::GetJsonObjectByKey("dbc_database"));
 
+    PreparedStatementSettings preparedStatementSettings;
+    preparedStatementSettings.enabled = ConfigHandler::GetOption<bool>("preparedStatements", true);
+    preparedStatementSettings.maxCachedStatements = ConfigHandler::GetOption<u32>("maxCachedStatements", 256);
+    DatabaseConnector::SetupPreparedStatements(preparedStatementSettings);
+    DatabaseConnector::SetupAsyncWorkers(ConfigHandler::GetOption<u32>("asyncWorkers", 2));
+
     /* Pass Database Information to Setup */
     DatabaseConnector::Setup(dbConnections);
 
@@ -71,15 +77,12 @@ i32 main()
     CharacterDatabaseCache characterDatabaseCache;
     characterDatabaseCache.Load();
 
-    asio::io_service io_service(2);
-    RealmConnectionHandler realmConnectionHandler(io_service,    ConfigHandler::GetOption<u16>("port", 8000), characterDatabaseCache);
+    Common::IoServicePool ioServicePool(ConfigHandler::GetOption<u16>("networkThreads", 1));
+    RealmConnectionHandler realmConnectionHandler(ioServicePool, ConfigHandler::GetOption<u16>("port", 8000), ConfigHandler::GetOption<bool>("reusePort", false), characterDatabaseCache);
     realmConnectionHandler.Start();
 
     srand(static_cast<u32>(time(NULL)));
-    std::thread run_thread([&]
-    {
-        io_service.run();
-    });
+    ioServicePool.Run();
 
     NC_LOG_SUCCESS("Realmserver running on port: %u", realmConnectionHandler.GetPort());
 
@@ -0,0 +1,130 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <zlib.h>
+#include "../worldnode/Utils/UpdateData.h"
+#include "TestUtils.h"
+
+// Fills an update with blocks shaped like object creates, a packed guid followed by a mostly empty field mask and values
+static void CompressionFillUpdate(UpdateData& updateData, u32 blockCount)
+{
+    std::mt19937 random(blockCount);
+    std::uniform_int_distribution<u32> value(0, 1000);
+
+    for (u32 i = 0; i < blockCount; i++)
+    {
+        Common::ByteBuffer block;
+        block.Write<u8>(2); // UPDATETYPE_CREATE_OBJECT
+        block.AppendGuid(i + 1);
+        for (u32 field = 0; field < 40; field++)
+        {
+            block.Write<u32>(field % 3 == 0 ? value(random) : 0);
+        }
+        updateData.AddBlock(block);
+    }
+    updateData.AddGuid(blockCount + 1);
+}
+
+// Checks that compressed updates inflate back to the plain packet and times every level: compression [blocks] [builds]
+bool CompressionTest(const std::vector<std::string>& arguments)
+{
+    u32 blockCount = 200;
+    u32 builds = 100;
+    if (!TestUtils::ReadArgument(arguments, 0, blockCount) || !TestUtils::ReadArgument(arguments, 1, builds))
+        return false;
+
+    UpdateData updateData;
+    CompressionFillUpdate(updateData, blockCount);
+
+    CompressionSettings settings;
+    settings.threshold = std::numeric_limits<u32>::max();
+    UpdateData::SetupCompression(settings);
+
+    Common::ByteBuffer plainPacket;
+    u16 opcode = 0;
+    if (!updateData.Build(plainPacket, opcode) || opcode != Common::Opcode::SMSG_UPDATE_OBJECT)
+    {
+        NC_LOG_ERROR("Update under the threshold wasn't sent as a plain update");
+        return false;
+    }
+
+    for (i32 level = 1; level <= 9; level++)
+    {
+        settings.level = level;
+        settings.threshold = 0;
+        UpdateData::SetupCompression(settings);
+
+        Common::ByteBuffer packet;
+        if (!updateData.Build(packet, opcode) || opcode != Common::Opcode::SMSG_COMPRESSED_UPDATE_OBJECT)
+        {
+            NC_LOG_ERROR("Update over the threshold wasn't compressed at level %i", level);
+            return false;
+        }
+
+        u32 plainSize = 0;
+        std::memcpy(&plainSize, packet.data(), sizeof(u32));
+        if (plainSize != plainPacket._writePos)
+        {
+            NC_LOG_ERROR("Compressed update claims %u plain bytes, the plain update has %llu", plainSize, static_cast<u64>(plainPacket._writePos));
+            return false;
+        }
+
+        std::vector<u8> inflated(plainSize);
+        uLongf inflatedSize = plainSize;
+        i32 result = uncompress(inflated.data(), &inflatedSize, packet.data() + sizeof(u32), static_cast<uLong>(packet._writePos - sizeof(u32)));
+        if (result != Z_OK || inflatedSize != plainSize || std::memcmp(inflated.data(), plainPacket.data(), plainSize) != 0)
+        {
+            NC_LOG_ERROR("Update compressed at level %i doesn't inflate back to the plain update (zlib: %i)", level, result);
+            return false;
+        }
+
+        // The counters are shared by every build, so time this level from their difference
+        const CompressionStats& stats = UpdateData::GetCompressionStats();
+        u64 inputBytes = stats.inputBytes.load();
+        u64 compressTimeNs = stats.compressTimeNs.load();
+
+        for (u32 i = 0; i < builds; i++)
+        {
+            Common::ByteBuffer timedPacket;
+            updateData.Build(timedPacket, opcode);
+        }
+
+        inputBytes = stats.inputBytes.load() - inputBytes;
+        f64 compressTimeMs = (stats.compressTimeNs.load() - compressTimeNs) / 1000000.0;
+
+        NC_LOG_MESSAGE("Level %i: %u bytes down to %llu (%.1f%%), %.0f input bytes per millisecond", level, plainSize, static_cast<u64>(packet._writePos), 100.0 * packet._writePos / plainSize, compressTimeMs > 0.0 ? inputBytes / compressTimeMs : 0.0);
+    }
+
+    if (UpdateData::GetCompressionStats().failures.load() > 0)
+    {
+        NC_LOG_ERROR("Deflate failed %llu times", UpdateData::GetCompressionStats().failures.load());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,235 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <Cryptography/ArcFour.h>
+#include <Cryptography/StreamCrypto.h>
+#include <openssl/evp.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/provider.h>
+#endif
+#include <random>
+#include <vector>
+#include <cstring>
+#include "TestUtils.h"
+
+// The RC4 implementation OpenSSL gave us before ArcFour went in-tree, kept as the reference to diff against
+class CryptoReferenceCipher
+{
+public:
+    CryptoReferenceCipher(u8* seed, i32 size) : _context(EVP_CIPHER_CTX_new())
+    {
+        _valid = EVP_EncryptInit_ex(_context, EVP_rc4(), nullptr, nullptr, nullptr) == 1 &&
+                 EVP_CIPHER_CTX_set_key_length(_context, size) == 1 &&
+                 EVP_EncryptInit_ex(_context, nullptr, nullptr, seed, nullptr) == 1;
+    }
+    ~CryptoReferenceCipher() { EVP_CIPHER_CTX_free(_context); }
+
+    bool IsValid() const { return _valid; }
+    void UpdateEncryption(size_t size, u8* data)
+    {
+        i32 out = 0;
+        EVP_EncryptUpdate(_context, data, &out, data, static_cast<i32>(size));
+    }
+
+private:
+    EVP_CIPHER_CTX* _context;
+    bool _valid;
+};
+
+// Runs the RFC 6229 vector for the 40 bit key 0x0102030405
+static bool CryptoKnownAnswerTest()
+{
+    u8 key[5] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    const u8 expected[32] =
+    {
+        0xB2, 0x39, 0x63, 0x05, 0xF0, 0x3D, 0xC0, 0x27, 0xCC, 0xC3, 0x52, 0x4A, 0x0A, 0x11, 0x18, 0xA8,
+        0x69, 0x82, 0x94, 0x4F, 0x18, 0xFC, 0x82, 0xD5, 0x89, 0xC4, 0x03, 0xA4, 0x7A, 0x0D, 0x09, 0x19
+    };
+
+    // Odd chunks so the vector also goes through more than one UpdateEncryption call
+    u8 data[32] = { };
+    ArcFour cipher(key, sizeof(key));
+    cipher.UpdateEncryption(7, data);
+    cipher.UpdateEncryption(13, data + 7);
+    cipher.UpdateEncryption(12, data + 20);
+
+    return std::memcmp(data, expected, sizeof(expected)) == 0;
+}
+
+// Feeds the same random chunks through ArcFour and OpenSSL, half of them through GenerateKeystream, and compares the output
+static bool CryptoCompareStreams(std::mt19937& random, u8* seed, u32 chunks, u64& comparedBytes)
+{
+    CryptoReferenceCipher reference(seed, 20);
+
+    ArcFour cipher(seed, 20);
+    std::uniform_int_distribution<u32> sizeDistribution(1, ArcFour::KeystreamBlockSize * 3);
+    std::vector<u8> expected;
+    std::vector<u8> actual;
+
+    for (u32 i = 0; i < chunks; i++)
+    {
+        // Mostly odd sizes, every few chunks one that lands exactly on or right around the block boundary
+        size_t size = sizeDistribution(random) | 1;
+        if (i % 5 == 0)
+            size = ArcFour::KeystreamBlockSize + (i % 3) - 1;
+
+        expected.resize(size);
+        for (u8& byte : expected)
+            byte = static_cast<u8>(random());
+        actual = expected;
+
+        reference.UpdateEncryption(size, expected.data());
+        if (i % 2 == 0)
+        {
+            cipher.UpdateEncryption(size, actual.data());
+        }
+        else
+        {
+            std::vector<u8> keystream(size);
+            cipher.GenerateKeystream(size, keystream.data());
+            for (size_t j = 0; j < size; j++)
+                actual[j] ^= keystream[j];
+        }
+
+        if (expected != actual)
+            return false;
+
+        comparedBytes += size;
+    }
+
+    return true;
+}
+
+// Encrypts the same packets one by one with OpenSSL after the ARC4-drop1024 and in batches with StreamCrypto
+static bool CryptoCompareBatches(std::mt19937& random, u8* seed, u32 batches, u64& comparedBytes)
+{
+    u8 decryptionKey[20] = { };
+    StreamCrypto batchCrypto;
+    StreamCrypto singleCrypto;
+    batchCrypto.SetupServer(nullptr, seed, decryptionKey);
+    singleCrypto.SetupServer(nullptr, seed, decryptionKey);
+
+    CryptoReferenceCipher reference(seed, 20);
+    u8 dropBuffer[1024] = { };
+    reference.UpdateEncryption(sizeof(dropBuffer), dropBuffer);
+
+    // Header sized packets mixed with large ones, so batches cross the 512 byte refill and the 1024 byte stack buffer
+    std::uniform_int_distribution<u32> countDistribution(1, 64);
+    std::uniform_int_distribution<u32> sizeDistribution(1, 5);
+    std::uniform_int_distribution<u32> largeDistribution(1, 1500);
+
+    for (u32 i = 0; i < batches; i++)
+    {
+        u32 count = countDistribution(random);
+
+        std::vector<std::vector<u8>> batch(count);
+        for (std::vector<u8>& packet : batch)
+        {
+            packet.resize(random() % 8 == 0 ? largeDistribution(random) : sizeDistribution(random));
+            for (u8& byte : packet)
+                byte = static_cast<u8>(random());
+        }
+
+        std::vector<std::vector<u8>> single = batch;
+        std::vector<std::vector<u8>> expected = batch;
+
+        std::vector<u8*> data(count);
+        std::vector<size_t> sizes(count);
+        for (u32 j = 0; j < count; j++)
+        {
+            data[j] = batch[j].data();
+            sizes[j] = batch[j].size();
+
+            singleCrypto.Encrypt(single[j].data(), single[j].size());
+            reference.UpdateEncryption(expected[j].size(), expected[j].data());
+
+            comparedBytes += sizes[j];
+        }
+        batchCrypto.EncryptBatch(data.data(), sizes.data(), count);
+
+        if (batch != single || batch != expected)
+            return false;
+    }
+
+    return true;
+}
+
+// Checks the in-tree RC4 against OpenSSL's and EncryptBatch against single packet encryption: crypto [rounds]
+bool CryptoTest(const std::vector<std::string>& arguments)
+{
+    u32 rounds = 100;
+    if (!TestUtils::ReadArgument(arguments, 0, rounds))
+        return false;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // OpenSSL 3 moved RC4 to the legacy provider, loading it also needs the default one loaded explicitly
+    if (OSSL_PROVIDER_load(nullptr, "legacy") == nullptr || OSSL_PROVIDER_load(nullptr, "default") == nullptr)
+    {
+        NC_LOG_ERROR("Could not load the OpenSSL legacy provider for the reference RC4");
+        return false;
+    }
+#endif
+
+    if (!CryptoKnownAnswerTest())
+    {
+        NC_LOG_ERROR("RC4 known answer test failed");
+        return false;
+    }
+
+    u8 probeSeed[20] = { };
+    if (!CryptoReferenceCipher(probeSeed, 20).IsValid())
+    {
+        NC_LOG_ERROR("OpenSSL does not provide RC4, there is nothing to compare against");
+        return false;
+    }
+
+    std::random_device device;
+    u32 randomSeed = device();
+    std::mt19937 random(randomSeed);
+
+    u64 streamBytes = 0;
+    u64 batchBytes = 0;
+    for (u32 i = 0; i < rounds; i++)
+    {
+        u8 seed[20];
+        for (u8& byte : seed)
+            byte = static_cast<u8>(random());
+
+        if (!CryptoCompareStreams(random, seed, 32, streamBytes))
+        {
+            NC_LOG_ERROR("RC4 keystream differs from OpenSSL in round %u (random seed %u)", i, randomSeed);
+            return false;
+        }
+
+        if (!CryptoCompareBatches(random, seed, 16, batchBytes))
+        {
+            NC_LOG_ERROR("Batched encryption differs in round %u (random seed %u)", i, randomSeed);
+            return false;
+        }
+    }
+
+    NC_LOG_MESSAGE("RC4 matched over %u rounds: %llu bytes against OpenSSL, %llu bytes of batched packets", rounds, streamBytes, batchBytes);
+    return true;
+}
@@ -0,0 +1,147 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <Config/ConfigHandler.h>
+#include <Database/DatabaseConnector.h>
+#include <chrono>
+#include "TestUtils.h"
+
+// Same shape as the character save in CharacterDatabaseCache::WriteCharacter, pointed at the scratch table
+static PreparedStatement DatabaseBuildSaveStatement(u64 characterGuid, u32 iteration)
+{
+    PreparedStatement statement("UPDATE benchmark_characters set level={u}, mapId={u}, zoneId={u}, coordinate_x={f}, coordinate_y={f}, coordinate_z={f}, orientation={f}, online={u} WHERE guid={u};");
+    statement.Bind(iteration % 80 + 1);
+    statement.Bind(0u);
+    statement.Bind(12u);
+    statement.Bind(-8949.95f + iteration);
+    statement.Bind(-132.493f);
+    statement.Bind(83.5312f);
+    statement.Bind(0.0f);
+    statement.Bind(1u);
+    statement.Bind(characterGuid);
+    return statement;
+}
+
+// Same shape as the account lookup the auth server does at login
+static PreparedStatement DatabaseBuildLookupStatement(const std::string& name)
+{
+    PreparedStatement statement("SELECT guid, level FROM benchmark_characters WHERE name={s};");
+    statement.Bind(name);
+    return statement;
+}
+
+/*
+    Times a save and a lookup through the text and the binary protocol. It needs the character database from database.json,
+    but only touches a temporary table that lives as long as its own connection: database [iterations]
+*/
+bool DatabaseTest(const std::vector<std::string>& arguments)
+{
+    u32 iterations = 1000;
+    if (!TestUtils::ReadArgument(arguments, 0, iterations))
+        return false;
+
+    if (iterations == 0)
+    {
+        NC_LOG_ERROR("Needs at least one iteration");
+        return false;
+    }
+
+    if (!ConfigHandler::Load("database.json"))
+        return false;
+
+    DatabaseConnectionDetails connections[DATABASE_TYPE::COUNT];
+    connections[DATABASE_TYPE::CHARSERVER] = DatabaseConnectionDetails(ConfigHandler::GetJsonObjectByKey("character_database"));
+    DatabaseConnector::SetupAsyncWorkers(1);
+    DatabaseConnector::Setup(connections);
+
+    std::unique_ptr<DatabaseConnector> connector;
+    DatabaseConnector::Create(DATABASE_TYPE::CHARSERVER, connector);
+
+    if (!connector->Execute("CREATE TEMPORARY TABLE benchmark_characters (guid BIGINT UNSIGNED NOT NULL, name VARCHAR(12) NOT NULL, level TINYINT UNSIGNED NOT NULL, mapId SMALLINT UNSIGNED NOT NULL, zoneId SMALLINT UNSIGNED NOT NULL, coordinate_x FLOAT NOT NULL, coordinate_y FLOAT NOT NULL, coordinate_z FLOAT NOT NULL, orientation FLOAT NOT NULL, online TINYINT UNSIGNED NOT NULL, PRIMARY KEY (guid), UNIQUE KEY (name));"))
+    {
+        NC_LOG_ERROR("Could not create the scratch table in the character database");
+        return false;
+    }
+
+    const u64 characterGuid = 1;
+    const std::string characterName = "Benchmark";
+    PreparedStatement insert("INSERT INTO benchmark_characters VALUES ({u}, {s}, 1, 0, 12, -8949.95, -132.493, 83.5312, 0, 0);");
+    insert.Bind(characterGuid);
+    insert.Bind(characterName);
+    if (!connector->Execute(insert.Get()))
+    {
+        NC_LOG_ERROR("Could not insert into the scratch table");
+        return false;
+    }
+
+    // Statements are built inside the loops since binding and formatting is part of what each protocol costs
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; i++)
+    {
+        connector->Execute(DatabaseBuildSaveStatement(characterGuid, i).Get());
+    }
+    f64 textSaveTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; i++)
+    {
+        connector->ExecuteStatement(DatabaseBuildSaveStatement(characterGuid, i), nullptr);
+    }
+    f64 preparedSaveTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    amy::result_set textResults;
+    start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; i++)
+    {
+        connector->Query(DatabaseBuildLookupStatement(characterName).Get(), textResults);
+    }
+    f64 textLookupTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    PreparedResultSet preparedResults;
+    start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; i++)
+    {
+        connector->ExecuteStatement(DatabaseBuildLookupStatement(characterName), &preparedResults);
+    }
+    f64 preparedLookupTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    if (textResults.size() != 1 || preparedResults.size() != 1)
+    {
+        NC_LOG_ERROR("Lookup found %llu rows over text and %llu over the binary protocol, expected one", static_cast<u64>(textResults.size()), static_cast<u64>(preparedResults.size()));
+        return false;
+    }
+
+    connector->Execute("DROP TEMPORARY TABLE benchmark_characters;");
+
+    if (DatabaseConnector::GetStats().failures.load() > 0)
+    {
+        NC_LOG_ERROR("%llu statements failed", DatabaseConnector::GetStats().failures.load());
+        return false;
+    }
+
+    NC_LOG_MESSAGE("Character save over %u runs: text %.1fus, prepared %.1fus", iterations, textSaveTime, preparedSaveTime);
+    NC_LOG_MESSAGE("Name lookup over %u runs: text %.1fus, prepared %.1fus", iterations, textLookupTime, preparedLookupTime);
+    return true;
+}
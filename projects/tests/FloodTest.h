@@ -0,0 +1,93 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <Utils/TokenBucket.h>
+#include <chrono>
+#include <thread>
+#include "TestUtils.h"
+
+// Checks the burst, refill and unlimited behaviour of the flood control buckets and times a check: flood [checks]
+bool FloodTest(const std::vector<std::string>& arguments)
+{
+    u32 checks = 10000000;
+    if (!TestUtils::ReadArgument(arguments, 0, checks))
+        return false;
+
+    TokenBucket bucket;
+    for (u32 i = 0; i < 100; i++)
+    {
+        if (!bucket.TryConsume())
+        {
+            NC_LOG_ERROR("A bucket that was never set up dropped a packet");
+            return false;
+        }
+    }
+
+    // A full burst goes through at once, the packet after it doesn't
+    const u32 burst = 10;
+    bucket.Setup(1000.0f, static_cast<f32>(burst));
+    for (u32 i = 0; i < burst; i++)
+    {
+        if (!bucket.TryConsume())
+        {
+            NC_LOG_ERROR("Bucket dropped packet %u of a %u packet burst", i + 1, burst);
+            return false;
+        }
+    }
+    if (bucket.TryConsume())
+    {
+        NC_LOG_ERROR("Bucket let a packet past its burst through");
+        return false;
+    }
+
+    // 20ms at 1000 per second is worth more than the burst, so the bucket refills to exactly the burst and no further
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (u32 i = 0; i < burst; i++)
+    {
+        if (!bucket.TryConsume())
+        {
+            NC_LOG_ERROR("Bucket only refilled %u of %u tokens", i, burst);
+            return false;
+        }
+    }
+    if (bucket.TryConsume())
+    {
+        NC_LOG_ERROR("Bucket refilled past its burst");
+        return false;
+    }
+
+    // Every packet pays for a check on the network thread, so time one against a bucket that always has room
+    bucket.Setup(1000000000.0f, 1000000000.0f);
+    u32 accepted = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < checks; i++)
+    {
+        accepted += bucket.TryConsume() ? 1 : 0;
+    }
+    f64 checkTime = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    NC_LOG_MESSAGE("Token bucket check: %.1fns over %u checks (%u accepted)", checks > 0 ? checkTime / checks : 0.0, checks, accepted);
+    return true;
+}
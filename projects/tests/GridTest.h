@@ -0,0 +1,138 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <chrono>
+#include <random>
+#include "../worldnode/Game/SpatialGrid.h"
+#include "TestUtils.h"
+
+// Checks every radius query of the grid against a linear scan and times both: grid [entities] [radius] [cellSize]
+bool GridTest(const std::vector<std::string>& arguments)
+{
+    u32 entityCount = 5000;
+    f32 radius = 100.0f;
+    f32 cellSize = 50.0f;
+    if (!TestUtils::ReadArgument(arguments, 0, entityCount) || !TestUtils::ReadArgument(arguments, 1, radius) || !TestUtils::ReadArgument(arguments, 2, cellSize))
+        return false;
+
+    if (entityCount == 0 || radius < 0.0f || cellSize <= 0.0f)
+    {
+        NC_LOG_ERROR("Needs at least one entity, a radius of at least 0 and a cell size above 0");
+        return false;
+    }
+
+    const f32 mapSize = 2000.0f;
+
+    std::mt19937 random(entityCount);
+    std::uniform_real_distribution<f32> position(0.0f, mapSize);
+    std::uniform_real_distribution<f32> step(-7.0f, 7.0f);
+
+    std::vector<SpatialGrid::Entry> entities(entityCount);
+    for (u32 i = 0; i < entityCount; i++)
+    {
+        entities[i] = { i, position(random), position(random) };
+    }
+
+    SpatialGrid grid(cellSize);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (SpatialGrid::Entry& entry : entities)
+    {
+        grid.Insert(entry.entity, entry.x, entry.y);
+    }
+    f64 insertTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    // One tick of everyone moving a few yards, some of them cross into another cell
+    start = std::chrono::steady_clock::now();
+    for (SpatialGrid::Entry& entry : entities)
+    {
+        entry.x += step(random);
+        entry.y += step(random);
+        grid.Move(entry.entity, entry.x, entry.y);
+    }
+    f64 moveTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    if (grid.Size() != entityCount)
+    {
+        NC_LOG_ERROR("Grid holds %llu entities after moving, expected %u", static_cast<u64>(grid.Size()), entityCount);
+        return false;
+    }
+
+    std::vector<u32> gridFound(entityCount, 0);
+    start = std::chrono::steady_clock::now();
+    for (const SpatialGrid::Entry& entry : entities)
+    {
+        u32& found = gridFound[entry.entity];
+        grid.QueryRadius(entry.x, entry.y, radius, [&found](const SpatialGrid::Entry&) { found++; });
+    }
+    f64 gridQueryTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<u32> linearFound(entityCount, 0);
+    f32 radiusSquared = radius * radius;
+    start = std::chrono::steady_clock::now();
+    for (const SpatialGrid::Entry& entry : entities)
+    {
+        for (const SpatialGrid::Entry& other : entities)
+        {
+            f32 deltaX = other.x - entry.x;
+            f32 deltaY = other.y - entry.y;
+            if (deltaX * deltaX + deltaY * deltaY <= radiusSquared)
+                linearFound[entry.entity]++;
+        }
+    }
+    f64 linearQueryTime = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    u64 totalFound = 0;
+    for (u32 i = 0; i < entityCount; i++)
+    {
+        if (gridFound[i] != linearFound[i])
+        {
+            NC_LOG_ERROR("Grid found %u entities around entity %u, the linear scan found %u", gridFound[i], i, linearFound[i]);
+            return false;
+        }
+        totalFound += gridFound[i];
+    }
+
+    // Removing swaps the last entry of a cell into the hole, the one that moved there has to stay findable
+    for (u32 i = 0; i < entityCount; i += 2)
+    {
+        grid.Remove(i);
+    }
+    for (const SpatialGrid::Entry& entry : entities)
+    {
+        bool found = false;
+        grid.QueryRadius(entry.x, entry.y, 0.0f, [&found, &entry](const SpatialGrid::Entry& other) { found |= other.entity == entry.entity; });
+
+        if (found != (entry.entity % 2 == 1))
+        {
+            NC_LOG_ERROR("Entity %u is %s the grid after removing every other entity", entry.entity, found ? "still in" : "missing from");
+            return false;
+        }
+    }
+
+    NC_LOG_MESSAGE("Grid of %u entities over %.0f yards with %.0f yard cells uses %llu cells", entityCount, mapSize, cellSize, static_cast<u64>(grid.GetCellCount()));
+    NC_LOG_MESSAGE("Insert all %.0fus, move all %.0fus", insertTime, moveTime);
+    NC_LOG_MESSAGE("Radius %.0f query for every entity: grid %.0fus, linear scan %.0fus, %.1f neighbours on average", radius, gridQueryTime, linearQueryTime, static_cast<f64>(totalFound) / entityCount);
+    return true;
+}
@@ -0,0 +1,114 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <cmath>
+#include <random>
+#include "../worldnode/Game/MovementRelay.h"
+#include "TestUtils.h"
+
+// Counts how many of heartbeats heartbeats an observer distance yards away gets relayed
+static u32 MovementCountRelayed(u32 heartbeats, f32 distance)
+{
+    u32 relayed = 0;
+    for (u32 sequence = 0; sequence < heartbeats; sequence++)
+    {
+        relayed += MovementRelay::ShouldRelayHeartbeat(sequence, distance * distance) ? 1 : 0;
+    }
+    return relayed;
+}
+
+// Checks the heartbeat decimation curve and reports what it saves over a crowd of observers: movement [observers] [range]
+bool MovementTest(const std::vector<std::string>& arguments)
+{
+    u32 observers = 1000;
+    f32 range = 100.0f;
+    if (!TestUtils::ReadArgument(arguments, 0, observers) || !TestUtils::ReadArgument(arguments, 1, range))
+        return false;
+
+    if (range < 0.0f)
+    {
+        NC_LOG_ERROR("Range can't be below 0");
+        return false;
+    }
+
+    // The default curve, given out of order and with a step that wouldn't drop anything
+    MovementRelaySettings settings;
+    settings.heartbeatCurve = { { 70.0f, 4 }, { 10.0f, 1 }, { 40.0f, 2 } };
+    MovementRelay::Setup(settings);
+
+    const u32 heartbeats = 40;
+    const std::pair<f32, u32> expected[] =
+    {
+        { 0.0f, heartbeats },
+        { 39.9f, heartbeats },
+        { 40.0f, heartbeats / 2 },
+        { 69.9f, heartbeats / 2 },
+        { 70.0f, heartbeats / 4 },
+        { 500.0f, heartbeats / 4 }
+    };
+    for (const auto& observer : expected)
+    {
+        u32 relayed = MovementCountRelayed(heartbeats, observer.first);
+        if (relayed != observer.second)
+        {
+            NC_LOG_ERROR("Observer %.1f yards away got %u of %u heartbeats, expected %u", observer.first, relayed, heartbeats, observer.second);
+            return false;
+        }
+    }
+
+    if (!MovementRelay::IsHeartbeat(Common::Opcode::MSG_MOVE_HEARTBEAT) || MovementRelay::IsHeartbeat(Common::Opcode::MSG_MOVE_STOP))
+    {
+        NC_LOG_ERROR("Only heartbeats may be coalesced or decimated");
+        return false;
+    }
+
+    // Observers spread evenly over the area around the mover
+    std::mt19937 random(observers);
+    std::uniform_real_distribution<f32> position(-range, range);
+
+    u64 sent = 0;
+    u64 relayed = 0;
+    for (u32 i = 0; i < observers; i++)
+    {
+        f32 x = position(random);
+        f32 y = position(random);
+        if (x * x + y * y > range * range)
+            continue;
+
+        sent += heartbeats;
+        relayed += MovementCountRelayed(heartbeats, std::sqrt(x * x + y * y));
+    }
+
+    // Leave the relay the way a server without a curve would have it
+    MovementRelay::Setup(MovementRelaySettings());
+    if (MovementCountRelayed(heartbeats, 500.0f) != heartbeats)
+    {
+        NC_LOG_ERROR("An empty curve still decimated heartbeats");
+        return false;
+    }
+
+    NC_LOG_MESSAGE("Observers within %.0f yards got %llu of %llu heartbeats, %.1f%% held back", range, relayed, sent, sent > 0 ? 100.0 * (sent - relayed) / sent : 0.0);
+    return true;
+}
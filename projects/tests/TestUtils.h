@@ -0,0 +1,54 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <sstream>
+#include <type_traits>
+#include <Utils/DebugHandler.h>
+
+namespace TestUtils
+{
+    // Leaves value alone when the argument wasn't given, fails on anything that isn't a number of the right type
+    template <typename T>
+    inline bool ReadArgument(const std::vector<std::string>& arguments, size_t index, T& value)
+    {
+        if (index >= arguments.size())
+            return true;
+
+        const std::string& argument = arguments[index];
+        std::istringstream stream(argument);
+        T parsed;
+        stream >> parsed;
+
+        if (stream.fail() || !stream.eof() || (std::is_unsigned<T>::value && argument[0] == '-'))
+        {
+            NC_LOG_ERROR("Argument %zu (%s) is not a valid number", index + 1, argument.c_str());
+            return false;
+        }
+
+        value = parsed;
+        return true;
+    }
+}
@@ -0,0 +1,115 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <Utils/TickScheduler.h>
+#include <chrono>
+#include <thread>
+#include "TestUtils.h"
+
+// Runs one tick that takes longer than three periods and returns what the scheduler made of it
+static TickStats TickRunOverrun(TickOverrunPolicy policy)
+{
+    TickSchedulerSettings settings;
+    settings.tickRate = 100.0f;
+    settings.overrunPolicy = policy;
+
+    TickScheduler scheduler(settings);
+    scheduler.Start();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(35));
+    scheduler.WaitForNextTick();
+
+    // The late deadlines are in the past already, catching up runs these back to back
+    for (u32 i = 0; i < 3; i++)
+    {
+        scheduler.WaitForNextTick();
+    }
+
+    return scheduler.GetStats();
+}
+
+// Checks the tick pacing and both overrun policies, then reports the wakeup jitter: tick [ticks] [tickRate]
+bool TickTest(const std::vector<std::string>& arguments)
+{
+    u32 ticks = 200;
+    f32 tickRate = 200.0f;
+    if (!TestUtils::ReadArgument(arguments, 0, ticks) || !TestUtils::ReadArgument(arguments, 1, tickRate))
+        return false;
+
+    if (tickRate <= 0.0f)
+    {
+        NC_LOG_ERROR("Tick rate has to be above 0");
+        return false;
+    }
+
+    TickSchedulerSettings settings;
+    settings.tickRate = tickRate;
+    settings.overrunPolicy = TICK_OVERRUN_CATCH_UP;
+
+    TickScheduler scheduler(settings);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    scheduler.Start();
+    for (u32 i = 0; i < ticks; i++)
+    {
+        scheduler.WaitForNextTick();
+    }
+    f64 elapsed = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+    TickStats stats = scheduler.GetStats();
+    if (stats.ticks != ticks)
+    {
+        NC_LOG_ERROR("Scheduler counted %llu ticks, %u ran", stats.ticks, ticks);
+        return false;
+    }
+
+    // Catching up keeps the grid, so the ticks can never finish ahead of it
+    f64 expected = ticks / static_cast<f64>(tickRate);
+    if (elapsed < expected * 0.99)
+    {
+        NC_LOG_ERROR("%u ticks at %.0f per second took %.3fs, expected at least %.3fs", ticks, tickRate, elapsed, expected);
+        return false;
+    }
+
+    NC_LOG_MESSAGE("%u ticks at %.0f per second took %.3fs (%llu overran)", ticks, tickRate, elapsed, stats.overruns);
+    NC_LOG_MESSAGE("Tick budget used: average %.1f%%, max %.1f%%", stats.averageBudgetUsage * 100.0f, stats.maxBudgetUsage * 100.0f);
+    NC_LOG_MESSAGE("Wakeup jitter: p50 %.1fus, p99 %.1fus, max %.1fus", stats.jitterP50, stats.jitterP99, stats.jitterMax);
+
+    // 35ms of work against a 10ms period misses two whole deadlines
+    TickStats skipStats = TickRunOverrun(TICK_OVERRUN_SKIP);
+    if (skipStats.overruns < 1 || skipStats.skippedTicks < 2)
+    {
+        NC_LOG_ERROR("Skipping an overrun counted %llu overruns and %llu skipped ticks", skipStats.overruns, skipStats.skippedTicks);
+        return false;
+    }
+
+    TickStats catchUpStats = TickRunOverrun(TICK_OVERRUN_CATCH_UP);
+    if (catchUpStats.skippedTicks != 0 || catchUpStats.overruns < 3)
+    {
+        NC_LOG_ERROR("Catching up on an overrun counted %llu overruns and %llu skipped ticks", catchUpStats.overruns, catchUpStats.skippedTicks);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,88 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <Utils/DebugHandler.h>
+
+#include "CompressionTest.h"
+#include "CryptoTest.h"
+#include "DatabaseTest.h"
+#include "FloodTest.h"
+#include "GridTest.h"
+#include "MovementTest.h"
+#include "TickTest.h"
+
+struct TestEntry
+{
+    std::function<bool(const std::vector<std::string>&)> run;
+    bool runByDefault; // False when the test needs something outside the process, like a database
+};
+
+// Without arguments every default test runs, otherwise "tests <name> [arguments]" runs one of them
+i32 main(i32 argc, char* argv[])
+{
+    std::map<std::string, TestEntry> tests =
+    {
+        { "compression", { &CompressionTest, true } },
+        { "crypto", { &CryptoTest, true } },
+        { "database", { &DatabaseTest, false } },
+        { "flood", { &FloodTest, true } },
+        { "grid", { &GridTest, true } },
+        { "movement", { &MovementTest, true } },
+        { "tick", { &TickTest, true } }
+    };
+
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    if (arguments.size() > 0)
+    {
+        auto test = tests.find(arguments[0]);
+        if (test == tests.end())
+        {
+            NC_LOG_ERROR("Unknown test: %s", arguments[0].c_str());
+            return 1;
+        }
+
+        arguments.erase(arguments.begin());
+        return test->second.run(arguments) ? 0 : 1;
+    }
+
+    i32 failures = 0;
+    for (auto& test : tests)
+    {
+        if (!test.second.runByDefault)
+            continue;
+
+        NC_LOG_MESSAGE("Running %s", test.first.c_str());
+        if (!test.second.run(arguments))
+        {
+            NC_LOG_ERROR("%s failed", test.first.c_str());
+            failures++;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
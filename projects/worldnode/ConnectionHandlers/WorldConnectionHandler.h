@@ -30,27 +30,15 @@ class WorldNodeHandler;
 class WorldConnectionHandler : public Common::TcpServer
 {
 public:
-    WorldConnectionHandler(asio::io_service& io_service, i32 port, WorldNodeHandler* worldNodeHandler) : Common::TcpServer(io_service, port) { _instance = this; _worldNodeHandler = worldNodeHandler; }
+    WorldConnectionHandler(Common::IoServicePool& ioServicePool, i32 port, bool reusePort, WorldNodeHandler* worldNodeHandler) : Common::TcpServer(ioServicePool, port, reusePort) { _instance = this; _worldNodeHandler = worldNodeHandler; }
 
-    void Start()
-    {
-        StartListening();
-    }
 private:
     static WorldConnectionHandler* _instance;
     WorldNodeHandler* _worldNodeHandler;
-    void StartListening() override
-    {
-        asio::ip::tcp::socket* socket = new asio::ip::tcp::socket(_ioService);
-        _acceptor.async_accept(*socket, std::bind(&WorldConnectionHandler::HandleNewConnection, this, socket, std::placeholders::_1));
-    }
-
     void HandleNewConnection(asio::ip::tcp::socket* socket, const asio::error_code& error_code) override
     {
         if (!error_code)
         {
-            _workerThread->_mutex.lock();
-
             socket->non_blocking(true);
 
             {
@@ -63,13 +51,9 @@ private:
                 socket->set_option(asio::ip::tcp::no_delay(true), error);
             }
 
-            WorldConnection* connection = new WorldConnection(_worldNodeHandler, socket);
+            std::shared_ptr<WorldConnection> connection = std::make_shared<WorldConnection>(_worldNodeHandler, socket);
+            AddConnection(connection);
             connection->Start();
-
-            _connections.push_back(connection);
-            _workerThread->_mutex.unlock();
         }
-
-        StartListening();
     }
 };
\ No newline at end of file
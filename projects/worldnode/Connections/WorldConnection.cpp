@@ -35,6 +35,13 @@
 #include "../ConnectionHandlers/WorldConnectionHandler.h"
 #include "../Utils/CharacterUtils.h"
 
+Common::PacketPool WorldConnection::_packetPool;
+FloodControlSettings WorldConnection::_floodControlSettings;
+FloodControlStats WorldConnection::_floodControlStats;
+size_t WorldConnection::_sendHighWaterMarkSetting = 0;
+size_t WorldConnection::_sendMaxPendingBytesSetting = 0;
+std::chrono::milliseconds WorldConnection::_sendStallTimeoutSetting(0);
+
 enum AuthResponse
 {
     AUTH_OK                                                = 12,
@@ -131,6 +138,77 @@ struct sAuthChallenge
 };
 #pragma pack(pop)
 
+// Size of the opcode and payload as announced by the client header
+constexpr u16 MAX_CLIENT_PACKET_SIZE = 10240;
+constexpr u16 MAX_CLIENT_PAYLOAD_SIZE = MAX_CLIENT_PACKET_SIZE - sizeof(u32);
+
+#define MOVEMENT_OPCODE_HANDLER { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_LOW, 31, 128, &WorldConnection::HandleForwardToTick }
+
+Common::OpcodeTable<bool (WorldConnection::*)()> WorldConnection::InitOpcodeHandlers()
+{
+    Common::OpcodeTable<bool (WorldConnection::*)()> opcodeHandlers;
+
+    /* Network Thread */
+    opcodeHandlers[Common::Opcode::CMSG_SUSPEND_COMMS_ACK] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 4, 4, &WorldConnection::HandleSuspendCommsAck };
+    opcodeHandlers[Common::Opcode::CMSG_PING] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 8, 8, &WorldConnection::HandlePing };
+    opcodeHandlers[Common::Opcode::CMSG_KEEP_ALIVE] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 0, 0, &WorldConnection::HandleKeepAlive };
+    opcodeHandlers[Common::Opcode::CMSG_AUTH_SESSION] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 57, MAX_CLIENT_PAYLOAD_SIZE, &WorldConnection::HandleAuthSession };
+    opcodeHandlers[Common::Opcode::CMSG_REDIRECT_CLIENT_PROOF] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_HIGH, 29, 64, &WorldConnection::HandleContinueAuthSession };
+    opcodeHandlers[Common::Opcode::CMSG_READY_FOR_ACCOUNT_DATA_TIMES] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_LOW, 0, 0, &WorldConnection::HandleReadyForAccountDataTimes };
+    opcodeHandlers[Common::Opcode::CMSG_UPDATE_ACCOUNT_DATA] = { Common::OPCODE_THREAD_NETWORK, Common::OPCODE_COST_MEDIUM, 12, MAX_CLIENT_PAYLOAD_SIZE, &WorldConnection::HandleUpdateAccountData };
+
+    /* Tick Thread, handled by ConnectionSystem (CMSG_PLAYER_LOGIN goes through WorldNodeHandler to create the entity) */
+    opcodeHandlers[Common::Opcode::CMSG_PLAYER_LOGIN] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_HIGH, 8, 8, &WorldConnection::HandlePlayerLogin };
+    opcodeHandlers[Common::Opcode::CMSG_SET_ACTIVE_MOVER] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_LOW, 8, 8, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_LOGOUT_REQUEST] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_HIGH, 0, 0, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_STANDSTATECHANGE] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_LOW, 4, 4, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_SET_SELECTION] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_LOW, 1, 9, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_NAME_QUERY] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 8, 8, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_ITEM_QUERY_SINGLE] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 4, 12, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_MESSAGECHAT] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 9, 1024, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_JOIN_CHANNEL] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 8, 256, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_LEAVE_CHANNEL] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 5, 128, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_ATTACKSWING] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 8, 8, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_ATTACKSTOP] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_LOW, 0, 0, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_SETSHEATHED] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_LOW, 4, 4, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_TEXT_EMOTE] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_MEDIUM, 16, 16, &WorldConnection::HandleForwardToTick };
+    opcodeHandlers[Common::Opcode::CMSG_CAST_SPELL] = { Common::OPCODE_THREAD_TICK, Common::OPCODE_COST_HIGH, 10, 512, &WorldConnection::HandleForwardToTick };
+
+    /* Movement, packed guid followed by at least flags, time, position and fall time */
+    opcodeHandlers[Common::Opcode::MSG_MOVE_STOP] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_STOP_STRAFE] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_STOP_TURN] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_STOP_PITCH] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_FORWARD] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_BACKWARD] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_STRAFE_LEFT] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_STRAFE_RIGHT] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_TURN_LEFT] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_TURN_RIGHT] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_PITCH_UP] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_PITCH_DOWN] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_ASCEND] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_STOP_ASCEND] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_DESCEND] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_START_SWIM] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_STOP_SWIM] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_FALL_LAND] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::CMSG_MOVE_FALL_RESET] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_JUMP] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_SET_FACING] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_SET_PITCH] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_SET_RUN_MODE] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_SET_WALK_MODE] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::CMSG_MOVE_SET_FLY] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::CMSG_MOVE_CHNG_TRANSPORT] = MOVEMENT_OPCODE_HANDLER;
+    opcodeHandlers[Common::Opcode::MSG_MOVE_HEARTBEAT] = MOVEMENT_OPCODE_HANDLER;
+
+    return opcodeHandlers;
+}
+#undef MOVEMENT_OPCODE_HANDLER
+
+Common::OpcodeTable<bool (WorldConnection::*)()> const OpcodeHandlers = WorldConnection::InitOpcodeHandlers();
+
 bool WorldConnection::Start()
 {
     seed1.Rand(16 * 8);
@@ -181,13 +259,13 @@ void WorldConnection::HandleRead()
         }
 
         // We have a header, now check the packet data
-        if (_packetBuffer.GetSpaceLeft() > 0)
+        if (_packetBuffer->GetSpaceLeft() > 0)
         {
-            size_t packetSize = std::min(buffer.GetActualSize(), _packetBuffer.GetSpaceLeft());
-            _packetBuffer.Write(buffer.GetReadPointer(), packetSize);
+            size_t packetSize = std::min(buffer.GetActualSize(), _packetBuffer->GetSpaceLeft());
+            _packetBuffer->Write(buffer.GetReadPointer(), packetSize);
             buffer.ReadBytes(packetSize);
 
-            if (_packetBuffer.GetSpaceLeft() > 0)
+            if (_packetBuffer->GetSpaceLeft() > 0)
             {
                 // Wait until we have all of the packet data
                 assert(buffer.GetActualSize() == 0);
@@ -202,6 +280,7 @@ void WorldConnection::HandleRead()
             return;
         }
         _headerBuffer.ResetPos();
+        _packetBuffer.Reset();
     }
 
     AsyncRead();
@@ -218,145 +297,298 @@ bool WorldConnection::HandleHeaderRead()
     // Reverse size bytes
     EndianConvertReverse(header->size);
 
-    if (header->size < 4 && header->size > 10240 || header->command >= Common::Opcode::NUM_MSG_TYPES)
-    {
-        std::cout << "header->size < 4: " << (header->size < 4) << ", header->size > 10240: " << (header->size > 10240) << ", header->command >= Common::Opcode::NUM_MSG_TYPES: " << (header->command >= Common::Opcode::NUM_MSG_TYPES) << std::endl;
+    if (header->size < sizeof(header->command) || header->size > MAX_CLIENT_PACKET_SIZE || header->command >= Common::Opcode::NUM_MSG_TYPES)
         return false;
-    }
 
     header->size -= sizeof(header->command);
-    _packetBuffer.Resize(header->size);
-    _packetBuffer.ResetPos();
+
+    // Reject packets the handler could never accept before any of the payload is buffered
+    const WorldOpcodeHandler& opcodeHandler = OpcodeHandlers[header->command];
+    if (opcodeHandler.thread != Common::OPCODE_THREAD_NONE && !opcodeHandler.IsValidSize(header->size))
+        return false;
+
+    _packetBuffer = _packetPool.Acquire(header->size);
     return true;
 }
 
 bool WorldConnection::HandlePacketRead()
 {
     Common::ClientPacketHeader* header = reinterpret_cast<Common::ClientPacketHeader*>(_headerBuffer.GetReadPointer());
-    Common::Opcode opcode = static_cast<Common::Opcode>(header->command);
 
-    printf("Received Opcode: %u\n", opcode);
-    switch (opcode)
+    const WorldOpcodeHandler& opcodeHandler = OpcodeHandlers[header->command];
+    if (opcodeHandler.handler == nullptr)
+        return true;
+
+    if (!_floodBuckets[opcodeHandler.cost].TryConsume())
+        return HandleFloodedPacket(opcodeHandler);
+
+    return (this->*opcodeHandler.handler)();
+}
+
+bool WorldConnection::HandleFloodedPacket(const WorldOpcodeHandler& opcodeHandler)
+{
+    _floodControlStats.droppedPackets[opcodeHandler.cost]++;
+    if (opcodeHandler.thread == Common::OPCODE_THREAD_TICK)
     {
-        case Common::Opcode::CMSG_SUSPEND_COMMS_ACK:
-        {
-            u32 response = 0;
-            _packetBuffer.Read<u32>(response);
+        _floodControlStats.droppedTickPackets++;
+        _floodControlStats.droppedTickBytes += _packetBuffer->size();
+    }
 
-            bool test = false;
-            break;
-        }
-        case Common::Opcode::CMSG_PING:
-        {
-            Common::ByteBuffer pong(4);
-            pong.Write<u32>(0);
-            SendPacket(pong, Common::Opcode::SMSG_PONG);
-            break;
-        }
-        case Common::Opcode::CMSG_KEEP_ALIVE:
-            break;
-        case Common::Opcode::CMSG_AUTH_SESSION:
-        {
-            if (account == 0)
-            {
-                HandleAuthSession();
-            }
-            break;
-        }
-        case Common::Opcode::CMSG_REDIRECT_CLIENT_PROOF:
-        {
-            if (account == 0)
-            {
-                HandleContinueAuthSession();
-            }
-            break;
-        }
-        case Common::Opcode::CMSG_READY_FOR_ACCOUNT_DATA_TIMES:
-        {
-            /* Packet Structure */
-            // UInt32:  Server Time (time(nullptr))
-            // UInt8:   Unknown Byte Value
-            // UInt32:  Mask for the account data fields
+    if (_floodDropBucket.TryConsume())
+        return true;
+
+    _floodControlStats.disconnects++;
+    return false;
+}
 
-            Common::ByteBuffer accountDataTimes;
+bool WorldConnection::HandleSuspendCommsAck()
+{
+    u32 response = 0;
+    _packetBuffer->Read<u32>(response);
+    return true;
+}
 
-            u32 mask = 0x15;
-            accountDataTimes.Write<u32>(static_cast<u32>(time(nullptr)));
-            accountDataTimes.Write<u8>(1); // bitmask blocks count
-            accountDataTimes.Write<u32>(mask); // PER_CHARACTER_CACHE_MASK
+bool WorldConnection::HandlePing()
+{
+    Common::ByteBuffer pong(4);
+    pong.Write<u32>(0);
+    SendPacket(pong, Common::Opcode::SMSG_PONG);
+    return true;
+}
 
-            for (u32 i = 0; i < 8; ++i)
-            {
-                if (mask & (1 << i))
-                    accountDataTimes.Write<u32>(0);
-            }
+bool WorldConnection::HandleKeepAlive()
+{
+    return true;
+}
 
-            SendPacket(accountDataTimes, Common::Opcode::SMSG_ACCOUNT_DATA_TIMES);
-            break;
-        }
-        case Common::Opcode::CMSG_UPDATE_ACCOUNT_DATA:
-        {
-            u32 type, timestamp, decompressedSize;
-            _packetBuffer.Read(&type, 4);
-            _packetBuffer.Read(&timestamp, 4);
-            _packetBuffer.Read(&decompressedSize, 4);
+bool WorldConnection::HandleReadyForAccountDataTimes()
+{
+    /* Packet Structure */
+    // UInt32:  Server Time (time(nullptr))
+    // UInt8:   Unknown Byte Value
+    // UInt32:  Mask for the account data fields
 
-            if (type > 8)
-            {
-                std::cout << "Bad Type." << std::endl;
-                break;
-            }
+    Common::ByteBuffer accountDataTimes;
 
-            Common::ByteBuffer updateAccountDataComplete(9 + 4 + 4);
-            updateAccountDataComplete.Write<u32>(type);
-            updateAccountDataComplete.Write<u32>(0);
+    u32 mask = 0x15;
+    accountDataTimes.Write<u32>(static_cast<u32>(time(nullptr)));
+    accountDataTimes.Write<u8>(1); // bitmask blocks count
+    accountDataTimes.Write<u32>(mask); // PER_CHARACTER_CACHE_MASK
 
-            SendPacket(updateAccountDataComplete, Common::Opcode::SMSG_UPDATE_ACCOUNT_DATA_COMPLETE);
-            break;
-        }
-        default:
-        {
-            Message packetMessage;
-            packetMessage.code = MSG_IN_FOWARD_PACKET;
-            packetMessage.opcode = opcode;
-            packetMessage.account = account;
-            packetMessage.packet = _packetBuffer;
-            packetMessage.connection = this;
-            _worldNodeHandler->PassMessage(packetMessage);
-            break;
-        }
+    for (u32 i = 0; i < 8; ++i)
+    {
+        if (mask & (1 << i))
+            accountDataTimes.Write<u32>(0);
     }
 
+    SendPacket(accountDataTimes, Common::Opcode::SMSG_ACCOUNT_DATA_TIMES);
+    return true;
+}
+
+bool WorldConnection::HandleUpdateAccountData()
+{
+    u32 type, timestamp, decompressedSize;
+    _packetBuffer->Read(&type, 4);
+    _packetBuffer->Read(&timestamp, 4);
+    _packetBuffer->Read(&decompressedSize, 4);
+
+    if (type > 8)
+        return true;
+
+    Common::ByteBuffer updateAccountDataComplete(9 + 4 + 4);
+    updateAccountDataComplete.Write<u32>(type);
+    updateAccountDataComplete.Write<u32>(0);
+
+    SendPacket(updateAccountDataComplete, Common::Opcode::SMSG_UPDATE_ACCOUNT_DATA_COMPLETE);
     return true;
 }
 
+bool WorldConnection::HandlePlayerLogin()
+{
+    Common::ClientPacketHeader* header = reinterpret_cast<Common::ClientPacketHeader*>(_headerBuffer.GetReadPointer());
+
+    Message packetMessage;
+    packetMessage.code = MSG_IN_FOWARD_PACKET;
+    packetMessage.opcode = static_cast<i16>(header->command);
+    packetMessage.account = account;
+    packetMessage.packet = std::move(_packetBuffer);
+    packetMessage.connection = std::static_pointer_cast<WorldConnection>(shared_from_this());
+    _worldNodeHandler->PassMessage(packetMessage);
+    return true;
+}
+
+bool WorldConnection::HandleForwardToTick()
+{
+    Common::ClientPacketHeader* header = reinterpret_cast<Common::ClientPacketHeader*>(_headerBuffer.GetReadPointer());
+
+    size_t packetSize = _packetBuffer->size();
+    InboundPacket packet = { static_cast<u16>(header->command), std::move(_packetBuffer) };
+    if (!_inboundPackets.TryEnqueue(std::move(packet)))
+    {
+        // The entity isn't draining (not in world yet or the tick fell behind), keep it out of the tick like flooded packets
+        _floodControlStats.droppedTickPackets++;
+        _floodControlStats.droppedTickBytes += packetSize;
+    }
+    return true;
+}
+
+void WorldConnection::DiscardInboundPackets()
+{
+    InboundPacket packet;
+    while (_inboundPackets.TryDequeue(packet)) { }
+}
+
 void WorldConnection::SendPacket(Common::ByteBuffer& packet, u16 opcode)
 {
-    i32 packetSize = packet.GetActualSize() + 5;
-    Common::ByteBuffer buffer(packetSize);
-    buffer.Resize(packetSize);
+    Common::ServerPacketHeader header(packet.size() + 2, opcode);
 
+    Common::SendSegment segment;
+    segment.buffer = GetSendPool().Acquire(0);
+    segment.buffer->Append(header.headerArray, header.GetLength());
+    segment.buffer->Append(packet.data(), packet.size());
+    segment.offset = 0;
+    segment.size = segment.buffer->GetActualSize();
+
+    std::lock_guard<std::mutex> lock(_streamCryptoMutex);
+    _streamCrypto.Encrypt(segment.buffer->GetDataPointer(), header.GetLength());
+    QueueSendSegments(&segment, 1);
+}
+
+void WorldConnection::SendPacket(const Common::PacketHandle& payload, u16 opcode)
+{
+    Common::ServerPacketHeader header(payload->size() + 2, opcode);
+
+    Common::SendSegment segments[2];
+    segments[0].buffer = GetSendPool().Acquire(0);
+    segments[0].buffer->Append(header.headerArray, header.GetLength());
+    segments[0].offset = 0;
+    segments[0].size = header.GetLength();
+    segments[1] = { payload, 0, payload->size() };
+
+    std::lock_guard<std::mutex> lock(_streamCryptoMutex);
+    _streamCrypto.Encrypt(segments[0].buffer->GetDataPointer(), header.GetLength());
+    QueueSendSegments(segments, 2);
+}
+
+void WorldConnection::QueuePacket(Common::ByteBuffer& packet, u16 opcode)
+{
     Common::ServerPacketHeader header(packet.size() + 2, opcode);
-    _streamCrypto.Encrypt(header.headerArray, header.GetLength());
+    if (!_queuedPackets)
+        _queuedPackets = GetSendPool().Acquire(0);
+
+    _queuedHeaderOffsets.push_back(_queuedPackets->_writePos);
+    _queuedHeaderSizes.push_back(header.GetLength());
+
+    _queuedPackets->Append(header.headerArray, header.GetLength());
+    _queuedPackets->Append(packet.data(), packet.size());
+}
+
+void WorldConnection::QueuePacket(const Common::PacketHandle& payload, u16 opcode)
+{
+    Common::ServerPacketHeader header(payload->size() + 2, opcode);
+    if (!_queuedPackets)
+        _queuedPackets = GetSendPool().Acquire(0);
 
-    buffer.Write(header.headerArray, header.GetLength());
-    buffer.Write(packet.data(), packet.size());
-    Send(buffer);
+    _queuedHeaderOffsets.push_back(_queuedPackets->_writePos);
+    _queuedHeaderSizes.push_back(header.GetLength());
+
+    _queuedPackets->Append(header.headerArray, header.GetLength());
+    _queuedPayloads.push_back({ _queuedPackets->_writePos, payload });
 }
 
-void WorldConnection::HandleContinueAuthSession()
+void WorldConnection::QueueMovementPacket(const Common::PacketHandle& payload, u16 opcode, u64 moverGuid)
 {
+    auto itr = _heldMovementPackets.find(moverGuid);
+    if (itr != _heldMovementPackets.end())
+    {
+        itr->second.opcode = opcode;
+        itr->second.data = payload;
+
+        _sendStats.packetsCoalesced++;
+        GetGlobalSendStats().packetsCoalesced++;
+        return;
+    }
+
+    if (IsSendBackpressured())
+    {
+        _heldMovementPackets[moverGuid] = { opcode, payload };
+        return;
+    }
+
+    QueuePacket(payload, opcode);
+}
+
+void WorldConnection::FlushPackets()
+{
+    // Only the latest movement of every mover is released, and only once the client has caught up
+    if (!_heldMovementPackets.empty() && !IsSendBackpressured())
+    {
+        for (auto& heldPacket : _heldMovementPackets)
+        {
+            QueuePacket(heldPacket.second.data, heldPacket.second.opcode);
+        }
+        _heldMovementPackets.clear();
+    }
+
+    if (_queuedHeaderOffsets.empty())
+        return;
+
+    // The buffer may have moved while packets were appended, so header pointers are only resolved now
+    _queuedHeaderPointers.clear();
+    for (size_t offset : _queuedHeaderOffsets)
+    {
+        _queuedHeaderPointers.push_back(_queuedPackets->GetDataPointer() + offset);
+    }
+
+    // Interleave the owned bytes with the shared payloads in the order they were queued
+    size_t ownedStart = 0;
+    size_t sharedBytes = 0;
+    for (QueuedPayload& queuedPayload : _queuedPayloads)
+    {
+        if (queuedPayload.ownedEnd > ownedStart)
+            _flushSegments.push_back({ _queuedPackets, ownedStart, queuedPayload.ownedEnd - ownedStart });
+
+        size_t payloadSize = queuedPayload.payload->size();
+        sharedBytes += payloadSize;
+        _flushSegments.push_back({ std::move(queuedPayload.payload), 0, payloadSize });
+        ownedStart = queuedPayload.ownedEnd;
+    }
+    if (_queuedPackets->_writePos > ownedStart)
+        _flushSegments.push_back({ _queuedPackets, ownedStart, _queuedPackets->_writePos - ownedStart });
+
+    {
+        std::lock_guard<std::mutex> lock(_streamCryptoMutex);
+        _streamCrypto.EncryptBatch(_queuedHeaderPointers.data(), _queuedHeaderSizes.data(), _queuedHeaderPointers.size());
+        QueueSendSegments(_flushSegments.data(), _flushSegments.size());
+    }
+
+    _sendStats.sharedPayloadBytes += sharedBytes;
+    GetGlobalSendStats().sharedPayloadBytes += sharedBytes;
+
+    // The socket holds on to the slab until it has been written, the next flush frames into a fresh one
+    _queuedPackets.Reset();
+    _queuedHeaderOffsets.clear();
+    _queuedHeaderSizes.clear();
+    _queuedPayloads.clear();
+    _flushSegments.clear();
+}
+
+bool WorldConnection::HandleContinueAuthSession()
+{
+    if (account != 0)
+        return true;
+
     std::string username = "";
     u64 dosResponse = 0;
     u8 digest[SHA_DIGEST_LENGTH];
 
-    _packetBuffer.Read(username);
-    _packetBuffer.Read<u64>(dosResponse);
-    _packetBuffer.Read(&digest, 20);
+    _packetBuffer->Read(username);
+    _packetBuffer->Read<u64>(dosResponse);
+    _packetBuffer->Read(&digest, 20);
 
     PreparedStatement stmt("SELECT guid, sessionKey FROM accounts WHERE username={s};");
     stmt.Bind(username);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, username, digest](amy::result_set & results, DatabaseConnector & connector)
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this(), username, digest](PreparedResultSet & results)
     {
         // Make sure the account exist.
         if (results.affected_rows() != 1)
@@ -411,7 +643,7 @@ void WorldConnection::HandleContinueAuthSession()
         u8* seed2ShaHash = seed2Hash.GetData();
 
         _streamCrypto.SetupServer(&sessionKey, seed2ShaHash, seed1ShaHash);
-        account = results[0][0].as<amy::sql_int_unsigned>();
+        account = results[0][0].GetU32();
 
          SMSG_AUTH_RESPONSE
         Common::ByteBuffer packet(1 + 4 + 1 + 4 + 1);
@@ -424,15 +656,21 @@ void WorldConnection::HandleContinueAuthSession()
 
         Common::ByteBuffer empty1;
         SendPacket(empty1, Common::Opcode::SMSG_RESUME_COMMS);*/
-    });
+    }, GetDispatcher(), SQL_PRIORITY_HIGH);
+
+    return true;
 }
-void WorldConnection::HandleAuthSession()
+
+bool WorldConnection::HandleAuthSession()
 {
+    if (account != 0)
+        return true;
+
     /* Read AuthSession Data */
-    sessionData.Read(_packetBuffer);
+    sessionData.Read(*_packetBuffer);
 
     Common::ByteBuffer AddonInfo;
-    AddonInfo.Append(_packetBuffer.data() + _packetBuffer._readPos, _packetBuffer.size() - _packetBuffer._readPos);
+    AddonInfo.Append(_packetBuffer->data() + _packetBuffer->_readPos, _packetBuffer->size() - _packetBuffer->_readPos);
 
     if (AddonInfo._readPos + 4 <= AddonInfo.size())
     {
@@ -472,7 +710,7 @@ void WorldConnection::HandleAuthSession()
 
     PreparedStatement stmt("SELECT guid, sessionKey FROM accounts WHERE username={s};");
     stmt.Bind(sessionData.accountName);
-    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this](amy::result_set & results, DatabaseConnector & connector)
+    DatabaseConnector::QueryAsync(DATABASE_TYPE::AUTHSERVER, stmt, [this, self = shared_from_this()](PreparedResultSet & results)
         {
             // Make sure the account exist.
             if (results.affected_rows() != 1)
@@ -482,7 +720,7 @@ void WorldConnection::HandleAuthSession()
             }
 
             // We need to try to use the session key that we have, if we don't the client won't be able to read the auth response error.
-            sessionKey.Hex2BN(results[0][1].as<amy::sql_varchar>().c_str());
+            sessionKey.Hex2BN(results[0][1].GetString().c_str());
 
             SHA1Hasher sha;
             u32 t = 0;
@@ -593,29 +831,27 @@ void WorldConnection::HandleAuthSession()
             SendPacket(tutorialFlags, Common::Opcode::SMSG_TUTORIAL_FLAGS);
 
 
-            DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, [this](std::shared_ptr<DatabaseConnector>& connector)
+            PreparedStatement onlineCharacter("SELECT guid FROM characters WHERE account={u} AND online=1;");
+            onlineCharacter.Bind(account);
+            DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, onlineCharacter, [this, self](PreparedResultSet& result)
                 {
-                    PreparedStatement stmt("SELECT guid FROM characters WHERE account={u} AND online=1;");
-                    stmt.Bind(account);
-
-                    amy::result_set result;
-                    connector->Query(stmt, result);
-
                     if (result.affected_rows() > 0)
                     {
                         u64 characterGuid = result[0][0].GetU64();
 
-                        Common::ByteBuffer packet;
-                        packet.Write<u64>(characterGuid);
+                        Common::PacketHandle packet = _packetPool.Acquire(0);
+                        packet->Write<u64>(characterGuid);
 
                         Message packetMessage;
                         packetMessage.code = MSG_IN_FOWARD_PACKET;
                         packetMessage.opcode = Common::Opcode::CMSG_PLAYER_LOGIN;
                         packetMessage.account = account;
-                        packetMessage.packet = packet;
-                        packetMessage.connection = this;
+                        packetMessage.packet = std::move(packet);
+                        packetMessage.connection = std::static_pointer_cast<WorldConnection>(shared_from_this());
                         _worldNodeHandler->PassMessage(packetMessage);
                     }
-                });
-        });
+                }, GetDispatcher(), SQL_PRIORITY_HIGH);
+        }, GetDispatcher(), SQL_PRIORITY_HIGH);
+
+    return true;
 }
\ No newline at end of file
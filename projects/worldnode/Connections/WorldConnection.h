@@ -25,11 +25,20 @@
 
 #include <asio/ip/tcp.hpp>
 #include <Networking/BaseSocket.h>
+#include <Networking/PacketPool.h>
 #include <Networking/Opcode/Opcode.h>
+#include <Networking/Opcode/OpcodeHandler.h>
 #include <Cryptography/StreamCrypto.h>
 #include <Cryptography/BigNumber.h>
 #include <Cryptography/SHA1.h>
+#include <Utils/TokenBucket.h>
+#include <Utils/SPSCQueue.h>
 #include <random>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <robin_hood.h>
 
 #include "../DatabaseCache/CharacterDatabaseCache.h"
 
@@ -91,27 +100,99 @@ struct cCharacterCreateData
 };
 #pragma pack(pop)
 
+// Packets per second and burst size allowed for each opcode cost class, a rate of zero leaves the class unlimited
+struct FloodControlSettings
+{
+    f32 rate[Common::OPCODE_COST_COUNT] = { 0.0f, 0.0f, 0.0f };
+    f32 burst[Common::OPCODE_COST_COUNT] = { 0.0f, 0.0f, 0.0f };
+
+    // Dropped packets a connection may accumulate per second before it is disconnected, zero only ever drops
+    f32 dropRate = 0.0f;
+    f32 dropBurst = 0.0f;
+};
+
+struct FloodControlStats
+{
+    std::atomic<u64> droppedPackets[Common::OPCODE_COST_COUNT];
+    std::atomic<u64> droppedTickPackets; // Packets that never had to be handled by ConnectionSystem
+    std::atomic<u64> droppedTickBytes;
+    std::atomic<u64> disconnects;
+};
+
 class WorldNodeHandler;
+// Tick packets handed from the network thread straight to the connection's entity
+struct InboundPacket
+{
+    u16 opcode;
+    Common::PacketHandle data;
+};
+
+// Inbound packets a connection can have waiting for the tick before further ones are dropped
+constexpr size_t INBOUND_QUEUE_SIZE = 256;
+
+class WorldConnection;
+typedef Common::OpcodeHandler<bool (WorldConnection::*)()> WorldOpcodeHandler;
+
 class WorldConnection : public Common::BaseSocket
 {
 public:
-    WorldConnection(WorldNodeHandler* worldNodeHandler, asio::ip::tcp::socket* socket) : Common::BaseSocket(socket), account(0), _headerBuffer(), _packetBuffer()
+    static Common::OpcodeTable<bool (WorldConnection::*)()> InitOpcodeHandlers();
+
+    WorldConnection(WorldNodeHandler* worldNodeHandler, asio::ip::tcp::socket* socket) : Common::BaseSocket(socket), account(0), _headerBuffer(), _packetBuffer(), _inboundPackets(INBOUND_QUEUE_SIZE)
     {
         _seed = static_cast<u32>(rand());
         _headerBuffer.Resize(sizeof(Common::ClientPacketHeader));
 
+        for (u8 i = 0; i < Common::OPCODE_COST_COUNT; i++)
+        {
+            _floodBuckets[i].Setup(_floodControlSettings.rate[i], _floodControlSettings.burst[i]);
+        }
+        _floodDropBucket.Setup(_floodControlSettings.dropRate, _floodControlSettings.dropBurst);
+        SetSendLimits(_sendHighWaterMarkSetting, _sendMaxPendingBytesSetting, _sendStallTimeoutSetting);
+
         _worldNodeHandler = worldNodeHandler;
     }
 
+    static void SetupFloodControl(const FloodControlSettings& settings) { _floodControlSettings = settings; }
+    static const FloodControlStats& GetFloodControlStats() { return _floodControlStats; }
+    static void SetupSendLimits(size_t highWaterMark, size_t maxPendingBytes, std::chrono::milliseconds stallTimeout)
+    {
+        _sendHighWaterMarkSetting = highWaterMark;
+        _sendMaxPendingBytesSetting = maxPendingBytes;
+        _sendStallTimeoutSetting = stallTimeout;
+    }
+
     bool Start() override;
     void HandleRead() override;
     void SendPacket(Common::ByteBuffer& buffer, u16 opcode);
+    void SendPacket(const Common::PacketHandle& payload, u16 opcode);
+
+    // Queued packets are framed into one buffer, FlushPackets encrypts all of their headers in a single pass and sends them together
+    void QueuePacket(Common::ByteBuffer& buffer, u16 opcode);
+    // Shared payloads are encoded once and sent to many connections, only the header is framed here and the payload is written from the shared slab
+    void QueuePacket(const Common::PacketHandle& payload, u16 opcode);
+    // While the client is backpressured movement is held back per mover, a newer packet for the same mover replaces the older one
+    void QueueMovementPacket(const Common::PacketHandle& payload, u16 opcode, u64 moverGuid);
+    void FlushPackets();
+
+    // Tick thread only, the network thread reading this connection is the single producer
+    bool TryGetInboundPacket(InboundPacket& packet) { return _inboundPackets.TryDequeue(packet); }
+    void DiscardInboundPackets();
 
     bool HandleHeaderRead();
     bool HandlePacketRead();
+    bool HandleFloodedPacket(const WorldOpcodeHandler& opcodeHandler);
 
-    void HandleAuthSession();
-    void HandleContinueAuthSession();
+    // Opcode handlers run on the network thread, returning false closes the connection
+    bool HandleSuspendCommsAck();
+    bool HandlePing();
+    bool HandleKeepAlive();
+    bool HandleAuthSession();
+    bool HandleContinueAuthSession();
+    bool HandleReadyForAccountDataTimes();
+    bool HandleUpdateAccountData();
+    bool HandlePlayerLogin();
+    bool HandleForwardToTick();
 
     template<size_t T>
     inline void convert(char *val)
@@ -134,10 +215,45 @@ public:
     BigNumber seed2;
 
     Common::ByteBuffer _headerBuffer;
-    Common::ByteBuffer _packetBuffer;
+    Common::PacketHandle _packetBuffer;
+
+    // Inbound packet bodies are framed straight into slabs from this pool and handed on to the ECS without further copies
+    static Common::PacketPool _packetPool;
+    SPSCQueue<InboundPacket> _inboundPackets;
+
+    // Only touched by the io thread reading this connection
+    TokenBucket _floodBuckets[Common::OPCODE_COST_COUNT];
+    TokenBucket _floodDropBucket;
+    static FloodControlSettings _floodControlSettings;
+    static FloodControlStats _floodControlStats;
 
     u32 _seed;
     StreamCrypto _streamCrypto;
+    std::mutex _streamCryptoMutex; // Keeps header encryption in the same order as the packets are handed to the socket
+
+    // Headers and copied bodies of queued packets, shared payloads are written after the owned bytes that precede them
+    struct QueuedPayload
+    {
+        size_t ownedEnd;
+        Common::PacketHandle payload;
+    };
+    Common::PacketHandle _queuedPackets;
+    std::vector<size_t> _queuedHeaderOffsets;
+    std::vector<size_t> _queuedHeaderSizes;
+    std::vector<u8*> _queuedHeaderPointers;
+    std::vector<QueuedPayload> _queuedPayloads;
+    std::vector<Common::SendSegment> _flushSegments;
+
+    struct SupersedablePacket
+    {
+        u16 opcode;
+        Common::PacketHandle data;
+    };
+    robin_hood::unordered_map<u64, SupersedablePacket> _heldMovementPackets;
+    static size_t _sendHighWaterMarkSetting;
+    static size_t _sendMaxPendingBytesSetting;
+    static std::chrono::milliseconds _sendStallTimeoutSetting;
+
     WorldNodeHandler* _worldNodeHandler;
 };
 
@@ -0,0 +1,128 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <Utils/StringUtils.h>
+#include <Database/DatabaseConnector.h>
+#include "../WorldNodeHandler.h"
+#include "../Connections/WorldConnection.h"
+#include "../Utils/UpdateData.h"
+#include "../Game/MovementRelay.h"
+
+static void PrintFloodStats(WorldNodeHandler&)
+{
+    const FloodControlStats& stats = WorldConnection::GetFloodControlStats();
+
+    NC_LOG_MESSAGE("Flood control dropped %llu low, %llu medium and %llu high cost packets", stats.droppedPackets[Common::OPCODE_COST_LOW].load(), stats.droppedPackets[Common::OPCODE_COST_MEDIUM].load(), stats.droppedPackets[Common::OPCODE_COST_HIGH].load());
+    NC_LOG_MESSAGE("Kept %llu packets (%llu bytes) out of the world tick, disconnected %llu connections", stats.droppedTickPackets.load(), stats.droppedTickBytes.load(), stats.disconnects.load());
+}
+
+static void PrintCompressionStats(WorldNodeHandler&)
+{
+    const CompressionStats& stats = UpdateData::GetCompressionStats();
+
+    u64 packets = stats.packets.load();
+    u64 inputBytes = stats.inputBytes.load();
+    u64 outputBytes = stats.outputBytes.load();
+    f64 compressTimeMs = stats.compressTimeNs.load() / 1000000.0;
+
+    f64 ratio = inputBytes > 0 ? static_cast<f64>(outputBytes) / inputBytes : 0.0;
+    f64 inputBytesPerMs = compressTimeMs > 0.0 ? inputBytes / compressTimeMs : 0.0;
+    f64 outputBytesPerMs = compressTimeMs > 0.0 ? outputBytes / compressTimeMs : 0.0;
+
+    NC_LOG_MESSAGE("Compressed %llu update packets, %llu bytes down to %llu (%.1f%%), %llu failed", packets, inputBytes, outputBytes, ratio * 100.0, stats.failures.load());
+    NC_LOG_MESSAGE("Spent %.2fms compressing, %.0f input and %.0f compressed bytes per millisecond", compressTimeMs, inputBytesPerMs, outputBytesPerMs);
+}
+
+static void PrintMovementStats(WorldNodeHandler&)
+{
+    const MovementRelayStats& stats = MovementRelay::GetStats();
+
+    u64 relayedBytes = stats.relayedBytes.load();
+    u64 savedBytes = stats.coalescedBytes.load() + stats.decimatedBytes.load();
+    f64 savedRatio = relayedBytes + savedBytes > 0 ? static_cast<f64>(savedBytes) / (relayedBytes + savedBytes) : 0.0;
+
+    NC_LOG_MESSAGE("Relayed %llu movement packets (%llu bytes)", stats.relayedPackets.load(), relayedBytes);
+    NC_LOG_MESSAGE("Coalesced %llu superseded heartbeats (%llu bytes), decimated %llu distant heartbeats (%llu bytes)", stats.coalescedPackets.load(), stats.coalescedBytes.load(), stats.decimatedPackets.load(), stats.decimatedBytes.load());
+    NC_LOG_MESSAGE("Saved %.1f%% of outbound movement bandwidth", savedRatio * 100.0);
+}
+
+static void PrintDatabaseStats(WorldNodeHandler&)
+{
+    const DatabaseStats& stats = DatabaseConnector::GetStats();
+    const PreparedStatementSettings& settings = DatabaseConnector::GetPreparedStatementSettings();
+
+    u64 textStatements = stats.textStatements.load();
+    u64 preparedStatements = stats.preparedStatements.load();
+    f64 textAverage = textStatements > 0 ? stats.textTimeNs.load() / 1000.0 / textStatements : 0.0;
+    f64 preparedAverage = preparedStatements > 0 ? stats.preparedTimeNs.load() / 1000.0 / preparedStatements : 0.0;
+
+    NC_LOG_MESSAGE("Prepared statements are %s, %llu server side statements prepared", settings.enabled ? "enabled" : "disabled", stats.statementsCached.load());
+    NC_LOG_MESSAGE("Ran %llu text statements (%.1fus average) and %llu prepared statements (%.1fus average), %llu failed", textStatements, textAverage, preparedStatements, preparedAverage, stats.failures.load());
+
+    // Queue latency is the time a job waited for a worker, bucketed so the percentiles are upper bounds
+    static const char* priorityNames[SQL_PRIORITY_COUNT] = { "high", "normal", "low" };
+    for (u32 i = 0; i < SQL_PRIORITY_COUNT; i++)
+    {
+        SQL_PRIORITY priority = static_cast<SQL_PRIORITY>(i);
+        NC_LOG_MESSAGE("Async %s priority: %llu jobs, queue latency p50 <= %lluus, p95 <= %lluus, p99 <= %lluus", priorityNames[i], stats.asyncJobs[i].load(), DatabaseConnector::GetQueueLatencyPercentile(priority, 50.0), DatabaseConnector::GetQueueLatencyPercentile(priority, 95.0), DatabaseConnector::GetQueueLatencyPercentile(priority, 99.0));
+    }
+}
+
+static void PrintTickStats(WorldNodeHandler& worldNodeHandler)
+{
+    TickStats stats = worldNodeHandler.GetTickStats();
+
+    NC_LOG_MESSAGE("Ran %llu ticks, %llu overran and %llu were skipped", stats.ticks, stats.overruns, stats.skippedTicks);
+    NC_LOG_MESSAGE("Tick budget used: last %.1f%%, average %.1f%%, max %.1f%%", stats.lastBudgetUsage * 100.0f, stats.averageBudgetUsage * 100.0f, stats.maxBudgetUsage * 100.0f);
+    NC_LOG_MESSAGE("Wakeup jitter: p50 %.1fus, p99 %.1fus, max %.1fus", stats.jitterP50, stats.jitterP99, stats.jitterMax);
+}
+
+// Prints the live counters of one part of the server, or of all of them: stats [flood|tick|compression|movement|database]
+void StatsCommand(WorldNodeHandler& worldNodeHandler, std::vector<std::string> subCommands)
+{
+    static const std::pair<const char*, void(*)(WorldNodeHandler&)> sections[] =
+    {
+        { "flood", &PrintFloodStats },
+        { "tick", &PrintTickStats },
+        { "compression", &PrintCompressionStats },
+        { "movement", &PrintMovementStats },
+        { "database", &PrintDatabaseStats }
+    };
+
+    bool printed = false;
+    for (const auto& section : sections)
+    {
+        if (subCommands.size() > 0 && subCommands[0] != section.first)
+            continue;
+
+        section.second(worldNodeHandler);
+        printed = true;
+    }
+
+    if (!printed)
+    {
+        NC_LOG_WARNING("Unknown stats section: " + subCommands[0]);
+    }
+}
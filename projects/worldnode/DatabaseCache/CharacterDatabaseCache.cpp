@@ -168,7 +168,8 @@ void CharacterDatabaseCache::Save()
             }
             ss << ");";
 
-            PreparedStatement characterSpellStorageData(ss.str());
+            // The spell list is spliced into the SQL, so it differs per character and is sent as a one-off
+            PreparedStatement characterSpellStorageData(ss.str(), true);
             characterSpellStorageData.Bind(itr.first);
             connector->Execute(characterSpellStorageData);
         }
@@ -204,7 +205,7 @@ void CharacterDatabaseCache::Save()
             }
             ss << ");";
 
-            PreparedStatement characterSkillStorageData(ss.str());
+            PreparedStatement characterSkillStorageData(ss.str(), true);
             characterSkillStorageData.Bind(itr.first);
             connector->Execute(characterSkillStorageData);
         }
@@ -214,105 +215,162 @@ void CharacterDatabaseCache::SaveAsync()
 {
 }
 
-void CharacterDatabaseCache::SaveAndUnloadCharacter(u64 characterGuid)
+void CharacterDatabaseCache::SaveAndUnloadCharacter(u64 characterGuid, SQLCallbackDispatcher const& dispatcher)
 {
-    SaveCharacter(characterGuid);
-    UnloadCharacter(characterGuid);
+    std::shared_ptr<CharacterSaveData> saveData = std::make_shared<CharacterSaveData>();
+    GetCharacterSaveData(characterGuid, *saveData);
+
+    u32 generation = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(_accessMutex);
+        generation = ++_unloadGeneration;
+        _pendingUnloads[characterGuid] = generation;
+    }
+
+    DatabaseConnector::RunAsyncOrdered(DATABASE_TYPE::CHARSERVER, characterGuid, [characterGuid, saveData](DatabaseConnector& connector)
+    {
+        WriteCharacter(connector, characterGuid, *saveData);
+    },
+    [this, characterGuid, generation]()
+    {
+        std::unique_lock<std::shared_mutex> lock(_accessMutex);
+
+        // The character logged in again or was queued for another save, whoever owns it now decides when it goes
+        auto pendingUnload = _pendingUnloads.find(characterGuid);
+        if (pendingUnload == _pendingUnloads.end() || pendingUnload->second != generation)
+            return;
+
+        _pendingUnloads.erase(pendingUnload);
+        UnloadCharacter(characterGuid);
+    }, dispatcher, SQL_PRIORITY_LOW);
+}
+void CharacterDatabaseCache::CancelUnloadCharacter(u64 characterGuid)
+{
+    std::unique_lock<std::shared_mutex> lock(_accessMutex);
+    _pendingUnloads.erase(characterGuid);
 }
 void CharacterDatabaseCache::SaveCharacter(u64 characterGuid)
 {
-    DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, [this, characterGuid](std::shared_ptr<DatabaseConnector>& connector)
+    CharacterSaveData saveData;
+    GetCharacterSaveData(characterGuid, saveData);
+
+    DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, [characterGuid, &saveData](std::shared_ptr<DatabaseConnector>& connector)
     {
-        CharacterData characterData = _characterDataCache[characterGuid];
-        PreparedStatement characterBaseData("UPDATE characters set level={u}, mapId={u}, zoneId={u}, coordinate_x={f}, coordinate_y={f}, coordinate_z={f}, orientation={f}, online={u} WHERE guid={u};");
-        characterBaseData.Bind(characterData.level);
-        characterBaseData.Bind(characterData.mapId);
-        characterBaseData.Bind(characterData.zoneId);
-        characterBaseData.Bind(characterData.coordinateX);
-        characterBaseData.Bind(characterData.coordinateY);
-        characterBaseData.Bind(characterData.coordinateZ);
-        characterBaseData.Bind(characterData.orientation);
-        characterBaseData.Bind(characterData.online);
-        characterBaseData.Bind(characterGuid);
-        connector->Execute(characterBaseData);
-
-        // Save Visual Data
-        CharacterVisualData characterVisualData = _characterVisualDataCache[characterGuid];
-        PreparedStatement characterBaseVisualData("UPDATE character_visual_data set skin={u}, face={u}, facial_style={u}, hair_style={u}, hair_color={u} WHERE guid={u};");
-        characterBaseVisualData.Bind(characterVisualData.skin);
-        characterBaseVisualData.Bind(characterVisualData.face);
-        characterBaseVisualData.Bind(characterVisualData.facialStyle);
-        characterBaseVisualData.Bind(characterVisualData.hairStyle);
-        characterBaseVisualData.Bind(characterVisualData.hairColor);
-        characterBaseVisualData.Bind(characterGuid);
-        connector->Execute(characterBaseVisualData);
-
-        // Save Spells
-        {
-            std::stringstream ss;
-            bool first = true;
+        WriteCharacter(*connector, characterGuid, saveData);
+    });
+}
+void CharacterDatabaseCache::GetCharacterSaveData(u64 characterGuid, CharacterSaveData& output)
+{
+    std::shared_lock<std::shared_mutex> lock(_accessMutex);
 
-            ss << "DELETE FROM character_spell_storage WHERE guid={u} AND spell NOT IN (";
-            for (auto itr : _characterSpellStorageCache[characterGuid])
-            {
-                CharacterSpellStorage characterSpellStorage = itr.second;
-                PreparedStatement characterSpellStorageData("INSERT IGNORE INTO character_spell_storage(guid, spell) VALUES({u}, {u});");
-                characterSpellStorageData.Bind(characterGuid);
-                characterSpellStorageData.Bind(characterSpellStorage.id);
-                connector->Execute(characterSpellStorageData);
+    auto characterData = _characterDataCache.find(characterGuid);
+    if (characterData != _characterDataCache.end())
+        output.characterData = characterData->second;
 
-                if (!first)
-                {
-                    ss << ", " << characterSpellStorage.id;
-                }
-                else
-                {
-                    ss << characterSpellStorage.id;
-                    first = false;
-                }
-            }
-            ss << ");";
+    auto characterVisualData = _characterVisualDataCache.find(characterGuid);
+    if (characterVisualData != _characterVisualDataCache.end())
+        output.characterVisualData = characterVisualData->second;
 
-            PreparedStatement characterSpellStorageData(ss.str());
-            characterSpellStorageData.Bind(characterGuid);
-            connector->Execute(characterSpellStorageData);
-        }
+    auto characterSpellStorage = _characterSpellStorageCache.find(characterGuid);
+    if (characterSpellStorage != _characterSpellStorageCache.end())
+        output.characterSpellStorage = characterSpellStorage->second;
 
-        // Save Skills
+    auto characterSkillStorage = _characterSkillStorageCache.find(characterGuid);
+    if (characterSkillStorage != _characterSkillStorageCache.end())
+        output.characterSkillStorage = characterSkillStorage->second;
+}
+void CharacterDatabaseCache::WriteCharacter(DatabaseConnector& connector, u64 characterGuid, const CharacterSaveData& saveData)
+{
+    const CharacterData& characterData = saveData.characterData;
+    PreparedStatement characterBaseData("UPDATE characters set level={u}, mapId={u}, zoneId={u}, coordinate_x={f}, coordinate_y={f}, coordinate_z={f}, orientation={f}, online={u} WHERE guid={u};");
+    characterBaseData.Bind(characterData.level);
+    characterBaseData.Bind(characterData.mapId);
+    characterBaseData.Bind(characterData.zoneId);
+    characterBaseData.Bind(characterData.coordinateX);
+    characterBaseData.Bind(characterData.coordinateY);
+    characterBaseData.Bind(characterData.coordinateZ);
+    characterBaseData.Bind(characterData.orientation);
+    characterBaseData.Bind(characterData.online);
+    characterBaseData.Bind(characterGuid);
+    connector.Execute(characterBaseData);
+
+    // Save Visual Data
+    const CharacterVisualData& characterVisualData = saveData.characterVisualData;
+    PreparedStatement characterBaseVisualData("UPDATE character_visual_data set skin={u}, face={u}, facial_style={u}, hair_style={u}, hair_color={u} WHERE guid={u};");
+    characterBaseVisualData.Bind(characterVisualData.skin);
+    characterBaseVisualData.Bind(characterVisualData.face);
+    characterBaseVisualData.Bind(characterVisualData.facialStyle);
+    characterBaseVisualData.Bind(characterVisualData.hairStyle);
+    characterBaseVisualData.Bind(characterVisualData.hairColor);
+    characterBaseVisualData.Bind(characterGuid);
+    connector.Execute(characterBaseVisualData);
+
+    // Save Spells
+    {
+        std::stringstream ss;
+        bool first = true;
+
+        ss << "DELETE FROM character_spell_storage WHERE guid={u} AND spell NOT IN (";
+        for (auto itr : saveData.characterSpellStorage)
         {
-            std::stringstream ss;
-            bool first = true;
+            CharacterSpellStorage characterSpellStorage = itr.second;
+            PreparedStatement characterSpellStorageData("INSERT IGNORE INTO character_spell_storage(guid, spell) VALUES({u}, {u});");
+            characterSpellStorageData.Bind(characterGuid);
+            characterSpellStorageData.Bind(characterSpellStorage.id);
+            connector.Execute(characterSpellStorageData);
 
-            ss << "DELETE FROM character_skill_storage WHERE guid={u} AND skill NOT IN (";
-            for (auto itr2 : _characterSkillStorageCache[characterGuid])
+            if (!first)
             {
-                CharacterSkillStorage characterSkillStorage = itr2.second;
-                PreparedStatement characterSkillStorageData("INSERT INTO character_skill_storage(guid, skill, value, character_skill_storage.maxValue) VALUES({u}, {u}, {u}, {u}) ON DUPLICATE KEY UPDATE value={u}, character_skill_storage.maxValue={u};");
-                characterSkillStorageData.Bind(characterGuid);
-                characterSkillStorageData.Bind(characterSkillStorage.id);
-                characterSkillStorageData.Bind(characterSkillStorage.value);
-                characterSkillStorageData.Bind(characterSkillStorage.maxValue);
-                characterSkillStorageData.Bind(characterSkillStorage.value);
-                characterSkillStorageData.Bind(characterSkillStorage.maxValue);
-                connector->Execute(characterSkillStorageData);
-
-                if (!first)
-                {
-                    ss << ", " << characterSkillStorage.id;
-                }
-                else
-                {
-                    ss << characterSkillStorage.id;
-                    first = false;
-                }
+                ss << ", " << characterSpellStorage.id;
             }
-            ss << ");";
+            else
+            {
+                ss << characterSpellStorage.id;
+                first = false;
+            }
+        }
+        ss << ");";
+
+        // Every save has its own NOT IN list, preparing these would only fill the statement cache
+        PreparedStatement characterSpellStorageData(ss.str(), true);
+        characterSpellStorageData.Bind(characterGuid);
+        connector.Execute(characterSpellStorageData);
+    }
+
+    // Save Skills
+    {
+        std::stringstream ss;
+        bool first = true;
 
-            PreparedStatement characterSkillStorageData(ss.str());
+        ss << "DELETE FROM character_skill_storage WHERE guid={u} AND skill NOT IN (";
+        for (auto itr2 : saveData.characterSkillStorage)
+        {
+            CharacterSkillStorage characterSkillStorage = itr2.second;
+            PreparedStatement characterSkillStorageData("INSERT INTO character_skill_storage(guid, skill, value, character_skill_storage.maxValue) VALUES({u}, {u}, {u}, {u}) ON DUPLICATE KEY UPDATE value={u}, character_skill_storage.maxValue={u};");
             characterSkillStorageData.Bind(characterGuid);
-            connector->Execute(characterSkillStorageData);
+            characterSkillStorageData.Bind(characterSkillStorage.id);
+            characterSkillStorageData.Bind(characterSkillStorage.value);
+            characterSkillStorageData.Bind(characterSkillStorage.maxValue);
+            characterSkillStorageData.Bind(characterSkillStorage.value);
+            characterSkillStorageData.Bind(characterSkillStorage.maxValue);
+            connector.Execute(characterSkillStorageData);
+
+            if (!first)
+            {
+                ss << ", " << characterSkillStorage.id;
+            }
+            else
+            {
+                ss << characterSkillStorage.id;
+                first = false;
+            }
         }
-    });
+        ss << ");";
+
+        PreparedStatement characterSkillStorageData(ss.str(), true);
+        characterSkillStorageData.Bind(characterGuid);
+        connector.Execute(characterSkillStorageData);
+    }
 }
 void CharacterDatabaseCache::UnloadCharacter(u64 characterGuid)
 {
@@ -322,16 +380,21 @@ void CharacterDatabaseCache::UnloadCharacter(u64 characterGuid)
     _characterSkillStorageCache.erase(characterGuid);
 }
 
-bool CharacterDatabaseCache::GetCharacterData(u64 characterGuid, CharacterData& output)
+bool CharacterDatabaseCache::GetCachedCharacterData(u64 characterGuid, CharacterData& output)
 {
+    std::shared_lock<std::shared_mutex> lock(_accessMutex);
+
     auto cache = _characterDataCache.find(characterGuid);
-    if (cache != _characterDataCache.end())
-    {
-        _accessMutex.lock_shared();
-        CharacterData characterData = cache->second;
-        _accessMutex.unlock_shared();
+    if (cache == _characterDataCache.end())
+        return false;
 
-        output = characterData;
+    output = cache->second;
+    return true;
+}
+bool CharacterDatabaseCache::GetCharacterData(u64 characterGuid, CharacterData& output)
+{
+    if (GetCachedCharacterData(characterGuid, output))
+    {
         return true;
     }
     else
@@ -379,18 +442,17 @@ bool CharacterDatabaseCache::GetCharacterData(u64 characterGuid, CharacterData&
 }
 bool CharacterDatabaseCache::GetCharacterVisualData(u64 characterGuid, CharacterVisualData& output)
 {
+    std::shared_lock<std::shared_mutex> cacheLock(_accessMutex);
     auto cache = _characterVisualDataCache.find(characterGuid);
     if (cache != _characterVisualDataCache.end())
     {
-        _accessMutex.lock_shared();
-        CharacterVisualData characterVisualData = cache->second;
-        _accessMutex.unlock_shared();
-
-        output = characterVisualData;
+        output = cache->second;
         return true;
     }
     else
     {
+        cacheLock.unlock();
+
         // We don't have the character, so we load it
         std::shared_ptr<DatabaseConnector> connector;
         bool result = DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, connector);
@@ -425,18 +487,17 @@ bool CharacterDatabaseCache::GetCharacterVisualData(u64 characterGuid, Character
 }
 bool CharacterDatabaseCache::GetCharacterSpellStorage(u64 characterGuid, robin_hood::unordered_map<u32, CharacterSpellStorage>& output)
 {
+    std::shared_lock<std::shared_mutex> cacheLock(_accessMutex);
     auto cache = _characterSpellStorageCache.find(characterGuid);
     if (cache != _characterSpellStorageCache.end())
     {
-        _accessMutex.lock_shared();
-        robin_hood::unordered_map<u32, CharacterSpellStorage> characterSpellStorageData = cache->second;
-        _accessMutex.unlock_shared();
-
-        output = characterSpellStorageData;
+        output = cache->second;
         return true;
     }
     else
     {
+        cacheLock.unlock();
+
         // We don't have the character, so we load it
         std::shared_ptr<DatabaseConnector> connector;
         bool result = DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, connector);
@@ -460,26 +521,25 @@ bool CharacterDatabaseCache::GetCharacterSpellStorage(u64 characterGuid, robin_h
 
             _characterSpellStorageCache[guid][newCharacterSpellStorage.id] = newCharacterSpellStorage;
         }
+        output = _characterSpellStorageCache[characterGuid];
         _accessMutex.unlock();
 
-        output = _characterSpellStorageCache[characterGuid];
         return true;
     }
 }
 bool CharacterDatabaseCache::GetCharacterSkillStorage(u64 characterGuid, robin_hood::unordered_map<u32, CharacterSkillStorage>& output)
 {
+	std::shared_lock<std::shared_mutex> cacheLock(_accessMutex);
 	auto cache = _characterSkillStorageCache.find(characterGuid);
 	if (cache != _characterSkillStorageCache.end())
 	{
-		_accessMutex.lock_shared();
-		robin_hood::unordered_map<u32, CharacterSkillStorage> characterSkillStorageData = cache->second;
-		_accessMutex.unlock_shared();
-
-		output = characterSkillStorageData;
+		output = cache->second;
 		return true;
 	}
 	else
 	{
+		cacheLock.unlock();
+
 		// We don't have the character, so we load it
 		std::shared_ptr<DatabaseConnector> connector;
 		bool result = DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, connector);
@@ -505,26 +565,25 @@ bool CharacterDatabaseCache::GetCharacterSkillStorage(u64 characterGuid, robin_h
 
 			_characterSkillStorageCache[guid][newCharacterSkillStorage.id] = newCharacterSkillStorage;
 		}
+		output = _characterSkillStorageCache[characterGuid];
 		_accessMutex.unlock();
 
-		output = _characterSkillStorageCache[characterGuid];
 		return true;
 	}
 }
 bool CharacterDatabaseCache::GetCharacterItemData(u64 characterGuid, robin_hood::unordered_map<u32, CharacterItemData>& output)
 {
+	std::shared_lock<std::shared_mutex> cacheLock(_accessMutex);
 	auto cache = _characteritemDataCache.find(characterGuid);
 	if (cache != _characteritemDataCache.end())
 	{
-		_accessMutex.lock_shared();
-		robin_hood::unordered_map<u32, CharacterItemData> characterItemData = cache->second;
-		_accessMutex.unlock_shared();
-
-		output = characterItemData;
+		output = cache->second;
 		return true;
 	}
 	else
 	{
+		cacheLock.unlock();
+
 		// We don't have the character, so we load it
 		std::shared_ptr<DatabaseConnector> connector;
 		bool result = DatabaseConnector::Borrow(DATABASE_TYPE::CHARSERVER, connector);
@@ -551,14 +610,15 @@ bool CharacterDatabaseCache::GetCharacterItemData(u64 characterGuid, robin_hood:
 
 			_characteritemDataCache[newCharacterItemData.characterGuid][newCharacterItemData.lowGuid] = newCharacterItemData;
 		}
+		output = _characteritemDataCache[characterGuid];
 		_accessMutex.unlock();
 
-		output = _characteritemDataCache[characterGuid];
 		return true;
 	}
 }
 
 void CharacterData::UpdateCache(u64 characterGuid)
 {
+    std::unique_lock<std::shared_mutex> lock(_cache->_accessMutex);
     _cache->_characterDataCache[characterGuid] = *this;
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 #include "BaseDatabaseCache.h"
+#include <Database/SQLCallbackQueue.h>
 #include <robin_hood.h>
 
+class DatabaseConnector;
+
 // characters table in DB
 class CharacterDatabaseCache;
 struct CharacterData
@@ -165,12 +168,16 @@ public:
     void Save() override;
     void SaveAsync() override;
     
-    void SaveAndUnloadCharacter(u64 characterGuid);
+    // Saves on a SQL worker and unloads once the dispatcher hands the callback back, unless the character logged in again meanwhile
+    void SaveAndUnloadCharacter(u64 characterGuid, SQLCallbackDispatcher const& dispatcher);
+    void CancelUnloadCharacter(u64 characterGuid);
     void SaveCharacter(u64 characterGuid);
     void UnloadCharacter(u64 characterGuid);
 
-    // Character cache
+    // Character cache, a character missing from it is loaded synchronously
     bool GetCharacterData(u64 characterGuid, CharacterData& output);
+    // Only looks at the cache and never blocks on the database, characters in the world are always cached
+    bool GetCachedCharacterData(u64 characterGuid, CharacterData& output);
 
     // Character Visual cache
     bool GetCharacterVisualData(u64 characterGuid, CharacterVisualData& output);
@@ -191,9 +198,21 @@ private:
 	friend CharacterSkillStorage;
 	friend CharacterItemData;
 
+    struct CharacterSaveData
+    {
+        CharacterData characterData;
+        CharacterVisualData characterVisualData;
+        robin_hood::unordered_map<u32, CharacterSpellStorage> characterSpellStorage;
+        robin_hood::unordered_map<u32, CharacterSkillStorage> characterSkillStorage;
+    };
+    void GetCharacterSaveData(u64 characterGuid, CharacterSaveData& output);
+    static void WriteCharacter(DatabaseConnector& connector, u64 characterGuid, const CharacterSaveData& saveData);
+
     robin_hood::unordered_map<u64, CharacterData> _characterDataCache; // Character Guid
     robin_hood::unordered_map<u64, CharacterVisualData> _characterVisualDataCache; // Character Guid
     robin_hood::unordered_map<u64, robin_hood::unordered_map<u32, CharacterSpellStorage>> _characterSpellStorageCache; // Character Guid, Spell Id
     robin_hood::unordered_map<u64, robin_hood::unordered_map<u32, CharacterSkillStorage>> _characterSkillStorageCache; // Character Guid, Skill Id
 	robin_hood::unordered_map<u64, robin_hood::unordered_map<u32, CharacterItemData>> _characteritemDataCache; // Character Guid, Item LowGuid
+    robin_hood::unordered_map<u64, u32> _pendingUnloads; // Character Guid, Unload Generation
+    u32 _unloadGeneration = 0;
 };
\ No newline at end of file
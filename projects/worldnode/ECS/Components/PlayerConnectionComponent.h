@@ -24,14 +24,16 @@
 #pragma once
 #include <NovusTypes.h>
 #include <Networking/ByteBuffer.h>
+#include <Networking/PacketPool.h>
 #include "../../Utils/CharacterUtils.h"
 #include <vector>
+#include <memory>
 
 struct OpcodePacket
 {
     u16 opcode;
     bool handled;
-    Common::ByteBuffer data;
+    Common::PacketHandle data;
 };
 
 class WorldConnection;
@@ -47,6 +49,6 @@ struct PlayerConnectionComponent
     u32 entityGuid;
     u32 accountGuid;
     u64 characterGuid;
-    WorldConnection* socket;
+    std::shared_ptr<WorldConnection> socket;
     std::vector<OpcodePacket> packets;
 };
@@ -23,39 +23,141 @@
 */
 #pragma once
 #include <NovusTypes.h>
-#include <Networking/ByteBuffer.h>
+#include <cstring>
 
 #include "../../NovusEnums.h"
 #include "../../Utils/UpdateMask.h"
+#include "../../Utils/FieldBlockArena.h"
 
+// Object and unit fields plus the player fields that share their last mask word (bytes, flags, duel and guild data), these change every few ticks
+constexpr u32 PLAYER_HOT_FIELD_COUNT = ((UNIT_END + CLIENT_UPDATE_MASK_BITS - 1) / CLIENT_UPDATE_MASK_BITS) * CLIENT_UPDATE_MASK_BITS;
+constexpr u32 PLAYER_COLD_FIELD_COUNT = PLAYER_END - PLAYER_HOT_FIELD_COUNT;
+
+/*
+    The hot fields live inline so the component pool itself is the contiguous hot arena, walking every player to check and send
+    their changes only touches the mask and the hot block. The rarely changing player fields (quest log, inventory, skills, explored zones...)
+    live in a cold block taken from a shared arena.
+*/
 struct PlayerFieldDataComponent
 {
-    PlayerFieldDataComponent() : changesMask(PLAYER_END), playerFields(PLAYER_END * 4) { }
+    typedef FieldBlockArena<PLAYER_COLD_FIELD_COUNT * 4> ColdFieldArena;
+
+    PlayerFieldDataComponent() : _coldFields(GetColdArena().Allocate())
+    {
+        ClearFields();
+    }
+    PlayerFieldDataComponent(PlayerFieldDataComponent&& other) : changesMask(other.changesMask), _coldFields(other._coldFields)
+    {
+        memcpy(_hotFields, other._hotFields, sizeof(_hotFields));
+        other._coldFields = nullptr;
+    }
+    PlayerFieldDataComponent& operator=(PlayerFieldDataComponent&& other)
+    {
+        if (this != &other)
+        {
+            changesMask = other.changesMask;
+            memcpy(_hotFields, other._hotFields, sizeof(_hotFields));
+            std::swap(_coldFields, other._coldFields);
+        }
+        return *this;
+    }
+    PlayerFieldDataComponent(const PlayerFieldDataComponent&) = delete;
+    PlayerFieldDataComponent& operator=(const PlayerFieldDataComponent&) = delete;
+    ~PlayerFieldDataComponent()
+    {
+        GetColdArena().Free(_coldFields);
+    }
 
     void SetGuidValue(u16 index, u64 value)
     {
-        playerFields.WriteAt<u64>(value, index * 4);
+        WriteBytes(index * 4, &value, sizeof(u64));
         changesMask.SetBit(index);
         changesMask.SetBit(index + 1);
     }
     template <typename T>
     void SetFieldValue(u16 index, T value, u8 offset = 0)
     {
-        playerFields.WriteAt<T>(value, (index * 4) + offset);
+        WriteBytes((index * 4) + offset, &value, sizeof(T));
         changesMask.SetBit(index);
     }
     template <typename T>
-    T GetFieldValue(u16 index, u8 offset = 0)
+    T GetFieldValue(u16 index, u8 offset = 0) const
+    {
+        T value;
+        ReadBytes((index * 4) + offset, &value, sizeof(T));
+        return value;
+    }
+    // Points at the 4 bytes of a single field, fields never straddle the hot and cold blocks
+    const u8* GetFieldPointer(u16 index) const
     {
-        return playerFields.ReadAt<T>((index * 4) + offset);
+        return index < PLAYER_HOT_FIELD_COUNT ? &_hotFields[index * 4] : &_coldFields[(index - PLAYER_HOT_FIELD_COUNT) * 4];
     }
     void ResetFields()
     {
-        playerFields.Clean();
-        playerFields.Resize(PLAYER_END * 4);
+        ClearFields();
         changesMask.Reset();
     }
 
-    UpdateMask<1344> changesMask;
-    Common::ByteBuffer playerFields;
-};
+    static ColdFieldArena& GetColdArena()
+    {
+        static ColdFieldArena arena;
+        return arena;
+    }
+
+    FieldChangeMask<PLAYER_END> changesMask;
+
+private:
+    void ClearFields()
+    {
+        memset(_hotFields, 0, sizeof(_hotFields));
+        memset(_coldFields, 0, PLAYER_COLD_FIELD_COUNT * 4);
+    }
+
+    // Byte level copies split at the hot/cold boundary so a value spanning both blocks still ends up in the right place
+    void WriteBytes(u32 position, const void* source, size_t size)
+    {
+        if (position + size <= sizeof(_hotFields))
+        {
+            memcpy(&_hotFields[position], source, size);
+        }
+        else if (position >= sizeof(_hotFields))
+        {
+            memcpy(&_coldFields[position - sizeof(_hotFields)], source, size);
+        }
+        else
+        {
+            const u8* bytes = static_cast<const u8*>(source);
+            for (size_t i = 0; i < size; i++)
+            {
+                u32 bytePosition = position + static_cast<u32>(i);
+                if (bytePosition < sizeof(_hotFields))
+                    _hotFields[bytePosition] = bytes[i];
+                else
+                    _coldFields[bytePosition - sizeof(_hotFields)] = bytes[i];
+            }
+        }
+    }
+    void ReadBytes(u32 position, void* destination, size_t size) const
+    {
+        if (position + size <= sizeof(_hotFields))
+        {
+            memcpy(destination, &_hotFields[position], size);
+        }
+        else if (position >= sizeof(_hotFields))
+        {
+            memcpy(destination, &_coldFields[position - sizeof(_hotFields)], size);
+        }
+        else
+        {
+            u8* bytes = static_cast<u8*>(destination);
+            for (size_t i = 0; i < size; i++)
+            {
+                u32 bytePosition = position + static_cast<u32>(i);
+                bytes[i] = bytePosition < sizeof(_hotFields) ? _hotFields[bytePosition] : _coldFields[bytePosition - sizeof(_hotFields)];
+            }
+        }
+    }
+
+    alignas(64) u8 _hotFields[PLAYER_HOT_FIELD_COUNT * 4];
+    u8* _coldFields;
+};
\ No newline at end of file
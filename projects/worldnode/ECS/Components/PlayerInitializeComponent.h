@@ -23,6 +23,7 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <memory>
 
 class WorldConnection;
 struct PlayerInitializeComponent
@@ -30,5 +31,5 @@ struct PlayerInitializeComponent
 	u32 entityGuid;
 	u32 accountGuid;
 	u64 characterGuid;
-    WorldConnection* socket;
+    std::shared_ptr<WorldConnection> socket;
 };
\ No newline at end of file
@@ -24,9 +24,14 @@
 #pragma once
 #include <NovusTypes.h>
 #include <Networking/ByteBuffer.h>
+#include <Networking/PacketSchema.h>
+#include <Networking/PacketPool.h>
 #include <vector>
+#include <limits>
+#include <robin_hood.h>
 
 #include "../../NovusEnums.h"
+#include "../../Utils/UpdateData.h"
 
 struct PositionUpdateData
 {
@@ -41,20 +46,50 @@ struct PositionUpdateData
     u32 fallTime;
 };
 
+// Movement info following the packed mover guid in every movement opcode
+typedef Common::PacketSchema<PositionUpdateData,
+    &PositionUpdateData::movementFlags, &PositionUpdateData::movementFlagsExtra, &PositionUpdateData::gameTime,
+    &PositionUpdateData::x, &PositionUpdateData::y, &PositionUpdateData::z, &PositionUpdateData::orientation,
+    &PositionUpdateData::fallTime> MovementInfoSchema;
+
 struct ChatUpdateData
 {
     u8 chatType;
     i32 language;
     u64 sender;
+    std::string target; // Channel name or whisper target, CHAT_MSG_CHANNEL_JOIN and CHAT_MSG_CHANNEL_LEAVE carry only the channel
+    u32 channelId;
     std::string message;
     bool handled;
 };
 
+// Fixed part of SMSG_MESSAGECHAT up to the message itself
+struct ChatMessageHeader
+{
+    u8 chatType;
+    i32 language;
+    u64 sender;
+    u32 flags;
+    u64 receiver;
+    u32 messageLength;
+};
+typedef Common::PacketSchema<ChatMessageHeader,
+    &ChatMessageHeader::chatType, &ChatMessageHeader::language, &ChatMessageHeader::sender,
+    &ChatMessageHeader::flags, &ChatMessageHeader::receiver, &ChatMessageHeader::messageLength> ChatMessageHeaderSchema;
+
 struct PlayerUpdateDataComponent
 {
     PlayerUpdateDataComponent() { }
 
-    std::vector<u64> visibleGuids;
+    // Objects this player has been sent a create for, mapped to the visibility pass that last found them in range
+    robin_hood::unordered_map<u64, u32> visibleGuids;
+    // Every update block for this player during the tick, ClientUpdateSystem sends them as a single update packet
+    UpdateData updateAccumulator;
+    // The accumulator built, and compressed if large enough, on a worker before the send phase queues it
+    Common::PacketHandle updatePacket;
+    u16 updatePacketOpcode = 0;
     std::vector<PositionUpdateData> positionUpdateData;
+    u32 heartbeatSequence = 0;
     std::vector<ChatUpdateData> chatUpdateData;
+    std::vector<u32> chatDeliveries; // Chat packets routed to this player during the tick, indices into playerChatPacketQueue
 };
@@ -0,0 +1,53 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <limits>
+#include <robin_hood.h>
+#include <string>
+
+struct ChatMember
+{
+    u32 entity;
+    std::string name;
+};
+
+struct ChatChannel
+{
+    u32 channelId; // Zero for custom channels
+    robin_hood::unordered_map<u32, u64> members; // Player entity to character guid
+};
+
+struct ChatSingleton
+{
+    ChatSingleton() : sayRange(25.0f), yellRange(300.0f), emoteRange(25.0f) { }
+
+    f32 sayRange;
+    f32 yellRange;
+    f32 emoteRange;
+
+    robin_hood::unordered_map<u64, ChatMember> members; // Every character in the world by guid
+    robin_hood::unordered_map<std::string, u64> memberNames; // Lowercase character name to guid, whispers are addressed by name
+    robin_hood::unordered_map<std::string, ChatChannel> channels; // Lowercase channel name
+};
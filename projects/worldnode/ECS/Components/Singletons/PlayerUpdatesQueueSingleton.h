@@ -24,32 +24,41 @@
 #pragma once
 #include <NovusTypes.h>
 #include <Networking/ByteBuffer.h>
+#include <Networking/PacketPool.h>
 #include <vector>
 
-struct PlayerUpdatePacket
+// A single update block, appended to the update accumulator of every player that can see the object
+struct PlayerUpdateBlock
 {
-    u16 opcode;
     u64 characterGuid;
     u8 updateType;
     Common::ByteBuffer data;
 };
 
+// Payloads are encoded once into a shared slab, every receiver only frames its own header in front of it
 struct MovementPacket
 {
     u16 opcode;
     u64 characterGuid;
-    Common::ByteBuffer data;
+    Common::PacketHandle data;
+
+    // Where the mover was, observers use it to pick their heartbeat rate
+    f32 x;
+    f32 y;
+    u32 heartbeatSequence;
+    u32 supersededHeartbeats; // Heartbeats of the same mover this packet made redundant within the tick
 };
 
 struct ChatPacket
 {
-    u32 characterGuid;
-    Common::ByteBuffer data;
+    u16 opcode;
+    u64 characterGuid;
+    Common::PacketHandle data;
 };
 
 struct PlayerUpdatesQueueSingleton
 {
-    std::vector<PlayerUpdatePacket> playerUpdatePacketQueue;
+    std::vector<PlayerUpdateBlock> playerUpdateBlockQueue;
     std::vector<MovementPacket> playerMovementPacketQueue;
     std::vector<ChatPacket> playerChatPacketQueue;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <robin_hood.h>
+#include "../../../Game/SpatialGrid.h"
+
+struct SpatialGridSingleton
+{
+    SpatialGridSingleton() : cellSize(50.0f), visibilityRange(100.0f) { }
+
+    SpatialGrid& GetGrid(u32 mapId)
+    {
+        auto itr = grids.find(mapId);
+        if (itr == grids.end())
+            itr = grids.emplace(mapId, SpatialGrid(cellSize)).first;
+
+        return itr->second;
+    }
+    // Returns nullptr when nothing has been placed on the map yet
+    const SpatialGrid* FindGrid(u32 mapId) const
+    {
+        auto itr = grids.find(mapId);
+        return itr != grids.end() ? &itr->second : nullptr;
+    }
+
+    f32 cellSize;
+    f32 visibilityRange;
+    robin_hood::unordered_map<u32, SpatialGrid> grids;
+    robin_hood::unordered_map<u32, u32> entityMaps; // Map each entity is currently placed on
+};
@@ -0,0 +1,282 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
+#include <Utils/StringUtils.h>
+#include <entt.hpp>
+#include <Networking/ByteBuffer.h>
+
+#include "../../NovusEnums.h"
+#include "../../Game/SpatialGrid.h"
+
+#include "../Components/PlayerConnectionComponent.h"
+#include "../Components/PlayerUpdateDataComponent.h"
+#include "../Components/PlayerPositionComponent.h"
+#include "../Components/Singletons/ChatSingleton.h"
+#include "../Components/Singletons/SpatialGridSingleton.h"
+#include "../Components/Singletons/PlayerUpdatesQueueSingleton.h"
+
+#include <tracy/Tracy.hpp>
+#include <vector>
+
+namespace ChatSystem
+{
+    typedef SystemAccess<Reads<RegistryStorage, SpatialGridSingleton, PlayerConnectionComponent, PlayerPositionComponent>, Writes<ChatSingleton, PlayerUpdateDataComponent, PlayerUpdatesQueueSingleton>> Access;
+
+    // SMSG_CHANNEL_NOTIFY types
+    constexpr u8 CHAT_YOU_JOINED_NOTICE = 0x02;
+    constexpr u8 CHAT_YOU_LEFT_NOTICE = 0x03;
+    constexpr u8 CHANNEL_FLAG_CUSTOM = 0x01;
+
+    // Encodes a packet once and returns its index, every receiver only stores the index
+    u32 QueueChatPacket(PlayerUpdatesQueueSingleton& playerUpdatesQueue, u16 opcode, u64 characterGuid, Common::PacketHandle&& data)
+    {
+        ChatPacket chatPacket;
+        chatPacket.opcode = opcode;
+        chatPacket.characterGuid = characterGuid;
+        chatPacket.data = std::move(data);
+
+        playerUpdatesQueue.playerChatPacketQueue.push_back(std::move(chatPacket));
+        return static_cast<u32>(playerUpdatesQueue.playerChatPacketQueue.size() - 1);
+    }
+
+    u32 QueueMessageChat(PlayerUpdatesQueueSingleton& playerUpdatesQueue, u8 chatType, i32 language, u64 sender, u64 receiver, const std::string* channelName, const std::string& message)
+    {
+        ChatMessageHeader chatHeader;
+        chatHeader.chatType = chatType;
+        chatHeader.language = language;
+        chatHeader.sender = sender;
+        chatHeader.flags = 0; // Chat Flag (??)
+        chatHeader.receiver = receiver;
+        chatHeader.messageLength = static_cast<u32>(message.length()) + 1;
+
+        Common::PacketHandle data = Common::BaseSocket::GetSendPool().Acquire(0);
+        if (channelName)
+        {
+            // Channel messages carry the channel name between the flags and the receiver
+            data->Reserve(ChatMessageHeaderSchema::Size + channelName->length() + 1 + chatHeader.messageLength + 1);
+            data->Write<u8>(chatHeader.chatType);
+            data->Write<i32>(chatHeader.language);
+            data->Write<u64>(chatHeader.sender);
+            data->Write<u32>(chatHeader.flags);
+            data->WriteString(*channelName);
+            data->Write<u64>(chatHeader.receiver);
+            data->Write<u32>(chatHeader.messageLength);
+        }
+        else
+        {
+            data->Reserve(ChatMessageHeaderSchema::Size + chatHeader.messageLength + 1);
+            ChatMessageHeaderSchema::Write(*data, chatHeader);
+        }
+        data->WriteString(message);
+        data->Write<u8>(0); // Chat Tag
+
+        return QueueChatPacket(playerUpdatesQueue, Common::Opcode::SMSG_MESSAGECHAT, sender, std::move(data));
+    }
+
+    f32 GetListenRange(const ChatSingleton& chat, u8 chatType)
+    {
+        switch (chatType)
+        {
+            case CHAT_MSG_YELL:
+                return chat.yellRange;
+            case CHAT_MSG_EMOTE:
+            case CHAT_MSG_TEXT_EMOTE:
+                return chat.emoteRange;
+            default:
+                return chat.sayRange;
+        }
+    }
+
+    void RouteNearby(entt::registry& registry, const SpatialGridSingleton& spatialGrid, const PlayerPositionComponent& senderPosition, f32 range, u32 packetIndex)
+    {
+        const SpatialGrid* grid = spatialGrid.FindGrid(senderPosition.mapId);
+        if (!grid)
+            return;
+
+        // The sender is on the grid as well, so they get their own message back like the client expects
+        grid->QueryRadius(senderPosition.x, senderPosition.y, range, [&registry, packetIndex](const SpatialGrid::Entry& entry)
+        {
+            registry.get<PlayerUpdateDataComponent>(entry.entity).chatDeliveries.push_back(packetIndex);
+        });
+    }
+
+    void RouteWhisper(entt::registry& registry, ChatSingleton& chat, PlayerUpdatesQueueSingleton& playerUpdatesQueue, PlayerUpdateDataComponent& senderUpdateData, const ChatUpdateData& chatData)
+    {
+        auto nameItr = chat.memberNames.find(StringUtils::ToLower(chatData.target));
+        if (nameItr == chat.memberNames.end())
+        {
+            Common::PacketHandle notFound = Common::BaseSocket::GetSendPool().Acquire(0);
+            notFound->WriteString(chatData.target);
+            senderUpdateData.chatDeliveries.push_back(QueueChatPacket(playerUpdatesQueue, Common::Opcode::SMSG_CHAT_PLAYER_NOT_FOUND, chatData.sender, std::move(notFound)));
+            return;
+        }
+
+        u64 receiverGuid = nameItr->second;
+        const ChatMember& receiver = chat.members[receiverGuid];
+
+        // The receiver sees the whisper from the sender, the sender gets it echoed back as addressed to the receiver
+        u32 whisperIndex = QueueMessageChat(playerUpdatesQueue, CHAT_MSG_WHISPER, chatData.language, chatData.sender, chatData.sender, nullptr, chatData.message);
+        registry.get<PlayerUpdateDataComponent>(receiver.entity).chatDeliveries.push_back(whisperIndex);
+
+        u32 informIndex = QueueMessageChat(playerUpdatesQueue, CHAT_MSG_WHISPER_INFORM, LANG_UNIVERSAL, receiverGuid, receiverGuid, nullptr, chatData.message);
+        senderUpdateData.chatDeliveries.push_back(informIndex);
+    }
+
+    void RouteChannel(entt::registry& registry, ChatSingleton& chat, PlayerUpdatesQueueSingleton& playerUpdatesQueue, u32 senderEntity, const ChatUpdateData& chatData)
+    {
+        auto channelItr = chat.channels.find(StringUtils::ToLower(chatData.target));
+        if (channelItr == chat.channels.end())
+            return;
+
+        ChatChannel& channel = channelItr->second;
+        if (channel.members.find(senderEntity) == channel.members.end())
+            return;
+
+        u32 packetIndex = QueueMessageChat(playerUpdatesQueue, CHAT_MSG_CHANNEL, chatData.language, chatData.sender, 0, &chatData.target, chatData.message);
+        for (auto& member : channel.members)
+        {
+            registry.get<PlayerUpdateDataComponent>(member.first).chatDeliveries.push_back(packetIndex);
+        }
+    }
+
+    void JoinChannel(ChatSingleton& chat, PlayerUpdatesQueueSingleton& playerUpdatesQueue, u32 senderEntity, PlayerUpdateDataComponent& senderUpdateData, const ChatUpdateData& chatData)
+    {
+        std::string channelName = StringUtils::ToLower(chatData.target);
+        auto channelItr = chat.channels.find(channelName);
+        if (channelItr == chat.channels.end())
+        {
+            // The client sends the id of built in channels with the join, custom channels have none
+            ChatChannel channel;
+            channel.channelId = chatData.channelId;
+            channelItr = chat.channels.emplace(channelName, std::move(channel)).first;
+        }
+
+        ChatChannel& channel = channelItr->second;
+        channel.members[senderEntity] = chatData.sender;
+
+        Common::PacketHandle notify = Common::BaseSocket::GetSendPool().Acquire(0);
+        notify->Write<u8>(CHAT_YOU_JOINED_NOTICE);
+        notify->WriteString(chatData.target);
+        notify->Write<u8>(channel.channelId == 0 ? CHANNEL_FLAG_CUSTOM : 0);
+        notify->Write<u32>(channel.channelId);
+        notify->Write<u32>(0);
+        senderUpdateData.chatDeliveries.push_back(QueueChatPacket(playerUpdatesQueue, Common::Opcode::SMSG_CHANNEL_NOTIFY, chatData.sender, std::move(notify)));
+    }
+
+    void LeaveChannel(ChatSingleton& chat, PlayerUpdatesQueueSingleton& playerUpdatesQueue, u32 senderEntity, PlayerUpdateDataComponent& senderUpdateData, const ChatUpdateData& chatData)
+    {
+        auto channelItr = chat.channels.find(StringUtils::ToLower(chatData.target));
+        if (channelItr == chat.channels.end() || channelItr->second.members.erase(senderEntity) == 0)
+            return;
+
+        u32 channelId = channelItr->second.channelId;
+        if (channelItr->second.members.empty())
+            chat.channels.erase(channelItr);
+
+        Common::PacketHandle notify = Common::BaseSocket::GetSendPool().Acquire(0);
+        notify->Write<u8>(CHAT_YOU_LEFT_NOTICE);
+        notify->WriteString(chatData.target);
+        notify->Write<u32>(channelId);
+        notify->Write<u8>(0);
+        senderUpdateData.chatDeliveries.push_back(QueueChatPacket(playerUpdatesQueue, Common::Opcode::SMSG_CHANNEL_NOTIFY, chatData.sender, std::move(notify)));
+    }
+
+    // Called by PlayerDeleteSystem, the entity id gets reused so it can't stay in any channel
+    void RemoveMember(ChatSingleton& chat, u64 characterGuid, u32 entity)
+    {
+        // A character that logged back in before its old entity was deleted is already registered with the new one
+        auto memberItr = chat.members.find(characterGuid);
+        if (memberItr != chat.members.end() && memberItr->second.entity == entity)
+        {
+            chat.memberNames.erase(StringUtils::ToLower(memberItr->second.name));
+            chat.members.erase(memberItr);
+        }
+
+        for (auto channelItr = chat.channels.begin(); channelItr != chat.channels.end();)
+        {
+            channelItr->second.members.erase(entity);
+            if (channelItr->second.members.empty())
+                channelItr = chat.channels.erase(channelItr);
+            else
+                ++channelItr;
+        }
+    }
+
+    /*
+        Every message is encoded once and only handed to the players that should hear it: say, yell and emotes by their
+        listen range around the sender, channel messages to the channel's members and whispers to the addressed character.
+        Receivers keep indices into the chat queue, ClientUpdateSystem sends each player's chat along with the rest of their tick.
+    */
+    void Update(entt::registry &registry)
+    {
+        ChatSingleton& chat = registry.ctx<ChatSingleton>();
+        SpatialGridSingleton& spatialGrid = registry.ctx<SpatialGridSingleton>();
+        PlayerUpdatesQueueSingleton& playerUpdatesQueue = registry.ctx<PlayerUpdatesQueueSingleton>();
+
+        auto view = registry.view<PlayerConnectionComponent, PlayerUpdateDataComponent, PlayerPositionComponent>();
+        view.each([&registry, &chat, &spatialGrid, &playerUpdatesQueue](const auto entity, PlayerConnectionComponent&, PlayerUpdateDataComponent& playerUpdateData, PlayerPositionComponent& playerPosition)
+        {
+            if (playerUpdateData.chatUpdateData.empty())
+                return;
+
+            ZoneScopedNC("ChatUpdate", tracy::Color::Yellow2)
+            u32 senderEntity = static_cast<u32>(entity);
+
+            for (const ChatUpdateData& chatData : playerUpdateData.chatUpdateData)
+            {
+                switch (chatData.chatType)
+                {
+                    case CHAT_MSG_SAY:
+                    case CHAT_MSG_YELL:
+                    case CHAT_MSG_EMOTE:
+                    case CHAT_MSG_TEXT_EMOTE:
+                    {
+                        u32 packetIndex = QueueMessageChat(playerUpdatesQueue, chatData.chatType, chatData.language, chatData.sender, 0, nullptr, chatData.message);
+                        RouteNearby(registry, spatialGrid, playerPosition, GetListenRange(chat, chatData.chatType), packetIndex);
+                        break;
+                    }
+                    case CHAT_MSG_WHISPER:
+                        RouteWhisper(registry, chat, playerUpdatesQueue, playerUpdateData, chatData);
+                        break;
+                    case CHAT_MSG_CHANNEL:
+                        RouteChannel(registry, chat, playerUpdatesQueue, senderEntity, chatData);
+                        break;
+                    case CHAT_MSG_CHANNEL_JOIN:
+                        JoinChannel(chat, playerUpdatesQueue, senderEntity, playerUpdateData, chatData);
+                        break;
+                    case CHAT_MSG_CHANNEL_LEAVE:
+                        LeaveChannel(chat, playerUpdatesQueue, senderEntity, playerUpdateData, chatData);
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            // Clear Chat Updates
+            playerUpdateData.chatUpdateData.clear();
+        });
+    }
+}
@@ -23,78 +23,180 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <entt.hpp>
 
 #include "../../NovusEnums.h"
+#include "../../Utils/UpdateData.h"
+#include "../../Game/MovementRelay.h"
 
+#include "../Components/PlayerConnectionComponent.h"
+#include "../Components/PlayerUpdateDataComponent.h"
 #include "../Components/PlayerPositionComponent.h"
 #include "../Components/UnitStatusComponent.h"
 #include "../Components/Singletons/SingletonComponent.h"
 #include "../Components/Singletons/PlayerUpdatesQueueSingleton.h"
 #include "../Components/Singletons/PlayerPacketQueueSingleton.h"
+#include <tracy/Tracy.hpp>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 namespace ClientUpdateSystem
 {
-    void Update(entt::registry &registry)
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, PlayerPositionComponent>, Writes<PlayerConnectionComponent, PlayerUpdateDataComponent, PlayerUpdatesQueueSingleton, PlayerPacketQueueSingleton>> Access;
+
+    // Building and compressing update packets is the expensive part of sending, below this many receivers a chunk isn't worth its own task
+    constexpr size_t MIN_RECEIVERS_PER_CHUNK = 16;
+
+    void BuildUpdatePacket(const PlayerUpdatesQueueSingleton& playerUpdatesQueue, const PlayerConnectionComponent& playerConnection, PlayerUpdateDataComponent& playerUpdateData)
     {
-        SingletonComponent& singleton = registry.ctx<SingletonComponent>();
+        // Values only go to observers that were sent a create for the object, everything for this player in the tick leaves as one update packet
+        UpdateData& updateAccumulator = playerUpdateData.updateAccumulator;
+        for (const PlayerUpdateBlock& playerUpdateBlock : playerUpdatesQueue.playerUpdateBlockQueue)
+        {
+            // So far we have not observed any issues with sending private field flags to any other client but themselves, this offers a good speed increase but if we see issues in the future we should recheck this.
+            if (playerUpdateBlock.characterGuid == playerConnection.characterGuid || playerUpdateData.visibleGuids.find(playerUpdateBlock.characterGuid) != playerUpdateData.visibleGuids.end())
+            {
+                updateAccumulator.AddBlock(playerUpdateBlock.data);
+            }
+        }
+
+        if (updateAccumulator.IsEmpty())
+            return;
+
+        Common::PacketHandle packet = Common::BaseSocket::GetSendPool().Acquire(0);
+        if (updateAccumulator.Build(*packet, playerUpdateData.updatePacketOpcode))
+            playerUpdateData.updatePacket = std::move(packet);
+
+        updateAccumulator.Clear();
+    }
+
+    tf::Task Update(entt::registry &registry, tf::SubflowBuilder& subflow)
+    {
+        static std::vector<entt::registry::entity_type> entities;
+
         PlayerUpdatesQueueSingleton& playerUpdatesQueue = registry.ctx<PlayerUpdatesQueueSingleton>();
         PlayerPacketQueueSingleton& playerPacketQueue = registry.ctx<PlayerPacketQueueSingleton>();
 
         auto view = registry.view<PlayerConnectionComponent, PlayerUpdateDataComponent>();
-        view.each([playerUpdatesQueue](const auto, PlayerConnectionComponent& playerConnection, PlayerUpdateDataComponent& playerUpdateData)
+        entities.assign(view.begin(), view.end());
+
+        size_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunkSize = std::max(MIN_RECEIVERS_PER_CHUNK, (entities.size() + workerCount - 1) / workerCount);
+        size_t chunkCount = (entities.size() + chunkSize - 1) / chunkSize;
+
+        // Payloads were encoded once by the systems that queued them, every receiver only frames and encrypts its own headers
+        tf::Task sendPackets = subflow.emplace([&registry, &playerUpdatesQueue, &playerPacketQueue, view]()
         {
-            for (PlayerUpdatePacket playerUpdatePacket : playerUpdatesQueue.playerUpdatePacketQueue)
+            ZoneScopedNC("ClientUpdate::Send", tracy::Color::Blue2)
+            Access::Scope scope;
+
+            LockRead(PlayerPositionComponent);
+            LockWrite(PlayerConnectionComponent);
+            LockWrite(PlayerUpdateDataComponent);
+            LockWrite(PlayerUpdatesQueueSingleton);
+            LockWrite(PlayerPacketQueueSingleton);
+
+            u64 relayedPackets = 0, relayedBytes = 0, coalescedPackets = 0, coalescedBytes = 0, decimatedPackets = 0, decimatedBytes = 0;
+            for (entt::registry::entity_type entity : entities)
             {
-                if ((playerUpdatePacket.updateType == UPDATETYPE_CREATE_OBJECT ||
-                    playerUpdatePacket.updateType == UPDATETYPE_CREATE_OBJECT2) &&
-                    playerUpdatePacket.characterGuid != playerConnection.characterGuid)
+                auto [playerConnection, playerUpdateData] = view.get<PlayerConnectionComponent, PlayerUpdateDataComponent>(entity);
+                const PlayerPositionComponent& playerPosition = registry.get<PlayerPositionComponent>(entity);
+
+                if (playerUpdateData.updatePacket)
                 {
-                    if (std::find(playerUpdateData.visibleGuids.begin(), playerUpdateData.visibleGuids.end(), playerUpdatePacket.characterGuid) == playerUpdateData.visibleGuids.end())
-                    {
-                        playerConnection.socket->SendPacket(playerUpdatePacket.data, playerUpdatePacket.opcode);
-                        playerUpdateData.visibleGuids.push_back(playerUpdatePacket.characterGuid);
-                    }
+                    playerConnection.socket->QueuePacket(playerUpdateData.updatePacket, playerUpdateData.updatePacketOpcode);
+                    playerUpdateData.updatePacket.Reset();
                 }
-                else if (playerUpdatePacket.updateType == UPDATETYPE_VALUES)
+
+                for (const MovementPacket& movementPacket : playerUpdatesQueue.playerMovementPacketQueue)
                 {
-                    // So far we have not observed any issues with sending private field flags to any other client but themselves, this offers a good speed increase but if we see issues in the future we should recheck this.
-                    // if (playerUpdatePacket.characterGuid != playerConnection.characterGuid)
+                    if (playerUpdateData.visibleGuids.find(movementPacket.characterGuid) == playerUpdateData.visibleGuids.end())
+                        continue;
+
+                    u64 packetBytes = movementPacket.data->size() + MovementRelay::PACKET_HEADER_SIZE;
+                    coalescedPackets += movementPacket.supersededHeartbeats;
+                    coalescedBytes += movementPacket.supersededHeartbeats * packetBytes;
+
+                    if (MovementRelay::IsHeartbeat(movementPacket.opcode))
                     {
-                        playerConnection.socket->SendPacket(playerUpdatePacket.data, playerUpdatePacket.opcode);
+                        f32 dx = movementPacket.x - playerPosition.x;
+                        f32 dy = movementPacket.y - playerPosition.y;
+                        if (!MovementRelay::ShouldRelayHeartbeat(movementPacket.heartbeatSequence, dx * dx + dy * dy))
+                        {
+                            decimatedPackets++;
+                            decimatedBytes += packetBytes;
+                            continue;
+                        }
                     }
+
+                    relayedPackets++;
+                    relayedBytes += packetBytes;
+                    playerConnection.socket->QueueMovementPacket(movementPacket.data, movementPacket.opcode, movementPacket.characterGuid);
                 }
-            }
 
-            for (MovementPacket movementPacket : playerUpdatesQueue.playerMovementPacketQueue)
-            {
-                if (playerConnection.characterGuid != movementPacket.characterGuid)
+                // ChatSystem already picked who hears what, every message was encoded once and is shared by all of its receivers
+                for (u32 chatPacketIndex : playerUpdateData.chatDeliveries)
                 {
-                    playerConnection.socket->SendPacket(movementPacket.data, movementPacket.opcode);
+                    const ChatPacket& chatPacket = playerUpdatesQueue.playerChatPacketQueue[chatPacketIndex];
+                    playerConnection.socket->QueuePacket(chatPacket.data, chatPacket.opcode);
                 }
+                playerUpdateData.chatDeliveries.clear();
+
+                playerConnection.socket->FlushPackets();
             }
 
-            for (ChatPacket chatPacket : playerUpdatesQueue.playerChatPacketQueue)
+            MovementRelayStats& relayStats = MovementRelay::GetStats();
+            relayStats.relayedPackets += relayedPackets;
+            relayStats.relayedBytes += relayedBytes;
+            relayStats.coalescedPackets += coalescedPackets;
+            relayStats.coalescedBytes += coalescedBytes;
+            relayStats.decimatedPackets += decimatedPackets;
+            relayStats.decimatedBytes += decimatedBytes;
+
+            // These packets should already include headers and data.
+            PacketQueueData packet;
+            while (playerPacketQueue.packetQueue->try_dequeue(packet))
             {
-                playerConnection.socket->SendPacket(chatPacket.data, Common::Opcode::SMSG_MESSAGECHAT);
+                packet.connection->SendPacket(packet.data, packet.opcode);
             }
+
+            // Clear Queues
+            if (playerUpdatesQueue.playerUpdateBlockQueue.size() != 0)
+                playerUpdatesQueue.playerUpdateBlockQueue.clear();
+
+            if (playerUpdatesQueue.playerMovementPacketQueue.size() != 0)
+                playerUpdatesQueue.playerMovementPacketQueue.clear();
+
+            if (playerUpdatesQueue.playerChatPacketQueue.size() != 0)
+                playerUpdatesQueue.playerChatPacketQueue.clear();
         });
 
-        // These packets should already include headers and data.
-        PacketQueueData packet;
-        while (playerPacketQueue.packetQueue->try_dequeue(packet))
+        // Update packets are built and compressed on the workers, every receiver only touches its own accumulator
+        for (size_t chunk = 0; chunk < chunkCount; chunk++)
         {
-            packet.connection->SendPacket(packet.data, packet.opcode);
-        }
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(begin + chunkSize, entities.size());
 
-        // Clear Queues
-        if (playerUpdatesQueue.playerUpdatePacketQueue.size() != 0)
-            playerUpdatesQueue.playerUpdatePacketQueue.clear();
+            tf::Task buildTask = subflow.emplace([&playerUpdatesQueue, view, begin, end]()
+            {
+                ZoneScopedNC("ClientUpdate::Build", tracy::Color::Blue2)
+                Access::Scope scope;
 
-        if (playerUpdatesQueue.playerMovementPacketQueue.size() != 0)
-            playerUpdatesQueue.playerMovementPacketQueue.clear();
+                LockRead(PlayerConnectionComponent);
+                LockRead(PlayerUpdatesQueueSingleton);
+                LockWrite(PlayerUpdateDataComponent);
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    auto [playerConnection, playerUpdateData] = view.get<PlayerConnectionComponent, PlayerUpdateDataComponent>(entities[i]);
+                    BuildUpdatePacket(playerUpdatesQueue, playerConnection, playerUpdateData);
+                }
+            });
+            buildTask.precede(sendPackets);
+        }
 
-        if (playerUpdatesQueue.playerChatPacketQueue.size() != 0)
-            playerUpdatesQueue.playerChatPacketQueue.clear();
+        return sendPackets;
     }
 }
@@ -23,6 +23,7 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <Utils/StringUtils.h>
 #include <entt.hpp>
 
@@ -30,12 +31,18 @@
 
 #include "../Components/PlayerConnectionComponent.h"
 #include "../Components/PlayerUpdateDataComponent.h"
+#include "../Components/PlayerFieldDataComponent.h"
+#include "../Components/PlayerPositionComponent.h"
 #include "../Components/Singletons/SingletonComponent.h"
 #include "../Components/Singletons/CommandDataSingleton.h"
 #include "../Components/Singletons/PlayerUpdatesQueueSingleton.h"
+#include "../Components/Singletons/PlayerPacketQueueSingleton.h"
+#include "../Components/Singletons/WorldDatabaseCacheSingleton.h"
 
 namespace CommandParserSystem
 {
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, CommandDataSingleton, WorldDatabaseCacheSingleton>, Writes<PlayerConnectionComponent, PlayerUpdateDataComponent, PlayerFieldDataComponent, PlayerPositionComponent, PlayerPacketQueueSingleton>> Access;
+
     std::vector<std::string> SplitString(std::string string)
     {
         std::istringstream iss(string);
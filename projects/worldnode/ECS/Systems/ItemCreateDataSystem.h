@@ -23,6 +23,7 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <entt.hpp>
 #include <Networking/ByteBuffer.h>
 
@@ -33,12 +34,15 @@
 #include "../Components/ItemDataComponent.h"
 #include "../Components/ItemInitializeComponent.h"
 #include "../Components/ItemFieldDataComponent.h"
+#include "../Components/PlayerUpdateDataComponent.h"
 #include "../Components/Singletons/SingletonComponent.h"
 #include "../Components/Singletons/PlayerUpdatesQueueSingleton.h"
 
 namespace ItemCreateDataSystem
 {
-    Common::ByteBuffer BuildItemCreateData(u64 itemGuid, u8 updateType, u16 updateFlags, u32 visibleFlags, ItemFieldDataComponent& itemFieldData, u16& opcode)
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, ItemFieldDataComponent>, Writes<ItemInitializeComponent, PlayerUpdateDataComponent>> Access;
+
+    Common::ByteBuffer BuildItemCreateBlock(u64 itemGuid, u8 updateType, u16 updateFlags, u32 visibleFlags, ItemFieldDataComponent& itemFieldData)
     {
         Common::ByteBuffer buffer(500);
         buffer.Write<u8>(updateType);
@@ -75,13 +79,7 @@ namespace ItemCreateDataSystem
         updateMask.AddTo(buffer);
         buffer.Append(fieldBuffer);
 
-        UpdateData updateData;
-        updateData.AddBlock(buffer);
-
-        Common::ByteBuffer tempBuffer;
-        updateData.Build(tempBuffer, opcode);
-
-        return tempBuffer;
+        return buffer;
     }
 
     void Update(entt::registry &registry)
@@ -93,14 +91,16 @@ namespace ItemCreateDataSystem
         {
             itemView.each([&](const auto, ItemInitializeComponent& itemInitializeData, ItemFieldDataComponent& itemFieldData)
             {
-                /* Build Self Packet, must be sent immediately */
+                /* Build Self Packet, it goes out with the rest of the owner's update blocks this tick */
                 u8 updateType = UPDATETYPE_CREATE_OBJECT;
                 u16 selfUpdateFlag = UPDATEFLAG_LOWGUID;
                 u32 selfVisibleFlags = (UF_FLAG_PUBLIC | UF_FLAG_OWNER);
-                u16 buildOpcode = 0;
 
-                Common::ByteBuffer selfItemUpdate = BuildItemCreateData(itemInitializeData.itemGuid, updateType, selfUpdateFlag, selfVisibleFlags, itemFieldData, buildOpcode);
-                //novusConnection.SendPacket(itemInitializeData.accountGuid, selfItemUpdate, buildOpcode);
+                if (registry.valid(itemInitializeData.clientEntityGuid) && registry.has<PlayerUpdateDataComponent>(itemInitializeData.clientEntityGuid))
+                {
+                    PlayerUpdateDataComponent& ownerUpdateData = registry.get<PlayerUpdateDataComponent>(itemInitializeData.clientEntityGuid);
+                    ownerUpdateData.updateAccumulator.AddBlock(BuildItemCreateBlock(itemInitializeData.itemGuid, updateType, selfUpdateFlag, selfVisibleFlags, itemFieldData));
+                }
 
                 Common::ByteBuffer itemPushResult;
                 itemPushResult.Write<u64>(itemInitializeData.characterGuid);
@@ -23,6 +23,7 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <entt.hpp>
 #include <Networking/ByteBuffer.h>
 
@@ -38,6 +39,8 @@
 
 namespace ItemCreateSystem
 {
+    typedef SystemAccess<Reads<SingletonComponent, CharacterDatabaseCacheSingleton>, Writes<RegistryStorage, ItemCreateQueueSingleton, ItemDataComponent, ItemInitializeComponent, ItemFieldDataComponent>> Access;
+
     void Update(entt::registry &registry)
     {
 		SingletonComponent& singleton = registry.ctx<SingletonComponent>();
@@ -1,5 +1,6 @@
 #include "PlayerConnectionSystem.h"
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <Networking/Opcode/Opcode.h>
 
 #include "../../NovusEnums.h"
@@ -14,6 +15,8 @@
 
 namespace ItemInitializeSystem
 {
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, WorldDatabaseCacheSingleton, ItemInitializeComponent>, Writes<ItemFieldDataComponent>> Access;
+
     void Update(entt::registry &registry)
     {
         SingletonComponent& singleton = registry.ctx<SingletonComponent>();
@@ -30,6 +30,8 @@
 #include <Math/Math.h>
 #include <Math/Vector2.h>
 #include <Cryptography/HMAC.h>
+#include <Networking/PacketSchema.h>
+#include <Database/DatabaseConnector.h>
 
 #include "../../NovusEnums.h"
 #include "../../Utils/CharacterUtils.h"
@@ -49,588 +51,861 @@
 #include "../Components/Singletons/MapSingleton.h"
 
 #include <tracy/Tracy.hpp>
+#include <array>
+#include <thread>
+#include <vector>
 
 namespace ConnectionSystem
 {
-    void Update(entt::registry &registry)
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, CharacterDatabaseCacheSingleton, WorldDatabaseCacheSingleton, MapSingleton>, Writes<PlayerConnectionComponent, PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerPositionComponent, PlayerDeleteQueueSingleton, PlayerPacketQueueSingleton>> Access;
+
+    // Connections are handled in parallel chunks of at least this many players
+    constexpr size_t MIN_CONNECTIONS_PER_CHUNK = 32;
+
+    // The parts of the character the tick owns, merged into the cached character when the side effects are applied
+    struct LoggedOutPlayer
     {
-        SingletonComponent& singleton = registry.ctx<SingletonComponent>();
-        PlayerDeleteQueueSingleton& playerDeleteQueue = registry.ctx<PlayerDeleteQueueSingleton>();
-        CharacterDatabaseCacheSingleton& characterDatabase = registry.ctx<CharacterDatabaseCacheSingleton>();
-        WorldDatabaseCacheSingleton& worldDatabase = registry.ctx<WorldDatabaseCacheSingleton>();
-        PlayerPacketQueueSingleton& playerPacketQueue = registry.ctx<PlayerPacketQueueSingleton>();
-        WorldNodeHandler& worldNodeHandler = *singleton.worldNodeHandler;
-		MapSingleton& mapSingleton = registry.ctx<MapSingleton>();
+        ExpiredPlayerData expiredPlayerData;
+        u8 level;
+        u32 mapId;
+        f32 coordinateX;
+        f32 coordinateY;
+        f32 coordinateZ;
+        f32 orientation;
+    };
+
+    // Name query for a character that isn't cached, answered from a SQL worker once the chunks are done
+    struct PendingNameQuery
+    {
+        std::shared_ptr<WorldConnection> socket;
+        u64 guid;
+    };
 
-        LockRead(SingletonComponent);
-        LockRead(PlayerDeleteQueueSingleton);
-        LockRead(CharacterDatabaseCacheSingleton);
+    // Side effects reaching past the player's own components, buffered per chunk and applied in chunk order after all chunks finished.
+    // Chunks only ever look at the character cache, anything that needs the database is resolved here
+    struct ConnectionSideEffects
+    {
+        std::vector<PacketQueueData> packets;
+        std::vector<LoggedOutPlayer> loggedOutPlayers;
+        std::vector<PendingNameQuery> nameQueries;
+    };
 
-        LockWrite(PlayerConnectionComponent);
-        LockWrite(PlayerFieldDataComponent);
-        LockWrite(PlayerUpdateDataComponent);
-        LockWrite(PlayerPositionComponent);
+    struct PacketContext
+    {
+        SingletonComponent& singleton;
+        CharacterDatabaseCacheSingleton& characterDatabase;
+        WorldDatabaseCacheSingleton& worldDatabase;
+        WorldNodeHandler& worldNodeHandler;
+        MapSingleton& mapSingleton;
+        ConnectionSideEffects& sideEffects;
+
+        PlayerConnectionComponent& clientConnection;
+        PlayerFieldDataComponent& clientFieldData;
+        PlayerUpdateDataComponent& clientUpdateData;
+        PlayerPositionComponent& clientPositionData;
+    };
+
+    // CMSG_MESSAGECHAT, the message and any channel or whisper target follow
+    struct ChatMessageRequest
+    {
+        u32 type;
+        u32 language;
+    };
+    typedef Common::PacketSchema<ChatMessageRequest, &ChatMessageRequest::type, &ChatMessageRequest::language> ChatMessageRequestSchema;
 
-        auto view = registry.view<PlayerConnectionComponent, PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerPositionComponent>();
-        view.each([&singleton, &playerDeleteQueue, &characterDatabase, &worldDatabase, &playerPacketQueue, &worldNodeHandler, &mapSingleton](const auto, PlayerConnectionComponent& clientConnection, PlayerFieldDataComponent& clientFieldData, PlayerUpdateDataComponent& clientUpdateData, PlayerPositionComponent& clientPositionData)
-        {
-            ZoneScopedNC("Connection", tracy::Color::Orange2)
+    // Longest channel name or whisper target we accept
+    constexpr size_t MAX_CHAT_TARGET_LENGTH = 64;
 
-                for (OpcodePacket& packet : clientConnection.packets)
-                {
-                    ZoneScopedNC("Packet", tracy::Color::Orange2)
+    // SMSG_NAME_QUERY_RESPONSE, follows the packed guid, name unknown flag and name
+    struct NameQueryDetails
+    {
+        u8 realmName; // Empty string for characters on this realm
+        u8 race;
+        u8 gender;
+        u8 classId;
+        u8 declinedNames;
+    };
+    typedef Common::PacketSchema<NameQueryDetails, &NameQueryDetails::realmName, &NameQueryDetails::race, &NameQueryDetails::gender, &NameQueryDetails::classId, &NameQueryDetails::declinedNames> NameQueryDetailsSchema;
+
+    // Packet handlers return true once the packet has been consumed, payload sizes were already checked by WorldConnection
+    typedef bool (*PacketHandler)(PacketContext&, OpcodePacket&);
+
+    bool HandleSetActiveMover(PacketContext& context, OpcodePacket&)
+    {
+        ZoneScopedNC("Packet::SetActiveMover", tracy::Color::Orange2)
 
-                        Common::Opcode opcode = static_cast<Common::Opcode>(packet.opcode);
-                    switch (static_cast<Common::Opcode>(packet.opcode))
-                    {
-                    case Common::Opcode::CMSG_SET_ACTIVE_MOVER:
-                    {
-                        ZoneScopedNC("Packet::SetActiveMover", tracy::Color::Orange2)
+        Common::ByteBuffer timeSync(9 + 4);
+        timeSync.Write<u32>(0);
 
-                            Common::ByteBuffer timeSync(9 + 4);
-                        timeSync.Write<u32>(0);
+        context.sideEffects.packets.push_back(PacketQueueData(context.clientConnection.socket.get(), timeSync, Common::Opcode::SMSG_TIME_SYNC_REQ));
+        return true;
+    }
 
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, timeSync, Common::Opcode::SMSG_TIME_SYNC_REQ));
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_LOGOUT_REQUEST:
-                    {
-                        ZoneScopedNC("Packet::LogoutRequest", tracy::Color::Orange2)
+    bool HandleLogoutRequest(PacketContext& context, OpcodePacket&)
+    {
+        ZoneScopedNC("Packet::LogoutRequest", tracy::Color::Orange2)
 
-                            Common::ByteBuffer logoutRequest(0);
+        PlayerConnectionComponent& clientConnection = context.clientConnection;
+        PlayerPositionComponent& clientPositionData = context.clientPositionData;
 
-                        //playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, logoutRequest, Common::Opcode::SMSG_LOGOUT_COMPLETE));
-                        clientConnection.socket->SendPacket(logoutRequest, Common::Opcode::SMSG_LOGOUT_COMPLETE);
+        Common::ByteBuffer logoutRequest(0);
+        clientConnection.socket->SendPacket(logoutRequest, Common::Opcode::SMSG_LOGOUT_COMPLETE);
 
-                        // Here we need to Redirect the client back to Realmserver
-                        Common::ByteBuffer redirectClient;
-                        i32 ip = 16777343;
-                        i16 port = 8000;
+        // Here we need to Redirect the client back to Realmserver
+        Common::ByteBuffer redirectClient;
+        i32 ip = 16777343;
+        i16 port = 8000;
 
-                        // 127.0.0.1/1.0.0.127
-                        // 2130706433/16777343(https://www.browserling.com/tools/ip-to-dec)
-                        redirectClient.Write<i32>(ip);
-                        redirectClient.Write<i16>(port);
-                        redirectClient.Write<i32>(0); // unk
+        // 127.0.0.1/1.0.0.127
+        // 2130706433/16777343(https://www.browserling.com/tools/ip-to-dec)
+        redirectClient.Write<i32>(ip);
+        redirectClient.Write<i16>(port);
+        redirectClient.Write<i32>(0); // unk
 #pragma warning(push)
 #pragma warning(disable: 4312)
-                        HMACH hmac(40, clientConnection.socket->sessionKey.BN2BinArray(20).get());
-                        hmac.UpdateHash((u8*)& ip, 4);
-                        hmac.UpdateHash((u8*)& port, 2);
-                        hmac.Finish();
-                        redirectClient.Append(hmac.GetData(), 20);
+        HMACH hmac(40, clientConnection.socket->sessionKey.BN2BinArray(20).get());
+        hmac.UpdateHash((u8*)& ip, 4);
+        hmac.UpdateHash((u8*)& port, 2);
+        hmac.Finish();
+        redirectClient.Append(hmac.GetData(), 20);
 #pragma warning(pop)
-                        clientConnection.socket->SendPacket(redirectClient, Common::Opcode::SMSG_REDIRECT_CLIENT);
-
-                        ExpiredPlayerData expiredPlayerData;
-                        expiredPlayerData.entityGuid = clientConnection.entityGuid;
-                        expiredPlayerData.accountGuid = clientConnection.accountGuid;
-                        expiredPlayerData.characterGuid = clientConnection.characterGuid;
-                        playerDeleteQueue.expiredEntityQueue->enqueue(expiredPlayerData);
-
-                        CharacterData characterData;
-                        characterDatabase.cache->GetCharacterData(clientConnection.characterGuid, characterData);
-
-                        characterData.level = clientFieldData.GetFieldValue<u32>(UNIT_FIELD_LEVEL);
-                        characterData.mapId = clientPositionData.mapId;
-                        characterData.coordinateX = clientPositionData.x;
-                        characterData.coordinateY = clientPositionData.y;
-                        characterData.coordinateZ = clientPositionData.z;
-                        characterData.orientation = clientPositionData.orientation;
-                        characterData.online = 0;
-                        characterData.UpdateCache(clientConnection.characterGuid);
+        clientConnection.socket->SendPacket(redirectClient, Common::Opcode::SMSG_REDIRECT_CLIENT);
+
+        LoggedOutPlayer loggedOutPlayer;
+        ExpiredPlayerData& expiredPlayerData = loggedOutPlayer.expiredPlayerData;
+        expiredPlayerData.entityGuid = clientConnection.entityGuid;
+        expiredPlayerData.accountGuid = clientConnection.accountGuid;
+        expiredPlayerData.characterGuid = clientConnection.characterGuid;
+
+        loggedOutPlayer.level = static_cast<u8>(context.clientFieldData.GetFieldValue<u32>(UNIT_FIELD_LEVEL));
+        loggedOutPlayer.mapId = clientPositionData.mapId;
+        loggedOutPlayer.coordinateX = clientPositionData.x;
+        loggedOutPlayer.coordinateY = clientPositionData.y;
+        loggedOutPlayer.coordinateZ = clientPositionData.z;
+        loggedOutPlayer.orientation = clientPositionData.orientation;
+
+        // The cache update, save and entity removal happen when the side effects are applied
+        context.sideEffects.loggedOutPlayers.push_back(loggedOutPlayer);
+
+        Common::ByteBuffer suspendComms;
+        suspendComms.Write<u32>(1);
+        clientConnection.socket->SendPacket(suspendComms, Common::Opcode::SMSG_SUSPEND_COMMS);
+        return true;
+    }
 
-                        characterDatabase.cache->SaveAndUnloadCharacter(clientConnection.characterGuid);
+    bool HandleStandStateChange(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::StandStateChange", tracy::Color::Orange2)
 
+        u32 standState = 0;
+        packet.data->Read<u32>(standState);
 
-                        Common::ByteBuffer suspendComms;
-                        suspendComms.Write<u32>(1);
-                        clientConnection.socket->SendPacket(suspendComms, Common::Opcode::SMSG_SUSPEND_COMMS);
+        context.clientFieldData.SetFieldValue<u8>(UNIT_FIELD_BYTES_1, static_cast<u8>(standState));
 
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_STANDSTATECHANGE:
-                    {
-                        ZoneScopedNC("Packet::StandStateChange", tracy::Color::Orange2)
+        Common::ByteBuffer standStateChange(0);
+        standStateChange.Write<u8>(static_cast<u8>(standState));
 
-                            u32 standState = 0;
-                        packet.data.Read<u32>(standState);
+        context.sideEffects.packets.push_back(PacketQueueData(context.clientConnection.socket.get(), standStateChange, Common::Opcode::SMSG_STANDSTATE_UPDATE));
+        return true;
+    }
 
-                        clientFieldData.SetFieldValue<u8>(UNIT_FIELD_BYTES_1, static_cast<u8>(standState));
+    bool HandleSetSelection(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::SetSelection", tracy::Color::Orange2)
 
-                        Common::ByteBuffer standStateChange(0);
-                        standStateChange.Write<u8>(static_cast<u8>(standState));
+        u64 selectedGuid = 0;
+        packet.data->ReadPackedGUID(selectedGuid);
 
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, standStateChange, Common::Opcode::SMSG_STANDSTATE_UPDATE));
+        context.clientFieldData.SetGuidValue(UNIT_FIELD_TARGET, selectedGuid);
+        return true;
+    }
 
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_SET_SELECTION:
-                    {
-                        ZoneScopedNC("Packet::SetSelection", tracy::Color::Orange2)
+    // Without a name the response tells the client the character is unknown
+    Common::ByteBuffer BuildNameQueryResponse(u64 guid, const std::string* name, const NameQueryDetails& details)
+    {
+        const std::string unknownName = "Unknown";
+        const std::string& responseName = name ? *name : unknownName;
+
+        Common::ByteBuffer nameQuery(9 + 1 + responseName.size() + 1 + NameQueryDetailsSchema::Size);
+        nameQuery.AppendGuid(guid);
+        nameQuery.Write<u8>(name ? 0 : 1); // Name Unknown (0 = false, 1 = true);
+        nameQuery.WriteString(responseName);
+        NameQueryDetailsSchema::Write(nameQuery, details);
+        return nameQuery;
+    }
 
-                            u64 selectedGuid = 0;
-                        packet.data.ReadPackedGUID(selectedGuid);
+    void ResolveNameQuery(const PendingNameQuery& nameQuery, SQLCallbackDispatcher const& dispatcher)
+    {
+        PreparedStatement stmt("SELECT name, race, gender, class FROM characters WHERE guid={u};");
+        stmt.Bind(nameQuery.guid);
+        DatabaseConnector::QueryAsync(DATABASE_TYPE::CHARSERVER, stmt, [nameQuery](PreparedResultSet& results)
+        {
+            if (nameQuery.socket->IsClosed())
+                return;
 
-                        clientFieldData.SetGuidValue(UNIT_FIELD_TARGET, selectedGuid);
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_NAME_QUERY:
-                    {
-                        ZoneScopedNC("Packet::NameQuery", tracy::Color::Orange2)
-
-                            u64 guid;
-                        packet.data.Read<u64>(guid);
-
-                        Common::ByteBuffer nameQuery;
-                        nameQuery.AppendGuid(guid);
-
-                        CharacterData characterData;
-                        if (characterDatabase.cache->GetCharacterData(guid, characterData))
-                        {
-                            nameQuery.Write<u8>(0); // Name Unknown (0 = false, 1 = true);
-                            nameQuery.WriteString(characterData.name);
-                            nameQuery.Write<u8>(0);
-                            nameQuery.Write<u8>(characterData.race);
-                            nameQuery.Write<u8>(characterData.gender);
-                            nameQuery.Write<u8>(characterData.classId);
-                        }
-                        else
-                        {
-                            nameQuery.Write<u8>(1); // Name Unknown (0 = false, 1 = true);
-                            nameQuery.WriteString("Unknown");
-                            nameQuery.Write<u8>(0);
-                            nameQuery.Write<u8>(0);
-                            nameQuery.Write<u8>(0);
-                            nameQuery.Write<u8>(0);
-                        }
-                        nameQuery.Write<u8>(0);
-
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, nameQuery, Common::Opcode::SMSG_NAME_QUERY_RESPONSE));
-
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_ITEM_QUERY_SINGLE:
-                    {
-                        u32 itemEntry;
-                        packet.data.Read<u32>(itemEntry);
-                        Common::ByteBuffer itemQuery;
+            NameQueryDetails details = { 0, 0, 0, 0, 0 };
+            Common::ByteBuffer response;
+            if (results.size() == 1)
+            {
+                std::string name = results[0][0].GetString();
+                details.race = results[0][1].GetU8();
+                details.gender = results[0][2].GetU8();
+                details.classId = results[0][3].GetU8();
+                response = BuildNameQueryResponse(nameQuery.guid, &name, details);
+            }
+            else
+            {
+                response = BuildNameQueryResponse(nameQuery.guid, nullptr, details);
+            }
 
+            nameQuery.socket->SendPacket(response, Common::Opcode::SMSG_NAME_QUERY_RESPONSE);
+        }, dispatcher);
+    }
 
-                        ItemTemplate itemTemplate;
-                        if (!worldDatabase.cache->GetItemTemplate(itemEntry, itemTemplate))
-                        {
-                            itemQuery.Write<u32>(itemEntry | 0x80000000);
-                        }
-                        else
-                        {
-                            itemQuery = itemTemplate.GetQuerySinglePacket();
-                        }
+    bool HandleNameQuery(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::NameQuery", tracy::Color::Orange2)
 
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, itemQuery, Common::Opcode::SMSG_ITEM_QUERY_SINGLE_RESPONSE));
+        u64 guid;
+        packet.data->Read<u64>(guid);
 
-                        packet.handled = true;
-                        break;
-                    }
-                    /* These packets should be read here, but preferbly handled elsewhere */
-                    case Common::Opcode::MSG_MOVE_STOP:
-                    case Common::Opcode::MSG_MOVE_STOP_STRAFE:
-                    case Common::Opcode::MSG_MOVE_STOP_TURN:
-                    case Common::Opcode::MSG_MOVE_STOP_PITCH:
-                    case Common::Opcode::MSG_MOVE_START_FORWARD:
-                    case Common::Opcode::MSG_MOVE_START_BACKWARD:
-                    case Common::Opcode::MSG_MOVE_START_STRAFE_LEFT:
-                    case Common::Opcode::MSG_MOVE_START_STRAFE_RIGHT:
-                    case Common::Opcode::MSG_MOVE_START_TURN_LEFT:
-                    case Common::Opcode::MSG_MOVE_START_TURN_RIGHT:
-                    case Common::Opcode::MSG_MOVE_START_PITCH_UP:
-                    case Common::Opcode::MSG_MOVE_START_PITCH_DOWN:
-                    case Common::Opcode::MSG_MOVE_START_ASCEND:
-                    case Common::Opcode::MSG_MOVE_STOP_ASCEND:
-                    case Common::Opcode::MSG_MOVE_START_DESCEND:
-                    case Common::Opcode::MSG_MOVE_START_SWIM:
-                    case Common::Opcode::MSG_MOVE_STOP_SWIM:
-                    case Common::Opcode::MSG_MOVE_FALL_LAND:
-                    case Common::Opcode::CMSG_MOVE_FALL_RESET:
-                    case Common::Opcode::MSG_MOVE_JUMP:
-                    case Common::Opcode::MSG_MOVE_SET_FACING:
-                    case Common::Opcode::MSG_MOVE_SET_PITCH:
-                    case Common::Opcode::MSG_MOVE_SET_RUN_MODE:
-                    case Common::Opcode::MSG_MOVE_SET_WALK_MODE:
-                    case Common::Opcode::CMSG_MOVE_SET_FLY:
-                    case Common::Opcode::CMSG_MOVE_CHNG_TRANSPORT:
-                    case Common::Opcode::MSG_MOVE_HEARTBEAT:
-                    {
-                        ZoneScopedNC("Packet::Passthrough", tracy::Color::Orange2)
-
-                            // Read GUID here as packed
-                            u64 guid;
-                        packet.data.ReadPackedGUID(guid);
-
-                        u32 movementFlags;
-                        u16 movementFlagsExtra;
-                        u32 gameTime;
-                        f32 position_x;
-                        f32 position_y;
-                        f32 position_z;
-                        f32 orientation;
-                        u32 fallTime;
-
-                        packet.data.Read(&movementFlags, 4);
-                        packet.data.Read(&movementFlagsExtra, 2);
-                        packet.data.Read(&gameTime, 4);
-                        packet.data.Read(&position_x, 4);
-                        packet.data.Read(&position_y, 4);
-                        packet.data.Read(&position_z, 4);
-                        packet.data.Read(&orientation, 4);
-                        packet.data.Read(&fallTime, 4);
-
-                        u8 opcodeIndex = CharacterUtils::GetLastMovementTimeIndexFromOpcode(opcode);
-                        u32 opcodeTime = clientPositionData.lastMovementOpcodeTime[opcodeIndex];
-                        if (gameTime > opcodeTime)
-                        {
-                            clientPositionData.lastMovementOpcodeTime[opcodeIndex] = gameTime;
-
-                            PositionUpdateData positionUpdateData;
-                            positionUpdateData.opcode = opcode;
-                            positionUpdateData.movementFlags = movementFlags;
-                            positionUpdateData.movementFlagsExtra = movementFlagsExtra;
-                            positionUpdateData.gameTime = static_cast<u32>(singleton.lifeTimeInMS);
-                            positionUpdateData.fallTime = fallTime;
-
-                            clientPositionData.x = position_x;
-                            clientPositionData.y = position_y;
-                            clientPositionData.z = position_z;
-                            clientPositionData.orientation = orientation;
-
-                            positionUpdateData.x = position_x;
-                            positionUpdateData.y = position_y;
-                            positionUpdateData.z = position_z;
-                            positionUpdateData.orientation = orientation;
-
-                            clientUpdateData.positionUpdateData.push_back(positionUpdateData);
-                        }
-
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_MESSAGECHAT:
-                    {
-                        ZoneScopedNC("Packet::MessageChat", tracy::Color::Orange2)
-                            packet.handled = true;
-
-                        u32 msgType;
-                        u32 msgLang;
-
-                        packet.data.Read<u32>(msgType);
-                        packet.data.Read<u32>(msgLang);
-
-                        if (msgType >= MAX_MSG_TYPE)
-                        {
-                            // Client tried to use invalid type
-                            break;
-                        }
-
-                        if (msgLang == LANG_UNIVERSAL && msgType != CHAT_MSG_AFK && msgType != CHAT_MSG_DND)
-                        {
-                            // Client tried to send a message in universal language. (While it not being afk or dnd)
-                            break;
-                        }
-
-                        if (msgType == CHAT_MSG_AFK || msgType == CHAT_MSG_DND)
-                        {
-                            // We don't want to send this message to any client.
-                            break;
-                        }
-
-                        std::string msgOutput;
-                        switch (msgType)
-                        {
-                        case CHAT_MSG_SAY:
-                        case CHAT_MSG_YELL:
-                        case CHAT_MSG_EMOTE:
-                        case CHAT_MSG_TEXT_EMOTE:
-                        {
-                            packet.data.Read(msgOutput);
-                            break;
-                        }
-
-                        default:
-                        {
-                            worldNodeHandler.PrintMessage("Account(%u), Character(%u) sent unhandled message type %u", clientConnection.accountGuid, clientConnection.characterGuid, msgType);
-                            break;
-                        }
-                        }
-
-                        // Max Message Size is 255
-                        if (msgOutput.size() > 255)
-                            break;
-
-                        /* Build Packet */
-                        ChatUpdateData chatUpdateData;
-                        chatUpdateData.chatType = msgType;
-                        chatUpdateData.language = msgLang;
-                        chatUpdateData.sender = clientConnection.characterGuid;
-                        chatUpdateData.message = msgOutput;
-                        chatUpdateData.handled = false;
-                        clientUpdateData.chatUpdateData.push_back(chatUpdateData);
-                        break;
-                    }
-                    case Common::Opcode::CMSG_ATTACKSWING:
-                    {
-                        ZoneScopedNC("Packet::AttackSwing", tracy::Color::Orange2)
+        CharacterData characterData;
+        if (!context.characterDatabase.cache->GetCachedCharacterData(guid, characterData))
+        {
+            context.sideEffects.nameQueries.push_back({ context.clientConnection.socket, guid });
+            return true;
+        }
+
+        NameQueryDetails details = { 0, 0, 0, 0, 0 };
+        details.race = characterData.race;
+        details.gender = characterData.gender;
+        details.classId = characterData.classId;
+
+        Common::ByteBuffer nameQuery = BuildNameQueryResponse(guid, &characterData.name, details);
+        context.sideEffects.packets.push_back(PacketQueueData(context.clientConnection.socket.get(), nameQuery, Common::Opcode::SMSG_NAME_QUERY_RESPONSE));
+        return true;
+    }
 
-                            u64 attackGuid;
-                        packet.data.Read<u64>(attackGuid);
+    bool HandleItemQuerySingle(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::ItemQuerySingle", tracy::Color::Orange2)
 
-                        Common::ByteBuffer attackStart;
-                        attackStart.Write<u64>(clientConnection.characterGuid);
-                        attackStart.Write<u64>(attackGuid);
+        u32 itemEntry;
+        packet.data->Read<u32>(itemEntry);
+        Common::ByteBuffer itemQuery;
 
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, attackStart, Common::Opcode::SMSG_ATTACKSTART));
+        ItemTemplate itemTemplate;
+        if (!context.worldDatabase.cache->GetItemTemplate(itemEntry, itemTemplate))
+        {
+            itemQuery.Write<u32>(itemEntry | 0x80000000);
+        }
+        else
+        {
+            itemQuery = itemTemplate.GetQuerySinglePacket();
+        }
 
-                        Common::ByteBuffer attackerStateUpdate;
-                        attackerStateUpdate.Write<u32>(0);
-                        attackerStateUpdate.AppendGuid(clientConnection.characterGuid);
-                        attackerStateUpdate.AppendGuid(attackGuid);
-                        attackerStateUpdate.Write<u32>(5);
-                        attackerStateUpdate.Write<u32>(0);
-                        attackerStateUpdate.Write<u8>(1);
+        context.sideEffects.packets.push_back(PacketQueueData(context.clientConnection.socket.get(), itemQuery, Common::Opcode::SMSG_ITEM_QUERY_SINGLE_RESPONSE));
+        return true;
+    }
 
-                        attackerStateUpdate.Write<u32>(1);
-                        attackerStateUpdate.Write<f32>(5);
-                        attackerStateUpdate.Write<u32>(5);
+    /* These packets should be read here, but preferbly handled elsewhere */
+    bool HandleMovement(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::Passthrough", tracy::Color::Orange2)
 
-                        attackerStateUpdate.Write<u8>(0);
-                        attackerStateUpdate.Write<u32>(0);
-                        attackerStateUpdate.Write<u32>(0);
+        PlayerPositionComponent& clientPositionData = context.clientPositionData;
+        Common::Opcode opcode = static_cast<Common::Opcode>(packet.opcode);
 
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, attackerStateUpdate, Common::Opcode::SMSG_ATTACKERSTATEUPDATE));
+        // Read GUID here as packed
+        u64 guid;
+        PositionUpdateData positionUpdateData;
+        if (!Common::Schema::ReadPackedGuid(*packet.data, guid) || !MovementInfoSchema::Read(*packet.data, positionUpdateData))
+            return true;
 
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_ATTACKSTOP:
-                    {
-                        ZoneScopedNC("Packet::AttackStop", tracy::Color::Orange2)
+        u8 opcodeIndex = CharacterUtils::GetLastMovementTimeIndexFromOpcode(opcode);
+        u32 opcodeTime = clientPositionData.lastMovementOpcodeTime[opcodeIndex];
+        if (positionUpdateData.gameTime > opcodeTime)
+        {
+            clientPositionData.lastMovementOpcodeTime[opcodeIndex] = positionUpdateData.gameTime;
 
-                            u64 attackGuid = clientFieldData.GetFieldValue<u64>(UNIT_FIELD_TARGET);
+            positionUpdateData.opcode = opcode;
+            positionUpdateData.gameTime = static_cast<u32>(context.singleton.lifeTimeInMS);
 
-                        Common::ByteBuffer attackStop;
-                        attackStop.AppendGuid(clientConnection.characterGuid);
-                        attackStop.AppendGuid(attackGuid);
-                        attackStop.Write<u32>(0);
+            clientPositionData.x = positionUpdateData.x;
+            clientPositionData.y = positionUpdateData.y;
+            clientPositionData.z = positionUpdateData.z;
+            clientPositionData.orientation = positionUpdateData.orientation;
 
-                        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, attackStop, Common::Opcode::SMSG_ATTACKSTOP));
+            context.clientUpdateData.positionUpdateData.push_back(positionUpdateData);
+        }
 
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_SETSHEATHED:
-                    {
-                        ZoneScopedNC("Packet::SetSheathed", tracy::Color::Orange2)
+        return true;
+    }
 
-                            u32 state;
-                        packet.data.Read<u32>(state);
+    bool HandleMessageChat(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::MessageChat", tracy::Color::Orange2)
 
-                        clientFieldData.SetFieldValue<u8>(UNIT_FIELD_BYTES_2, static_cast<u8>(state));
-                        packet.handled = true;
-                        break;
-                    }
-                    case Common::Opcode::CMSG_TEXT_EMOTE:
-                    {
-                        ZoneScopedNC("Packet::Text_emote", tracy::Color::Orange2)
+        PlayerConnectionComponent& clientConnection = context.clientConnection;
+
+        ChatMessageRequest request;
+        if (!ChatMessageRequestSchema::Read(*packet.data, request))
+            return true;
+
+        u32 msgType = request.type;
+        u32 msgLang = request.language;
+
+        if (msgType >= MAX_MSG_TYPE)
+        {
+            // Client tried to use invalid type
+            return true;
+        }
+
+        if (msgLang == LANG_UNIVERSAL && msgType != CHAT_MSG_AFK && msgType != CHAT_MSG_DND)
+        {
+            // Client tried to send a message in universal language. (While it not being afk or dnd)
+            return true;
+        }
+
+        if (msgType == CHAT_MSG_AFK || msgType == CHAT_MSG_DND)
+        {
+            // We don't want to send this message to any client.
+            return true;
+        }
+
+        std::string msgTarget;
+        std::string msgOutput;
+        switch (msgType)
+        {
+            case CHAT_MSG_SAY:
+            case CHAT_MSG_YELL:
+            case CHAT_MSG_EMOTE:
+            case CHAT_MSG_TEXT_EMOTE:
+            {
+                // Max Message Size is 255
+                if (!Common::Schema::ReadString(*packet.data, msgOutput, 255))
+                    return true;
+                break;
+            }
 
-                        u32 textEmote;
-                        u32 emoteNum;
-                        u64 targetGuid;
+            case CHAT_MSG_WHISPER:
+            case CHAT_MSG_CHANNEL:
+            {
+                // The character name or channel name comes first
+                if (!Common::Schema::ReadString(*packet.data, msgTarget, MAX_CHAT_TARGET_LENGTH) || msgTarget.empty())
+                    return true;
+                if (!Common::Schema::ReadString(*packet.data, msgOutput, 255))
+                    return true;
+                break;
+            }
 
-                        packet.data.Read<u32>(textEmote);
-                        packet.data.Read<u32>(emoteNum);
-                        packet.data.Read<u64>(targetGuid);
+            default:
+            {
+                context.worldNodeHandler.PrintMessage("Account(%u), Character(%u) sent unhandled message type %u", clientConnection.accountGuid, clientConnection.characterGuid, msgType);
+                return true;
+            }
+        }
+
+        /* Build Packet, ChatSystem decides who receives it */
+        ChatUpdateData chatUpdateData;
+        chatUpdateData.chatType = msgType;
+        chatUpdateData.language = msgLang;
+        chatUpdateData.sender = clientConnection.characterGuid;
+        chatUpdateData.target = msgTarget;
+        chatUpdateData.channelId = 0;
+        chatUpdateData.message = msgOutput;
+        chatUpdateData.handled = false;
+        context.clientUpdateData.chatUpdateData.push_back(chatUpdateData);
+        return true;
+    }
 
-                        u32 animationID;
-                        /* Pulling animation ID from database code here. */
+    bool HandleJoinChannel(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::JoinChannel", tracy::Color::Orange2)
+
+        u32 channelId;
+        u8 hasVoice;
+        u8 joinedByZoneUpdate;
+        packet.data->Read<u32>(channelId);
+        packet.data->Read<u8>(hasVoice);
+        packet.data->Read<u8>(joinedByZoneUpdate);
+
+        // The channel password follows, channels can't have one yet
+        std::string channelName;
+        if (!Common::Schema::ReadString(*packet.data, channelName, MAX_CHAT_TARGET_LENGTH) || channelName.empty())
+            return true;
+
+        ChatUpdateData chatUpdateData;
+        chatUpdateData.chatType = CHAT_MSG_CHANNEL_JOIN;
+        chatUpdateData.language = LANG_UNIVERSAL;
+        chatUpdateData.sender = context.clientConnection.characterGuid;
+        chatUpdateData.target = channelName;
+        chatUpdateData.channelId = channelId;
+        chatUpdateData.handled = false;
+        context.clientUpdateData.chatUpdateData.push_back(chatUpdateData);
+        return true;
+    }
 
-                        animationID = 10;
+    bool HandleLeaveChannel(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::LeaveChannel", tracy::Color::Orange2)
+
+        u32 unknown;
+        packet.data->Read<u32>(unknown);
+
+        std::string channelName;
+        if (!Common::Schema::ReadString(*packet.data, channelName, MAX_CHAT_TARGET_LENGTH) || channelName.empty())
+            return true;
+
+        ChatUpdateData chatUpdateData;
+        chatUpdateData.chatType = CHAT_MSG_CHANNEL_LEAVE;
+        chatUpdateData.language = LANG_UNIVERSAL;
+        chatUpdateData.sender = context.clientConnection.characterGuid;
+        chatUpdateData.target = channelName;
+        chatUpdateData.channelId = 0;
+        chatUpdateData.handled = false;
+        context.clientUpdateData.chatUpdateData.push_back(chatUpdateData);
+        return true;
+    }
 
-                        /* End pulling animation ID from database here. */
+    bool HandleAttackSwing(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::AttackSwing", tracy::Color::Orange2)
 
-                        /* Play animation packet. */
-                        {
-                            //The animation shouldn't play if the player is dead. In the future we should check for that.
+        PlayerConnectionComponent& clientConnection = context.clientConnection;
 
-                            Common::ByteBuffer emote;
-                            emote.Write<u32>(animationID);
-                            emote.Write<u64>(clientConnection.characterGuid);
+        u64 attackGuid;
+        packet.data->Read<u64>(attackGuid);
 
-                            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, emote, Common::Opcode::SMSG_EMOTE));
-                        }
+        Common::ByteBuffer attackStart;
+        attackStart.Write<u64>(clientConnection.characterGuid);
+        attackStart.Write<u64>(attackGuid);
 
-                        /* Emote Chat Message Packet. */
-                        {
-                            CharacterData targetData;
-                            characterDatabase.cache->GetCharacterData(targetGuid, targetData);
+        context.sideEffects.packets.push_back(PacketQueueData(clientConnection.socket.get(), attackStart, Common::Opcode::SMSG_ATTACKSTART));
 
-                            u32 targetNameLength = static_cast<u32>(targetData.name.size());
+        Common::ByteBuffer attackerStateUpdate;
+        attackerStateUpdate.Write<u32>(0);
+        attackerStateUpdate.AppendGuid(clientConnection.characterGuid);
+        attackerStateUpdate.AppendGuid(attackGuid);
+        attackerStateUpdate.Write<u32>(5);
+        attackerStateUpdate.Write<u32>(0);
+        attackerStateUpdate.Write<u8>(1);
 
-                            Common::ByteBuffer textEmoteMessage;
-                            textEmoteMessage.Write<u64>(clientConnection.characterGuid);
-                            textEmoteMessage.Write<u32>(textEmote);
-                            textEmoteMessage.Write<u32>(emoteNum);
-                            textEmoteMessage.Write<u32>(targetNameLength);
-                            if (targetNameLength > 1)
-                            {
-                                textEmoteMessage.Write(targetData.name);
-                            }
-                            else
-                            {
-                                textEmoteMessage.Write<u8>(0x00);
-                            }
+        attackerStateUpdate.Write<u32>(1);
+        attackerStateUpdate.Write<f32>(5);
+        attackerStateUpdate.Write<u32>(5);
 
-                            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, textEmoteMessage, Common::Opcode::SMSG_TEXT_EMOTE));
-                        }
+        attackerStateUpdate.Write<u8>(0);
+        attackerStateUpdate.Write<u32>(0);
+        attackerStateUpdate.Write<u32>(0);
 
-                        packet.handled = true;
-                        break;
-                    }
-					case Common::Opcode::CMSG_CAST_SPELL:
-					{
-						packet.handled = true;
-
-						u32 spellId = 0, targetFlags = 0;
-						u8 castCount = 0, castFlags = 0;
-
-						packet.data.Read<u8>(castCount);
-						packet.data.Read<u32>(spellId);
-						packet.data.Read<u8>(castFlags);
-						packet.data.Read<u32>(targetFlags);
-
-						// As far as I can tell, the client expects SMSG_SPELL_START followed by SMSG_SPELL_GO.
-
-						// Handle blink!
-						if (spellId == 1953)
-						{
-							f32 tempHeight = clientPositionData.z;
-							u32 dest = 20;
-
-							for (u32 i = 0; i < 20; i++)
-							{
-								f32 newPositionX = clientPositionData.x + i * Math::Cos(clientPositionData.orientation);
-								f32 newPositionY = clientPositionData.y + i * Math::Sin(clientPositionData.orientation);
-                                Vector2 newPos(newPositionX, newPositionY);
-								f32 height = mapSingleton.maps[clientPositionData.mapId].GetHeight(newPos);
-								f32 deltaHeight = Math::Abs(tempHeight - height);
-
-								if (deltaHeight <= 2.0f || (i == 0 && deltaHeight <= 20))
-								{
-									dest = i;
-									tempHeight = height;
-								}
-							}
-
-							if (dest == 20)
-							{
-								Common::ByteBuffer spellFailed;
-								spellFailed.Write<u8>(castCount);
-								spellFailed.Write<u32>(spellId);
-								spellFailed.Write<u8>(173); // SPELL_FAILED_TRY_AGAIN
-
-								playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, spellFailed, Common::Opcode::SMSG_CAST_FAILED));
-								break;
-							}
-
-
-							f32 newPositionX = clientPositionData.x + dest * Math::Cos(clientPositionData.orientation);
-							f32 newPositionY = clientPositionData.y + dest * Math::Sin(clientPositionData.orientation);
-
-							/*
-								Adding 2.0f to the final height will solve 90%+ of issues where we fall through the terrain, remove this to fully test blink's capabilities.
-								This also introduce the bug where after a blink, you might appear a bit over the ground and fall down.
-							*/
-                            Vector2 newPos(newPositionX, newPositionY);
-							f32 height = mapSingleton.maps[clientPositionData.mapId].GetHeight(newPos);
-
-							Common::ByteBuffer buffer;
-							buffer.AppendGuid(clientConnection.characterGuid);
-							buffer.Write<u32>(0); // Teleport Count
-
-							/* Movement */
-							buffer.Write<u32>(0);
-							buffer.Write<u16>(0);
-							buffer.Write<u32>(static_cast<u32>(singleton.lifeTimeInMS));
-
-							buffer.Write<f32>(newPositionX);
-							buffer.Write<f32>(newPositionY);
-							buffer.Write<f32>(height);
-							buffer.Write<f32>(clientPositionData.orientation);
-
-							buffer.Write<u32>(targetFlags);
-
-							playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, buffer, Common::Opcode::MSG_MOVE_TELEPORT_ACK));
-						}
-						Common::ByteBuffer spellStart;
-						spellStart.AppendGuid(clientConnection.characterGuid);
-						spellStart.AppendGuid(clientConnection.characterGuid);
-						spellStart.Write<u8>(0); // CastCount
-						spellStart.Write<u32>(spellId);
-						spellStart.Write<u32>(0x00000002);
-						spellStart.Write<u32>(0);
-						spellStart.Write<u32>(0);
-
-						playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, spellStart, Common::Opcode::SMSG_SPELL_START));
-
-						Common::ByteBuffer spellCast;
-						spellCast.AppendGuid(clientConnection.characterGuid);
-						spellCast.AppendGuid(clientConnection.characterGuid);
-						spellCast.Write<u8>(0); // CastCount
-						spellCast.Write<u32>(spellId);
-						spellCast.Write<u32>(0x00000100);
-						spellCast.Write<u32>(static_cast<u32>(singleton.lifeTimeInMS));
-
-						spellCast.Write<u8>(1); // Affected Targets
-						spellCast.Write<u64>(clientConnection.characterGuid); // Target GUID
-						spellCast.Write<u8>(0); // Resisted Targets
-
-						if (targetFlags == 0) // SELF
-						{
-							targetFlags = 0x02; // UNIT
-						}
-						spellCast.Write<u32>(targetFlags); // Target Flags
-						spellCast.Write<u8>(0); // Target Flags
-
-						playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, spellCast, Common::Opcode::SMSG_SPELL_GO));
-						break;
-					}
-                    default:
+        context.sideEffects.packets.push_back(PacketQueueData(clientConnection.socket.get(), attackerStateUpdate, Common::Opcode::SMSG_ATTACKERSTATEUPDATE));
+        return true;
+    }
+
+    bool HandleAttackStop(PacketContext& context, OpcodePacket&)
+    {
+        ZoneScopedNC("Packet::AttackStop", tracy::Color::Orange2)
+
+        u64 attackGuid = context.clientFieldData.GetFieldValue<u64>(UNIT_FIELD_TARGET);
+
+        Common::ByteBuffer attackStop;
+        attackStop.AppendGuid(context.clientConnection.characterGuid);
+        attackStop.AppendGuid(attackGuid);
+        attackStop.Write<u32>(0);
+
+        context.sideEffects.packets.push_back(PacketQueueData(context.clientConnection.socket.get(), attackStop, Common::Opcode::SMSG_ATTACKSTOP));
+        return true;
+    }
+
+    bool HandleSetSheathed(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::SetSheathed", tracy::Color::Orange2)
+
+        u32 state;
+        packet.data->Read<u32>(state);
+
+        context.clientFieldData.SetFieldValue<u8>(UNIT_FIELD_BYTES_2, static_cast<u8>(state));
+        return true;
+    }
+
+    bool HandleTextEmote(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::Text_emote", tracy::Color::Orange2)
+
+        PlayerConnectionComponent& clientConnection = context.clientConnection;
+
+        u32 textEmote;
+        u32 emoteNum;
+        u64 targetGuid;
+
+        packet.data->Read<u32>(textEmote);
+        packet.data->Read<u32>(emoteNum);
+        packet.data->Read<u64>(targetGuid);
+
+        u32 animationID;
+        /* Pulling animation ID from database code here. */
+
+        animationID = 10;
+
+        /* End pulling animation ID from database here. */
+
+        /* Play animation packet. */
+        {
+            //The animation shouldn't play if the player is dead. In the future we should check for that.
+
+            Common::ByteBuffer emote;
+            emote.Write<u32>(animationID);
+            emote.Write<u64>(clientConnection.characterGuid);
+
+            context.sideEffects.packets.push_back(PacketQueueData(clientConnection.socket.get(), emote, Common::Opcode::SMSG_EMOTE));
+        }
+
+        /* Emote Chat Message Packet. */
+        {
+            // Emote targets are players in view, so a character that isn't cached is no character and has no name
+            CharacterData targetData;
+            context.characterDatabase.cache->GetCachedCharacterData(targetGuid, targetData);
+
+            u32 targetNameLength = static_cast<u32>(targetData.name.size());
+
+            Common::ByteBuffer textEmoteMessage;
+            textEmoteMessage.Write<u64>(clientConnection.characterGuid);
+            textEmoteMessage.Write<u32>(textEmote);
+            textEmoteMessage.Write<u32>(emoteNum);
+            textEmoteMessage.Write<u32>(targetNameLength);
+            if (targetNameLength > 1)
+            {
+                textEmoteMessage.Write(targetData.name);
+            }
+            else
+            {
+                textEmoteMessage.Write<u8>(0x00);
+            }
+
+            context.sideEffects.packets.push_back(PacketQueueData(clientConnection.socket.get(), textEmoteMessage, Common::Opcode::SMSG_TEXT_EMOTE));
+        }
+
+        return true;
+    }
+
+    // Chunks run concurrently, so unlike operator[] this must never insert a map
+    f32 GetHeight(MapSingleton& mapSingleton, u16 mapId, Vector2& pos)
+    {
+        auto itr = mapSingleton.maps.find(mapId);
+        if (itr == mapSingleton.maps.end())
+            return 0.0f;
+
+        return itr->second.GetHeight(pos);
+    }
+
+    bool HandleCastSpell(PacketContext& context, OpcodePacket& packet)
+    {
+        ZoneScopedNC("Packet::CastSpell", tracy::Color::Orange2)
+
+        PlayerConnectionComponent& clientConnection = context.clientConnection;
+        PlayerPositionComponent& clientPositionData = context.clientPositionData;
+        std::vector<PacketQueueData>& packets = context.sideEffects.packets;
+
+        u32 spellId = 0, targetFlags = 0;
+        u8 castCount = 0, castFlags = 0;
+
+        packet.data->Read<u8>(castCount);
+        packet.data->Read<u32>(spellId);
+        packet.data->Read<u8>(castFlags);
+        packet.data->Read<u32>(targetFlags);
+
+        // As far as I can tell, the client expects SMSG_SPELL_START followed by SMSG_SPELL_GO.
+
+        // Handle blink!
+        if (spellId == 1953)
+        {
+            f32 tempHeight = clientPositionData.z;
+            u32 dest = 20;
+
+            for (u32 i = 0; i < 20; i++)
+            {
+                f32 newPositionX = clientPositionData.x + i * Math::Cos(clientPositionData.orientation);
+                f32 newPositionY = clientPositionData.y + i * Math::Sin(clientPositionData.orientation);
+                Vector2 newPos(newPositionX, newPositionY);
+                f32 height = GetHeight(context.mapSingleton, clientPositionData.mapId, newPos);
+                f32 deltaHeight = Math::Abs(tempHeight - height);
+
+                if (deltaHeight <= 2.0f || (i == 0 && deltaHeight <= 20))
+                {
+                    dest = i;
+                    tempHeight = height;
+                }
+            }
+
+            if (dest == 20)
+            {
+                Common::ByteBuffer spellFailed;
+                spellFailed.Write<u8>(castCount);
+                spellFailed.Write<u32>(spellId);
+                spellFailed.Write<u8>(173); // SPELL_FAILED_TRY_AGAIN
+
+                packets.push_back(PacketQueueData(clientConnection.socket.get(), spellFailed, Common::Opcode::SMSG_CAST_FAILED));
+                return true;
+            }
+
+            f32 newPositionX = clientPositionData.x + dest * Math::Cos(clientPositionData.orientation);
+            f32 newPositionY = clientPositionData.y + dest * Math::Sin(clientPositionData.orientation);
+
+            /*
+                Adding 2.0f to the final height will solve 90%+ of issues where we fall through the terrain, remove this to fully test blink's capabilities.
+                This also introduce the bug where after a blink, you might appear a bit over the ground and fall down.
+            */
+            Vector2 newPos(newPositionX, newPositionY);
+            f32 height = GetHeight(context.mapSingleton, clientPositionData.mapId, newPos);
+
+            Common::ByteBuffer buffer;
+            buffer.AppendGuid(clientConnection.characterGuid);
+            buffer.Write<u32>(0); // Teleport Count
+
+            /* Movement */
+            buffer.Write<u32>(0);
+            buffer.Write<u16>(0);
+            buffer.Write<u32>(static_cast<u32>(context.singleton.lifeTimeInMS));
+
+            buffer.Write<f32>(newPositionX);
+            buffer.Write<f32>(newPositionY);
+            buffer.Write<f32>(height);
+            buffer.Write<f32>(clientPositionData.orientation);
+
+            buffer.Write<u32>(targetFlags);
+
+            packets.push_back(PacketQueueData(clientConnection.socket.get(), buffer, Common::Opcode::MSG_MOVE_TELEPORT_ACK));
+        }
+        Common::ByteBuffer spellStart;
+        spellStart.AppendGuid(clientConnection.characterGuid);
+        spellStart.AppendGuid(clientConnection.characterGuid);
+        spellStart.Write<u8>(0); // CastCount
+        spellStart.Write<u32>(spellId);
+        spellStart.Write<u32>(0x00000002);
+        spellStart.Write<u32>(0);
+        spellStart.Write<u32>(0);
+
+        packets.push_back(PacketQueueData(clientConnection.socket.get(), spellStart, Common::Opcode::SMSG_SPELL_START));
+
+        Common::ByteBuffer spellCast;
+        spellCast.AppendGuid(clientConnection.characterGuid);
+        spellCast.AppendGuid(clientConnection.characterGuid);
+        spellCast.Write<u8>(0); // CastCount
+        spellCast.Write<u32>(spellId);
+        spellCast.Write<u32>(0x00000100);
+        spellCast.Write<u32>(static_cast<u32>(context.singleton.lifeTimeInMS));
+
+        spellCast.Write<u8>(1); // Affected Targets
+        spellCast.Write<u64>(clientConnection.characterGuid); // Target GUID
+        spellCast.Write<u8>(0); // Resisted Targets
+
+        if (targetFlags == 0) // SELF
+        {
+            targetFlags = 0x02; // UNIT
+        }
+        spellCast.Write<u32>(targetFlags); // Target Flags
+        spellCast.Write<u8>(0); // Target Flags
+
+        packets.push_back(PacketQueueData(clientConnection.socket.get(), spellCast, Common::Opcode::SMSG_SPELL_GO));
+        return true;
+    }
+
+    std::array<PacketHandler, Common::Opcode::NUM_MSG_TYPES> InitPacketHandlers()
+    {
+        std::array<PacketHandler, Common::Opcode::NUM_MSG_TYPES> packetHandlers;
+        packetHandlers.fill(nullptr);
+
+        packetHandlers[Common::Opcode::CMSG_SET_ACTIVE_MOVER] = HandleSetActiveMover;
+        packetHandlers[Common::Opcode::CMSG_LOGOUT_REQUEST] = HandleLogoutRequest;
+        packetHandlers[Common::Opcode::CMSG_STANDSTATECHANGE] = HandleStandStateChange;
+        packetHandlers[Common::Opcode::CMSG_SET_SELECTION] = HandleSetSelection;
+        packetHandlers[Common::Opcode::CMSG_NAME_QUERY] = HandleNameQuery;
+        packetHandlers[Common::Opcode::CMSG_ITEM_QUERY_SINGLE] = HandleItemQuerySingle;
+        packetHandlers[Common::Opcode::CMSG_MESSAGECHAT] = HandleMessageChat;
+        packetHandlers[Common::Opcode::CMSG_JOIN_CHANNEL] = HandleJoinChannel;
+        packetHandlers[Common::Opcode::CMSG_LEAVE_CHANNEL] = HandleLeaveChannel;
+        packetHandlers[Common::Opcode::CMSG_ATTACKSWING] = HandleAttackSwing;
+        packetHandlers[Common::Opcode::CMSG_ATTACKSTOP] = HandleAttackStop;
+        packetHandlers[Common::Opcode::CMSG_SETSHEATHED] = HandleSetSheathed;
+        packetHandlers[Common::Opcode::CMSG_TEXT_EMOTE] = HandleTextEmote;
+        packetHandlers[Common::Opcode::CMSG_CAST_SPELL] = HandleCastSpell;
+
+        packetHandlers[Common::Opcode::MSG_MOVE_STOP] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_STOP_STRAFE] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_STOP_TURN] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_STOP_PITCH] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_FORWARD] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_BACKWARD] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_STRAFE_LEFT] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_STRAFE_RIGHT] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_TURN_LEFT] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_TURN_RIGHT] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_PITCH_UP] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_PITCH_DOWN] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_ASCEND] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_STOP_ASCEND] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_DESCEND] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_START_SWIM] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_STOP_SWIM] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_FALL_LAND] = HandleMovement;
+        packetHandlers[Common::Opcode::CMSG_MOVE_FALL_RESET] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_JUMP] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_SET_FACING] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_SET_PITCH] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_SET_RUN_MODE] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_SET_WALK_MODE] = HandleMovement;
+        packetHandlers[Common::Opcode::CMSG_MOVE_SET_FLY] = HandleMovement;
+        packetHandlers[Common::Opcode::CMSG_MOVE_CHNG_TRANSPORT] = HandleMovement;
+        packetHandlers[Common::Opcode::MSG_MOVE_HEARTBEAT] = HandleMovement;
+
+        return packetHandlers;
+    }
+
+    void HandleConnection(PacketContext& context, const std::array<PacketHandler, Common::Opcode::NUM_MSG_TYPES>& packetHandlers)
+    {
+        ZoneScopedNC("Connection", tracy::Color::Orange2)
+
+        PlayerConnectionComponent& clientConnection = context.clientConnection;
+
+        // Only this chunk consumes the connection's inbound queue
+        InboundPacket inboundPacket;
+        while (clientConnection.socket->TryGetInboundPacket(inboundPacket))
+        {
+            clientConnection.packets.push_back({ inboundPacket.opcode, false, std::move(inboundPacket.data) });
+        }
+
+        for (OpcodePacket& packet : clientConnection.packets)
+        {
+            ZoneScopedNC("Packet", tracy::Color::Orange2)
+
+            PacketHandler packetHandler = packetHandlers[packet.opcode];
+            if (packetHandler)
+            {
+                packet.handled = packetHandler(context, packet);
+            }
+            else
+            {
+                ZoneScopedNC("Packet::Unhandled", tracy::Color::Orange2)
+                context.worldNodeHandler.PrintMessage("Account(%u), Character(%u) sent unhandled opcode %u", clientConnection.accountGuid, clientConnection.characterGuid, packet.opcode);
+
+                // Mark all unhandled opcodes as handled to prevent the queue from trying to handle them every tick.
+                packet.handled = true;
+            }
+        }
+
+        if (clientConnection.packets.size() > 0)
+        {
+            ZoneScopedNC("Packet::PacketClear", tracy::Color::Orange2)
+            clientConnection.packets.erase(std::remove_if(clientConnection.packets.begin(), clientConnection.packets.end(), [](OpcodePacket& packet)
+            {
+                return packet.handled;
+            }), clientConnection.packets.end());
+        }
+    }
+
+    tf::Task Update(entt::registry &registry, tf::SubflowBuilder& subflow)
+    {
+        static const std::array<PacketHandler, Common::Opcode::NUM_MSG_TYPES> packetHandlers = InitPacketHandlers();
+        static std::vector<entt::registry::entity_type> entities;
+        static std::vector<ConnectionSideEffects> chunkSideEffects;
+
+        SingletonComponent& singleton = registry.ctx<SingletonComponent>();
+        PlayerDeleteQueueSingleton& playerDeleteQueue = registry.ctx<PlayerDeleteQueueSingleton>();
+        CharacterDatabaseCacheSingleton& characterDatabase = registry.ctx<CharacterDatabaseCacheSingleton>();
+        WorldDatabaseCacheSingleton& worldDatabase = registry.ctx<WorldDatabaseCacheSingleton>();
+        PlayerPacketQueueSingleton& playerPacketQueue = registry.ctx<PlayerPacketQueueSingleton>();
+        WorldNodeHandler& worldNodeHandler = *singleton.worldNodeHandler;
+        MapSingleton& mapSingleton = registry.ctx<MapSingleton>();
+
+        auto view = registry.view<PlayerConnectionComponent, PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerPositionComponent>();
+        entities.assign(view.begin(), view.end());
+
+        size_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunkSize = std::max(MIN_CONNECTIONS_PER_CHUNK, (entities.size() + workerCount - 1) / workerCount);
+        size_t chunkCount = (entities.size() + chunkSize - 1) / chunkSize;
+        if (chunkSideEffects.size() < chunkCount)
+            chunkSideEffects.resize(chunkCount);
+
+        tf::Task applySideEffects = subflow.emplace([&playerDeleteQueue, &characterDatabase, &playerPacketQueue, &worldNodeHandler, chunkCount]()
+        {
+            ZoneScopedNC("Connection::ApplySideEffects", tracy::Color::Orange2)
+            Access::Scope scope;
+
+            LockWrite(PlayerDeleteQueueSingleton);
+            LockWrite(PlayerPacketQueueSingleton);
+
+            for (size_t i = 0; i < chunkCount; i++)
+            {
+                ConnectionSideEffects& sideEffects = chunkSideEffects[i];
+                for (PacketQueueData& packet : sideEffects.packets)
+                {
+                    playerPacketQueue.packetQueue->enqueue(std::move(packet));
+                }
+
+                for (LoggedOutPlayer& loggedOutPlayer : sideEffects.loggedOutPlayers)
+                {
+                    u64 characterGuid = loggedOutPlayer.expiredPlayerData.characterGuid;
+
+                    // PlayerCreateSystem loaded the character before the player entered the world, so this is a cache hit
+                    CharacterData characterData;
+                    if (characterDatabase.cache->GetCharacterData(characterGuid, characterData))
                     {
-                        ZoneScopedNC("Packet::Unhandled", tracy::Color::Orange2)
-                        {
-                            ZoneScopedNC("Packet::Unhandled::Log", tracy::Color::Orange2)
-                                worldNodeHandler.PrintMessage("Account(%u), Character(%u) sent unhandled opcode %u", clientConnection.accountGuid, clientConnection.characterGuid, opcode);
-                        }
-
-                        // Mark all unhandled opcodes as handled to prevent the queue from trying to handle them every tick.
-                        packet.handled = true;
-                        break;
-                    }
+                        characterData.level = loggedOutPlayer.level;
+                        characterData.mapId = loggedOutPlayer.mapId;
+                        characterData.coordinateX = loggedOutPlayer.coordinateX;
+                        characterData.coordinateY = loggedOutPlayer.coordinateY;
+                        characterData.coordinateZ = loggedOutPlayer.coordinateZ;
+                        characterData.orientation = loggedOutPlayer.orientation;
+                        characterData.online = 0;
+                        characterData.UpdateCache(characterGuid);
+                        characterDatabase.cache->SaveAndUnloadCharacter(characterGuid, worldNodeHandler.GetDatabaseDispatcher());
                     }
+
+                    playerDeleteQueue.expiredEntityQueue->enqueue(loggedOutPlayer.expiredPlayerData);
                 }
-            /* Cull Movement Data */
 
-            if (clientConnection.packets.size() > 0)
-            {
-                ZoneScopedNC("Packet::PacketClear", tracy::Color::Orange2)
-                    clientConnection.packets.erase(std::remove_if(clientConnection.packets.begin(), clientConnection.packets.end(), [](OpcodePacket& packet)
+                for (PendingNameQuery& nameQuery : sideEffects.nameQueries)
                 {
-                    return packet.handled;
-                }), clientConnection.packets.end());
+                    ResolveNameQuery(nameQuery, worldNodeHandler.GetDatabaseDispatcher());
+                }
+
+                sideEffects.packets.clear();
+                sideEffects.loggedOutPlayers.clear();
+                sideEffects.nameQueries.clear();
             }
         });
+
+        for (size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(begin + chunkSize, entities.size());
+
+            tf::Task chunkTask = subflow.emplace([&singleton, &characterDatabase, &worldDatabase, &worldNodeHandler, &mapSingleton, view, chunk, begin, end]()
+            {
+                ZoneScopedNC("Connection::Chunk", tracy::Color::Orange2)
+                Access::Scope scope;
+
+                LockRead(SingletonComponent);
+                LockRead(CharacterDatabaseCacheSingleton);
+
+                LockWrite(PlayerConnectionComponent);
+                LockWrite(PlayerFieldDataComponent);
+                LockWrite(PlayerUpdateDataComponent);
+                LockWrite(PlayerPositionComponent);
+
+                ConnectionSideEffects& sideEffects = chunkSideEffects[chunk];
+                for (size_t i = begin; i < end; i++)
+                {
+                    auto [clientConnection, clientFieldData, clientUpdateData, clientPositionData] = view.get<PlayerConnectionComponent, PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerPositionComponent>(entities[i]);
+
+                    PacketContext context = { singleton, characterDatabase, worldDatabase, worldNodeHandler, mapSingleton, sideEffects, clientConnection, clientFieldData, clientUpdateData, clientPositionData };
+                    HandleConnection(context, packetHandlers);
+                }
+            });
+            chunkTask.precede(applySideEffects);
+        }
+
+        return applySideEffects;
     }
 }
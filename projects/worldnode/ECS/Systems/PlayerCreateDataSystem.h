@@ -23,17 +23,19 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <entt.hpp>
 #include <Networking/ByteBuffer.h>
 
 #include "../../NovusEnums.h"
 #include "../../Utils/UpdateData.h"
-#include "../../Utils/UpdateMask.h"
+#include "../../Utils/PlayerUpdateFieldTable.h"
 
 #include "../Components/PlayerConnectionComponent.h"
 #include "../Components/PlayerPositionComponent.h"
 #include "../Components/PlayerInitializeComponent.h"
 #include "../Components/PlayerFieldDataComponent.h"
+#include "../Components/PlayerUpdateDataComponent.h"
 #include "../Components/Singletons/SingletonComponent.h"
 #include "../Components/Singletons/PlayerUpdatesQueueSingleton.h"
 #include "../Components/Singletons/ItemCreateQueueSingleton.h"
@@ -41,7 +43,10 @@
 
 namespace PlayerCreateDataSystem
 {
-    Common::ByteBuffer BuildPlayerCreateData(u64 characterGuid, u8 updateType, u16 updateFlags, u32 visibleFlags, u32 lifeTimeInMS, PlayerFieldDataComponent& playerFieldData, PlayerPositionComponent position, u16& opcode)
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, CharacterDatabaseCacheSingleton>, Writes<PlayerInitializeComponent, PlayerFieldDataComponent, PlayerPositionComponent, PlayerUpdateDataComponent, ItemCreateQueueSingleton>> Access;
+
+    // A single create block, it goes into the update accumulator of every player it is meant for
+    Common::ByteBuffer BuildPlayerCreateBlock(u64 characterGuid, u8 updateType, u16 updateFlags, u32 visibleFlags, u32 lifeTimeInMS, const PlayerFieldDataComponent& playerFieldData, const PlayerPositionComponent& position)
     {
         Common::ByteBuffer buffer(500);
         buffer.Write<u8>(updateType);
@@ -95,174 +100,35 @@ namespace PlayerCreateDataSystem
             }
         }
 
-        Common::ByteBuffer fieldBuffer;
-        fieldBuffer.Resize(5304);
-        UpdateMask<1344> updateMask(PLAYER_END);
-
-        u32* flags = UnitUpdateFieldFlags;
-        u16 fieldNotifyFlags = UF_FLAG_DYNAMIC;
-
-        for (u16 index = 0; index < PLAYER_END; index++)
-        {
-            if (fieldNotifyFlags & flags[index] || ((flags[index] & visibleFlags) & UF_FLAG_SPECIAL_INFO)
-                || ((updateType == 0 ? playerFieldData.changesMask.IsSet(index) : playerFieldData.playerFields.ReadAt<i32>(index * 4))
-                    && (flags[index] & visibleFlags)))
-            {
-                updateMask.SetBit(index);
-
-                if (index == UNIT_NPC_FLAGS)
-                {
-                    u32 appendValue = playerFieldData.playerFields.ReadAt<u32>(UNIT_NPC_FLAGS * 4);
-
-                    /*if (creature)
-                        if (!target->CanSeeSpellClickOn(creature))
-                            appendValue &= ~UNIT_NPC_FLAG_SPELLCLICK;*/
-
-                    fieldBuffer.Write<u32>(appendValue);
-                }
-                else if (index == UNIT_FIELD_AURASTATE)
-                {
-                    // Check per caster aura states to not enable using a spell in client if specified aura is not by target
-                    u32 auraState = playerFieldData.playerFields.ReadAt<u32>(UNIT_FIELD_AURASTATE * 4) &~(((1 << (14 - 1)) | (1 << (16 - 1))));
-
-                    fieldBuffer.Write<u32>(auraState);
-                }
-                // Seems to be fixed already??
-                // FIXME: Some values at server stored in f32 format but must be sent to client in uint32 format
-                else if (index >= UNIT_FIELD_BASEATTACKTIME && index <= UNIT_FIELD_RANGEDATTACKTIME)
-                {
-                    // convert from f32 to uint32 and send
-                    fieldBuffer.Write<u32>(static_cast<u32>(playerFieldData.playerFields.ReadAt<i32>(index * 4)));
-                }
-                // there are some (said f32 in TC, but all these are ints)int values which may be negative or can't get negative due to other checks
-                else if ((index >= UNIT_FIELD_NEGSTAT0 && index <= UNIT_FIELD_NEGSTAT4) ||
-                    (index >= UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE && index <= (UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE + 6)) ||
-                    (index >= UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE && index <= (UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE + 6)) ||
-                    (index >= UNIT_FIELD_POSSTAT0 && index <= UNIT_FIELD_POSSTAT4))
-                {
-                    fieldBuffer.Write<u32>(static_cast<u32>(playerFieldData.playerFields.ReadAt<i32>(index * 4)));
-                }
-                // Gamemasters should be always able to select units - remove not selectable flag
-                else if (index == UNIT_FIELD_FLAGS)
-                {
-                    u32 appendValue = playerFieldData.playerFields.ReadAt<u32>(UNIT_FIELD_FLAGS * 4);
-                    //if (target->IsGameMaster())
-                        //appendValue &= ~UNIT_FLAG_NOT_SELECTABLE;
-
-                    fieldBuffer.Write<u32>(appendValue);
-                }
-                // use modelid_a if not gm, _h if gm for CREATURE_FLAG_EXTRA_TRIGGER creatures
-                else if (index == UNIT_FIELD_DISPLAYID)
-                {
-                    u32 displayId = playerFieldData.playerFields.ReadAt<u32>(UNIT_FIELD_DISPLAYID * 4);
-                    /*if (creature)
-                    {
-                        CreatureTemplate const* cinfo = creature->GetCreatureTemplate();
-                        // this also applies for transform auras
-                        if (SpellInfo const* transform = sSpellMgr->GetSpellInfo(GetTransformSpell()))
-                            for (uint8 i = 0; i < MAX_SPELL_EFFECTS; ++i)
-                                if (transform->Effects[i].IsAura(SPELL_AURA_TRANSFORM))
-                                    if (CreatureTemplate const* transformInfo = sObjectMgr->GetCreatureTemplate(transform->Effects[i].MiscValue))
-                                    {
-                                        cinfo = transformInfo;
-                                        break;
-                                    }
-                        if (cinfo->flags_extra & CREATURE_FLAG_EXTRA_TRIGGER)
-                            if (target->IsGameMaster())
-                                displayId = cinfo->GetFirstVisibleModel();
-                    }*/
-
-                    fieldBuffer.Write<u32>(displayId);
-                }
-                // hide lootable animation for unallowed players
-                else if (index == UNIT_DYNAMIC_FLAGS)
-                {
-                    u32 dynamicFlags = playerFieldData.playerFields.ReadAt<u32>(UNIT_DYNAMIC_FLAGS * 4) & ~(0x4 | 0x08); // UNIT_DYNFLAG_TAPPED | UNIT_DYNFLAG_TAPPED_BY_PLAYER
-
-                    /*if (creature)
-                    {
-                        if (creature->hasLootRecipient())
-                        {
-                            dynamicFlags |= UNIT_DYNFLAG_TAPPED;
-                            if (creature->isTappedBy(target))
-                                dynamicFlags |= UNIT_DYNFLAG_TAPPED_BY_PLAYER;
-                        }
-                        if (!target->isAllowedToLoot(creature))
-                            dynamicFlags &= ~UNIT_DYNFLAG_LOOTABLE;
-                    }*/
-
-                    // unit UNIT_DYNFLAG_TRACK_UNIT should only be sent to caster of SPELL_AURA_MOD_STALKED auras
-                    //if (dynamicFlags & UNIT_DYNFLAG_TRACK_UNIT)
-                        //if (!HasAuraTypeWithCaster(SPELL_AURA_MOD_STALKED, target->GetGUID()))
-                            //dynamicFlags &= ~UNIT_DYNFLAG_TRACK_UNIT;
-
-                    fieldBuffer.Write<u32>(dynamicFlags);
-                }
-                // FG: pretend that OTHER players in own group are friendly ("blue")
-                else if (index == UNIT_FIELD_BYTES_2 || index == UNIT_FIELD_FACTIONTEMPLATE)
-                {
-                    //if (IsControlledByPlayer() && target != this && sWorld->getBoolConfig(CONFIG_ALLOW_TWO_SIDE_INTERACTION_GROUP) && IsInRaidWith(target))
-                    //{
-                        //FactionTemplateEntry const* ft1 = GetFactionTemplateEntry();
-                        //FactionTemplateEntry const* ft2 = target->GetFactionTemplateEntry();
-                        //if (!ft1->IsFriendlyTo(*ft2))
-                        //{
-                            //if (index == UNIT_FIELD_BYTES_2)
-                                // Allow targetting opposite faction in party when enabled in config
-                                //fieldBuffer << (m_uint32Values[UNIT_FIELD_BYTES_2] & ((UNIT_BYTE2_FLAG_SANCTUARY /*| UNIT_BYTE2_FLAG_AURAS | UNIT_BYTE2_FLAG_UNK5*/) << 8)); // this flag is at uint8 offset 1 !!
-                            //else
-                                // pretend that all other HOSTILE players have own faction, to allow follow, heal, rezz (trade wont work)
-                                //fieldBuffer << uint32(target->GetFaction());
-                        //}
-                        //else
-                            //fieldBuffer << m_uint32Values[index];
-                    //}
-                    //else
-                    fieldBuffer.Write(playerFieldData.playerFields.GetDataPointer() + index * 4, 4);
-                }
-                else
-                {
-                    // send in current format (f32 as f32, uint32 as uint32)
-                    fieldBuffer.Write(playerFieldData.playerFields.GetDataPointer() + index * 4, 4);
-                }
-            }
-        }
-
-        buffer.Write<u8>(updateMask.GetBlocks());
-        updateMask.AddTo(buffer);
-        buffer.Append(fieldBuffer);
-
-        UpdateData updateData;
-        updateData.AddBlock(buffer);
-
-        Common::ByteBuffer tempBuffer;
-        updateData.Build(tempBuffer, opcode);
+        const PlayerUpdateFieldTable& fieldTable = GetPlayerUpdateFieldTable(visibleFlags);
+        u32 updateMask[PLAYER_UPDATE_MASK_WORDS];
+        if (updateType == UPDATETYPE_VALUES)
+            BuildPlayerValuesMask(playerFieldData, fieldTable, updateMask);
+        else
+            BuildPlayerCreateMask(playerFieldData, fieldTable, updateMask);
 
-        return tempBuffer;
+        WritePlayerFields(buffer, updateMask, fieldTable, playerFieldData);
+        return buffer;
     }
 
     void Update(entt::registry &registry)
     {
-        auto view = registry.view<PlayerInitializeComponent, PlayerFieldDataComponent, PlayerPositionComponent>();
+        auto view = registry.view<PlayerInitializeComponent, PlayerFieldDataComponent, PlayerPositionComponent, PlayerUpdateDataComponent>();
         if (!view.empty())
         {
             SingletonComponent& singleton = registry.ctx<SingletonComponent>();
-            PlayerUpdatesQueueSingleton& playerUpdatesQueue = registry.ctx<PlayerUpdatesQueueSingleton>();
 			ItemCreateQueueSingleton& itemCreateQueue = registry.ctx<ItemCreateQueueSingleton>();
 			CharacterDatabaseCacheSingleton& characterDatabase = registry.ctx<CharacterDatabaseCacheSingleton>();
             u32 lifeTimeInMS = static_cast<u32>(singleton.lifeTimeInMS);
 
-            auto subView = registry.view<PlayerConnectionComponent, PlayerFieldDataComponent, PlayerPositionComponent>();
-            view.each([&playerUpdatesQueue, &itemCreateQueue, &characterDatabase, lifeTimeInMS, subView](const auto, PlayerInitializeComponent& playerInitializeData, PlayerFieldDataComponent& playerFieldData, PlayerPositionComponent& clientPositionData)
+            view.each([&itemCreateQueue, &characterDatabase, lifeTimeInMS](const auto, PlayerInitializeComponent& playerInitializeData, PlayerFieldDataComponent& playerFieldData, PlayerPositionComponent& clientPositionData, PlayerUpdateDataComponent& playerUpdateData)
             {
-                /* Build Self Packet, must be sent immediately */
+                /* Build Self Packet, the accumulator is still empty so it is the first block the player gets */
                 u8 updateType = UPDATETYPE_CREATE_OBJECT2;
                 u16 selfUpdateFlag = (UPDATEFLAG_SELF | UPDATEFLAG_LIVING | UPDATEFLAG_STATIONARY_POSITION);
                 u32 selfVisibleFlags = (UF_FLAG_PUBLIC | UF_FLAG_PRIVATE);
-                u16 buildOpcode = 0;
 
-                Common::ByteBuffer selfPlayerUpdate = BuildPlayerCreateData(playerInitializeData.characterGuid, updateType, selfUpdateFlag, selfVisibleFlags, lifeTimeInMS, playerFieldData, clientPositionData, buildOpcode);
-                playerInitializeData.socket->SendPacket(selfPlayerUpdate, buildOpcode);
+                playerUpdateData.updateAccumulator.AddBlock(BuildPlayerCreateBlock(playerInitializeData.characterGuid, updateType, selfUpdateFlag, selfVisibleFlags, lifeTimeInMS, playerFieldData, clientPositionData));
 
 				robin_hood::unordered_map<u32, CharacterItemData> characterItemData;
 				if (characterDatabase.cache->GetCharacterItemData(playerInitializeData.characterGuid, characterItemData))
@@ -284,35 +150,7 @@ namespace PlayerCreateDataSystem
 					}
 				}
 
-                /* Build Self Packet for public */
-                u16 publicUpdateFlag = (UPDATEFLAG_LIVING | UPDATEFLAG_STATIONARY_POSITION);
-                u32 publicVisibleFlags = UF_FLAG_PUBLIC;
-
-                PlayerUpdatePacket playerUpdatePacket;
-                playerUpdatePacket.characterGuid = playerInitializeData.characterGuid;
-                playerUpdatePacket.updateType = updateType;
-                playerUpdatePacket.data = BuildPlayerCreateData(playerInitializeData.characterGuid, updateType, publicUpdateFlag, publicVisibleFlags, lifeTimeInMS, playerFieldData, clientPositionData, buildOpcode);
-                playerUpdatePacket.opcode = buildOpcode;
-                playerUpdatesQueue.playerUpdatePacketQueue.push_back(playerUpdatePacket);
-
-                subView.each([&playerUpdatesQueue, &playerInitializeData, lifeTimeInMS](const auto, PlayerConnectionComponent& connection, PlayerFieldDataComponent& fieldData, PlayerPositionComponent& positionData)
-                {
-                    if (playerInitializeData.characterGuid != connection.characterGuid)
-                    {
-                        /* Build Player Packet for self */
-                        u8 updateType = UPDATETYPE_CREATE_OBJECT;
-                        u16 publicUpdateFlag = (UPDATEFLAG_LIVING | UPDATEFLAG_STATIONARY_POSITION);
-                        u32 publicVisibleFlags = UF_FLAG_PUBLIC;
-                        u16 buildOpcode = 0;
-
-                        PlayerUpdatePacket playerUpdatePacket;
-                        playerUpdatePacket.characterGuid = connection.characterGuid;
-                        playerUpdatePacket.updateType = updateType;
-                        playerUpdatePacket.data = BuildPlayerCreateData(connection.characterGuid, updateType, publicUpdateFlag, publicVisibleFlags, lifeTimeInMS, fieldData, positionData, buildOpcode);
-                        playerUpdatePacket.opcode = buildOpcode;
-                        playerUpdatesQueue.playerUpdatePacketQueue.push_back(playerUpdatePacket);
-                    }
-                });
+                // Everyone else is created through VisibilitySystem once the player is placed on the spatial grid
             });
 
             // Remove PlayerInitializeComponent from all entities (They've just been handled above)
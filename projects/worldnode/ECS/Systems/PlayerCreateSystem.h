@@ -23,6 +23,8 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
+#include <Utils/StringUtils.h>
 #include <entt.hpp>
 #include <Networking/ByteBuffer.h>
 
@@ -37,23 +39,34 @@
 #include "../Components/PlayerSkillStorageComponent.h"
 #include "../Components/PlayerInitializeComponent.h"
 #include "../Components/Singletons/SingletonComponent.h"
+#include "../Components/Singletons/ChatSingleton.h"
 #include "../Components/Singletons/PlayerCreateQueueSingleton.h"
 #include "../Components/Singletons/CharacterDatabaseCacheSingleton.h"
 
 namespace PlayerCreateSystem
 {
+    typedef SystemAccess<Reads<CharacterDatabaseCacheSingleton>, Writes<RegistryStorage, SingletonComponent, ChatSingleton, PlayerCreateQueueSingleton, PlayerConnectionComponent, PlayerInitializeComponent, PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerPositionComponent, PlayerSpellStorageComponent, PlayerSkillStorageComponent>> Access;
+
     void Update(entt::registry &registry)
     {
 		SingletonComponent& singleton = registry.ctx<SingletonComponent>();
         PlayerCreateQueueSingleton& createPlayerQueue = registry.ctx<PlayerCreateQueueSingleton>();
+        ChatSingleton& chat = registry.ctx<ChatSingleton>();
         CharacterDatabaseCacheSingleton& characterDatabase = registry.ctx<CharacterDatabaseCacheSingleton>();
 
         Message message;
         while (createPlayerQueue.newPlayerQueue->try_dequeue(message))
         {
             u64 characterGuid = 0;
-            message.packet.Read<u64>(characterGuid);
+            message.packet->Read<u64>(characterGuid);
+
+            // Nothing drained the connection before it had an entity, those packets belong to no player
+            message.connection->DiscardInboundPackets();
+
+            // A logout save may still be in flight, the cached character is the newest copy so keep it
+            characterDatabase.cache->CancelUnloadCharacter(characterGuid);
 
+            // Loads the character if it isn't cached, from here on ConnectionSystem's chunks can rely on finding it in the cache
             CharacterData characterData;
             if (characterDatabase.cache->GetCharacterData(characterGuid, characterData))
             {
@@ -70,6 +83,8 @@ namespace PlayerCreateSystem
                 registry.assign<PlayerSkillStorageComponent>(entity);
 
                 singleton.accountToEntityMap[static_cast<u32>(message.account)] = entity;
+                chat.members[characterGuid] = { entity, characterData.name };
+                chat.memberNames[StringUtils::ToLower(characterData.name)] = characterGuid;
             }
         }
     }
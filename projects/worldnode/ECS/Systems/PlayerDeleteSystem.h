@@ -23,6 +23,7 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <entt.hpp>
 #include <vector>
 #include <Networking/ByteBuffer.h>
@@ -30,48 +31,38 @@
 
 #include "../Components/PlayerConnectionComponent.h"
 #include "../Components/PlayerUpdateDataComponent.h"
+#include "../Components/PlayerFieldDataComponent.h"
+#include "../Components/PlayerPositionComponent.h"
+#include "../Components/PlayerInitializeComponent.h"
+#include "../Components/PlayerSpellStorageComponent.h"
+#include "../Components/PlayerSkillStorageComponent.h"
 #include "../Components/Singletons/SingletonComponent.h"
 #include "../Components/Singletons/PlayerDeleteQueueSingleton.h"
+#include "../Components/Singletons/SpatialGridSingleton.h"
+#include "../Components/Singletons/ChatSingleton.h"
+#include "SpatialGridSystem.h"
+#include "ChatSystem.h"
 
 namespace PlayerDeleteSystem
 {
+    // Destroying an entity removes it from every pool it is in, so every component a player can have counts as written
+    typedef SystemAccess<Reads<>, Writes<RegistryStorage, SingletonComponent, PlayerDeleteQueueSingleton, SpatialGridSingleton, ChatSingleton, PlayerConnectionComponent, PlayerInitializeComponent, PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerPositionComponent, PlayerSpellStorageComponent, PlayerSkillStorageComponent>> Access;
+
     void Update(entt::registry &registry)
     {
 		SingletonComponent& singleton = registry.ctx<SingletonComponent>();
         PlayerDeleteQueueSingleton& deletePlayerQueue = registry.ctx<PlayerDeleteQueueSingleton>();
+        SpatialGridSingleton& spatialGrid = registry.ctx<SpatialGridSingleton>();
+        ChatSingleton& chat = registry.ctx<ChatSingleton>();
 
-        Common::ByteBuffer buildPacket;
-        std::vector<u64> deletedEntities;
-        UpdateData updateData;
-
+        // Once the entity is off the grid VisibilitySystem sends the out of range block to everyone who could see it
         ExpiredPlayerData expiredPlayerData;
         while (deletePlayerQueue.expiredEntityQueue->try_dequeue(expiredPlayerData))
         {
-            updateData.AddGuid(expiredPlayerData.characterGuid);
-            deletedEntities.push_back(expiredPlayerData.characterGuid);
+            SpatialGridSystem::RemoveEntity(spatialGrid, expiredPlayerData.entityGuid);
+            ChatSystem::RemoveMember(chat, expiredPlayerData.characterGuid, expiredPlayerData.entityGuid);
             registry.destroy(expiredPlayerData.entityGuid);
             singleton.accountToEntityMap.erase(expiredPlayerData.accountGuid);
         }
-
-        if (!updateData.IsEmpty())
-        {
-            u16 buildOpcode = 0;
-            updateData.Build(buildPacket, buildOpcode);
-
-            auto view = registry.view<PlayerConnectionComponent, PlayerUpdateDataComponent>();
-            view.each([&buildPacket, &deletedEntities, buildOpcode](const auto, PlayerConnectionComponent& playerConnection, PlayerUpdateDataComponent& playerUpdateData)
-            {
-                playerConnection.socket->SendPacket(buildPacket, buildOpcode);
-
-                for (u64 guid : deletedEntities)
-                {
-                    auto position = std::find(playerUpdateData.visibleGuids.begin(), playerUpdateData.visibleGuids.end(), guid);
-                    if (position != playerUpdateData.visibleGuids.end())
-                    {
-                        playerUpdateData.visibleGuids.erase(position);
-                    }
-                }
-            });
-        }
     }
-}
+}
\ No newline at end of file
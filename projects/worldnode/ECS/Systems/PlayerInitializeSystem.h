@@ -1,5 +1,6 @@
 #include "PlayerConnectionSystem.h"
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <Networking/Opcode/Opcode.h>
 
 #include "../../NovusEnums.h"
@@ -16,6 +17,8 @@
 
 namespace PlayerInitializeSystem
 {
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, CharacterDatabaseCacheSingleton, PlayerInitializeComponent>, Writes<PlayerFieldDataComponent, PlayerPositionComponent, PlayerSpellStorageComponent, PlayerSkillStorageComponent>> Access;
+
     void Update(entt::registry &registry)
     {
         SingletonComponent& singleton = registry.ctx<SingletonComponent>();
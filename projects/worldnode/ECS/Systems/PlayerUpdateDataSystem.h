@@ -23,10 +23,13 @@
 */
 #pragma once
 #include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
 #include <entt.hpp>
 #include <Networking/ByteBuffer.h>
 
 #include "../../NovusEnums.h"
+#include "../../Utils/PlayerUpdateFieldTable.h"
+#include "../../Game/MovementRelay.h"
 
 #include "../Components/PlayerConnectionComponent.h"
 #include "../Components/PlayerFieldDataComponent.h"
@@ -38,7 +41,9 @@
 
 namespace PlayerUpdateDataSystem
 {
-    Common::ByteBuffer BuildPlayerUpdateData(u64 playerGuid, u32 visibleFlags, PlayerFieldDataComponent& playerFieldData, u16& opcode)
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, PlayerConnectionComponent, PlayerPositionComponent>, Writes<PlayerFieldDataComponent, PlayerUpdateDataComponent, PlayerUpdatesQueueSingleton>> Access;
+
+    Common::ByteBuffer BuildPlayerUpdateBlock(u64 playerGuid, u32 visibleFlags, PlayerFieldDataComponent& playerFieldData)
     {
 		ZoneScopedNC("BuildplayerFieldData", tracy::Color::Yellow2)
 
@@ -46,163 +51,19 @@ namespace PlayerUpdateDataSystem
         buffer.Write<u8>(UPDATETYPE_VALUES);
         buffer.AppendGuid(playerGuid);
 
-		// Offset end of buffer
-        Common::ByteBuffer fieldBuffer;
-        fieldBuffer.Resize(5304);
-        UpdateMask<1344> updateMask(PLAYER_END);
-
-        u32* flags = UnitUpdateFieldFlags;
-        u16 fieldNotifyFlags = UF_FLAG_DYNAMIC;
-
-		{
-			ZoneScopedNC("BuildplayerFieldData::Loop", tracy::Color::Yellow2)
-			for (u16 index = 0; index < PLAYER_END; index++)
-			{
-				if (fieldNotifyFlags & flags[index] || ((flags[index] & visibleFlags) & UF_FLAG_SPECIAL_INFO) ||
-					(playerFieldData.changesMask.IsSet(index) && (flags[index] & visibleFlags)))
-				{
-					updateMask.SetBit(index);
-					// Increment Counter
-
-					if (index == UNIT_NPC_FLAGS)
-					{
-						u32 appendValue = playerFieldData.playerFields.ReadAt<u32>(UNIT_NPC_FLAGS * 4);
-
-						/*if (creature)
-							if (!target->CanSeeSpellClickOn(creature))
-								appendValue &= ~UNIT_NPC_FLAG_SPELLCLICK;*/
-
-						fieldBuffer.Write<u32>(appendValue);
-					}
-					else if (index == UNIT_FIELD_AURASTATE)
-					{
-						// Check per caster aura states to not enable using a spell in client if specified aura is not by target
-						u32 auraState = playerFieldData.playerFields.ReadAt<u32>(UNIT_FIELD_AURASTATE * 4) &~(((1 << (14 - 1)) | (1 << (16 - 1))));
-
-						fieldBuffer.Write<u32>(auraState);
-					}
-					// Seems to be fixed already??
-					// FIXME: Some values at server stored in f32 format but must be sent to client in uint32 format
-					else if (index >= UNIT_FIELD_BASEATTACKTIME && index <= UNIT_FIELD_RANGEDATTACKTIME)
-					{
-					// convert from f32 to uint32 and send
-					fieldBuffer.Write<u32>(static_cast<u32>(playerFieldData.playerFields.ReadAt<i32>(index * 4)));
-					}
-					// there are some (said f32 in TC, but all these are ints)int values which may be negative or can't get negative due to other checks
-					else if ((index >= UNIT_FIELD_NEGSTAT0 && index <= UNIT_FIELD_NEGSTAT4) ||
-					(index >= UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE && index <= (UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE + 6)) ||
-					(index >= UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE && index <= (UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE + 6)) ||
-					(index >= UNIT_FIELD_POSSTAT0 && index <= UNIT_FIELD_POSSTAT4))
-					{
-					fieldBuffer.Write<u32>(static_cast<u32>(playerFieldData.playerFields.ReadAt<i32>(index * 4)));
-					}
-					// Gamemasters should be always able to select units - remove not selectable flag
-					else if (index == UNIT_FIELD_FLAGS)
-					{
-					u32 appendValue = playerFieldData.playerFields.ReadAt<u32>(UNIT_FIELD_FLAGS * 4);
-					//if (target->IsGameMaster())
-						//appendValue &= ~UNIT_FLAG_NOT_SELECTABLE;
-
-					fieldBuffer.Write<u32>(appendValue);
-					}
-					// use modelid_a if not gm, _h if gm for CREATURE_FLAG_EXTRA_TRIGGER creatures
-					else if (index == UNIT_FIELD_DISPLAYID)
-					{
-					u32 displayId = playerFieldData.playerFields.ReadAt<u32>(UNIT_FIELD_DISPLAYID * 4);
-					/*if (creature)
-					{
-						CreatureTemplate const* cinfo = creature->GetCreatureTemplate();
-						// this also applies for transform auras
-						if (SpellInfo const* transform = sSpellMgr->GetSpellInfo(GetTransformSpell()))
-							for (uint8 i = 0; i < MAX_SPELL_EFFECTS; ++i)
-								if (transform->Effects[i].IsAura(SPELL_AURA_TRANSFORM))
-									if (CreatureTemplate const* transformInfo = sObjectMgr->GetCreatureTemplate(transform->Effects[i].MiscValue))
-									{
-										cinfo = transformInfo;
-										break;
-									}
-						if (cinfo->flags_extra & CREATURE_FLAG_EXTRA_TRIGGER)
-							if (target->IsGameMaster())
-								displayId = cinfo->GetFirstVisibleModel();
-					}*/
-
-					fieldBuffer.Write<u32>(displayId);
-					}
-					// hide lootable animation for unallowed players
-					else if (index == UNIT_DYNAMIC_FLAGS)
-					{
-					u32 dynamicFlags = playerFieldData.playerFields.ReadAt<u32>(UNIT_DYNAMIC_FLAGS * 4) & ~(0x4 | 0x08); // UNIT_DYNFLAG_TAPPED | UNIT_DYNFLAG_TAPPED_BY_PLAYER
-
-					/*if (creature)
-					{
-						if (creature->hasLootRecipient())
-						{
-							dynamicFlags |= UNIT_DYNFLAG_TAPPED;
-							if (creature->isTappedBy(target))
-								dynamicFlags |= UNIT_DYNFLAG_TAPPED_BY_PLAYER;
-						}
-						if (!target->isAllowedToLoot(creature))
-							dynamicFlags &= ~UNIT_DYNFLAG_LOOTABLE;
-					}*/
-
-					// unit UNIT_DYNFLAG_TRACK_UNIT should only be sent to caster of SPELL_AURA_MOD_STALKED auras
-					//if (dynamicFlags & UNIT_DYNFLAG_TRACK_UNIT)
-						//if (!HasAuraTypeWithCaster(SPELL_AURA_MOD_STALKED, target->GetGUID()))
-							//dynamicFlags &= ~UNIT_DYNFLAG_TRACK_UNIT;
-
-					fieldBuffer.Write<u32>(dynamicFlags);
-					}
-					// FG: pretend that OTHER players in own group are friendly ("blue")
-					else if (index == UNIT_FIELD_BYTES_2 || index == UNIT_FIELD_FACTIONTEMPLATE)
-					{
-					//if (IsControlledByPlayer() && target != this && sWorld->getBoolConfig(CONFIG_ALLOW_TWO_SIDE_INTERACTION_GROUP) && IsInRaidWith(target))
-					//{
-						//FactionTemplateEntry const* ft1 = GetFactionTemplateEntry();
-						//FactionTemplateEntry const* ft2 = target->GetFactionTemplateEntry();
-						//if (!ft1->IsFriendlyTo(*ft2))
-						//{
-							//if (index == UNIT_FIELD_BYTES_2)
-								// Allow targetting opposite faction in party when enabled in config
-								//fieldBuffer << (m_uint32Values[UNIT_FIELD_BYTES_2] & ((UNIT_BYTE2_FLAG_SANCTUARY /*| UNIT_BYTE2_FLAG_AURAS | UNIT_BYTE2_FLAG_UNK5*/) << 8)); // this flag is at uint8 offset 1 !!
-							//else
-								// pretend that all other HOSTILE players have own faction, to allow follow, heal, rezz (trade wont work)
-								//fieldBuffer << uint32(target->GetFaction());
-						//}
-						//else
-							//fieldBuffer << m_uint32Values[index];
-					//}
-					//else
-					fieldBuffer.Write(playerFieldData.playerFields.GetDataPointer() + index * 4, 4);
-					}
-					else
-					{
-					// send in current format (f32 as f32, uint32 as uint32)
-					fieldBuffer.Write(playerFieldData.playerFields.GetDataPointer() + index * 4, 4);
-					}
-				}
-			}
-		}
-
+        const PlayerUpdateFieldTable& fieldTable = GetPlayerUpdateFieldTable(visibleFlags);
+        u32 updateMask[PLAYER_UPDATE_MASK_WORDS];
 		{
-			ZoneScopedNC("BuildplayerFieldData::GetBlocks", tracy::Color::Yellow2)
-			buffer.Write<u8>(updateMask.GetBlocks());
-			updateMask.AddTo(buffer);
-			buffer.Append(fieldBuffer);
+			ZoneScopedNC("BuildplayerFieldData::Mask", tracy::Color::Yellow2)
+			BuildPlayerValuesMask(playerFieldData, fieldTable, updateMask);
 		}
 
-		UpdateData updateData;
 		{
-			ZoneScopedNC("BuildplayerFieldData::AddBlock", tracy::Color::Yellow2)
-			updateData.AddBlock(buffer);
+			ZoneScopedNC("BuildplayerFieldData::Fields", tracy::Color::Yellow2)
+			WritePlayerFields(buffer, updateMask, fieldTable, playerFieldData);
 		}
 
-        Common::ByteBuffer tempBuffer;
-		{
-			ZoneScopedNC("BuildplayerFieldData::Build", tracy::Color::Yellow2)
-			updateData.Build(tempBuffer, opcode);
-		}
-
-        return tempBuffer;
+        return buffer;
     }
 
     void Update(entt::registry &registry)
@@ -220,8 +81,6 @@ namespace PlayerUpdateDataSystem
 				ZoneScopedNC("Build Packet", tracy::Color::Yellow2)
                 /* Build Self Packet, must be sent immediately */
                 u32 selfVisibleFlags = (UF_FLAG_PUBLIC | UF_FLAG_PRIVATE);
-                u16 buildOpcode = 0;
-
 				// Currently we have not observed any issues with sending private field flags to any other client but themselves, this offers a good speed increase but if we see issues in the future we should recheck this.
                 /*NovusHeader novusHeader;
                 Common::ByteBuffer selfPlayerUpdate = BuildplayerFieldData(clientConnection.characterGuid, selfVisibleFlags, clientFieldData, buildOpcode);
@@ -230,12 +89,11 @@ namespace PlayerUpdateDataSystem
 
                 /* Build Self Packet for public */
                 u32 publicVisibleFlags = UF_FLAG_PUBLIC;
-                PlayerUpdatePacket playerUpdatePacket;
-                playerUpdatePacket.characterGuid = clientConnection.characterGuid;
-                playerUpdatePacket.updateType = UPDATETYPE_VALUES;
-                playerUpdatePacket.data = BuildPlayerUpdateData(clientConnection.characterGuid, selfVisibleFlags, clientFieldData, buildOpcode);
-                playerUpdatePacket.opcode = buildOpcode;
-                playerUpdatesQueue.playerUpdatePacketQueue.push_back(playerUpdatePacket);
+                PlayerUpdateBlock playerUpdateBlock;
+                playerUpdateBlock.characterGuid = clientConnection.characterGuid;
+                playerUpdateBlock.updateType = UPDATETYPE_VALUES;
+                playerUpdateBlock.data = BuildPlayerUpdateBlock(clientConnection.characterGuid, selfVisibleFlags, clientFieldData);
+                playerUpdatesQueue.playerUpdateBlockQueue.push_back(std::move(playerUpdateBlock));
 
                 // Clear Updates
                 clientFieldData.changesMask.Reset();
@@ -244,53 +102,37 @@ namespace PlayerUpdateDataSystem
             if (clientUpdateData.positionUpdateData.size() > 0)
             {
 				ZoneScopedNC("PositionUpdate", tracy::Color::Yellow2)
-                for (PositionUpdateData positionData : clientUpdateData.positionUpdateData)
+                // A heartbeat followed by any other movement from this player within the tick is superseded by it, transitions are always relayed
+                size_t positionUpdateCount = clientUpdateData.positionUpdateData.size();
+                u32 supersededHeartbeats = 0;
+                for (size_t i = 0; i < positionUpdateCount; i++)
                 {
+                    const PositionUpdateData& positionData = clientUpdateData.positionUpdateData[i];
+                    bool isHeartbeat = MovementRelay::IsHeartbeat(positionData.opcode);
+                    if (isHeartbeat && i + 1 < positionUpdateCount)
+                    {
+                        supersededHeartbeats++;
+                        continue;
+                    }
+
                     MovementPacket movementPacket;
                     movementPacket.opcode = positionData.opcode;
                     movementPacket.characterGuid = clientConnection.characterGuid;
+                    movementPacket.x = positionData.x;
+                    movementPacket.y = positionData.y;
+                    movementPacket.heartbeatSequence = isHeartbeat ? clientUpdateData.heartbeatSequence++ : 0;
+                    movementPacket.supersededHeartbeats = supersededHeartbeats;
+                    supersededHeartbeats = 0;
 
-                    movementPacket.data.AppendGuid(movementPacket.characterGuid);
-                    movementPacket.data.Write<u32>(positionData.movementFlags);
-                    movementPacket.data.Write<u16>(positionData.movementFlagsExtra);
-                    movementPacket.data.Write<u32>(positionData.gameTime);
-                    movementPacket.data.Write<f32>(positionData.x);
-                    movementPacket.data.Write<f32>(positionData.y);
-                    movementPacket.data.Write<f32>(positionData.z);
-                    movementPacket.data.Write<f32>(positionData.orientation);
-                    movementPacket.data.Write<u32>(positionData.fallTime);
+                    movementPacket.data = Common::BaseSocket::GetSendPool().Acquire(0);
+                    movementPacket.data->AppendGuid(movementPacket.characterGuid);
+                    MovementInfoSchema::Write(*movementPacket.data, positionData);
 
-                    playerUpdatesQueue.playerMovementPacketQueue.push_back(movementPacket);
+                    playerUpdatesQueue.playerMovementPacketQueue.push_back(std::move(movementPacket));
                 }
                 // Clear Position Updates
                 clientUpdateData.positionUpdateData.clear();
             }
-
-            if (clientUpdateData.chatUpdateData.size() > 0)
-            {
-				ZoneScopedNC("ChatUpdate", tracy::Color::Yellow2)
-                for (ChatUpdateData chatData : clientUpdateData.chatUpdateData)
-                {
-                    ChatPacket chatPacket;
-
-                    chatPacket.data.Write<u8>(chatData.chatType);
-                    chatPacket.data.Write<i32>(chatData.language);
-                    chatPacket.data.Write<u64>(chatData.sender);
-                    chatPacket.data.Write<u32>(0); // Chat Flag (??)
-
-                    // This is based on chatType
-                    chatPacket.data.Write<u64>(0); // Receiver (0) for none
-
-                    chatPacket.data.Write<u32>(static_cast<u32>(chatData.message.length()) + 1);
-                    chatPacket.data.WriteString(chatData.message);
-                    chatPacket.data.Write<u8>(0); // Chat Tag
-
-                    playerUpdatesQueue.playerChatPacketQueue.push_back(chatPacket);
-                }
-
-                // Clear Chat Updates
-                clientUpdateData.chatUpdateData.clear();
-            }
         });
     }
 }
@@ -0,0 +1,76 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
+#include <entt.hpp>
+
+#include "../Components/PlayerPositionComponent.h"
+#include "../Components/Singletons/SpatialGridSingleton.h"
+
+#include <tracy/Tracy.hpp>
+
+namespace SpatialGridSystem
+{
+    typedef SystemAccess<Reads<RegistryStorage, PlayerPositionComponent>, Writes<SpatialGridSingleton>> Access;
+
+    void Update(entt::registry &registry)
+    {
+        SpatialGridSingleton& spatialGrid = registry.ctx<SpatialGridSingleton>();
+
+        auto view = registry.view<PlayerPositionComponent>();
+        view.each([&spatialGrid](const auto entity, PlayerPositionComponent& position)
+        {
+            u32 entityId = static_cast<u32>(entity);
+
+            auto itr = spatialGrid.entityMaps.find(entityId);
+            if (itr == spatialGrid.entityMaps.end())
+            {
+                spatialGrid.GetGrid(position.mapId).Insert(entityId, position.x, position.y);
+                spatialGrid.entityMaps[entityId] = position.mapId;
+            }
+            else if (itr->second != position.mapId)
+            {
+                spatialGrid.GetGrid(itr->second).Remove(entityId);
+                spatialGrid.GetGrid(position.mapId).Insert(entityId, position.x, position.y);
+                itr->second = position.mapId;
+            }
+            else
+            {
+                spatialGrid.GetGrid(position.mapId).Move(entityId, position.x, position.y);
+            }
+        });
+    }
+
+    // Destroyed entities have to be taken out explicitly, the view above never sees them again
+    void RemoveEntity(SpatialGridSingleton& spatialGrid, u32 entityId)
+    {
+        auto itr = spatialGrid.entityMaps.find(entityId);
+        if (itr == spatialGrid.entityMaps.end())
+            return;
+
+        spatialGrid.GetGrid(itr->second).Remove(entityId);
+        spatialGrid.entityMaps.erase(itr);
+    }
+}
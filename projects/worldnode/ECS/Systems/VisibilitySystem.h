@@ -0,0 +1,127 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
+#include <entt.hpp>
+#include <Networking/ByteBuffer.h>
+
+#include "../../NovusEnums.h"
+#include "../../Utils/UpdateData.h"
+#include "../../Game/SpatialGrid.h"
+
+#include "../Components/PlayerConnectionComponent.h"
+#include "../Components/PlayerFieldDataComponent.h"
+#include "../Components/PlayerPositionComponent.h"
+#include "../Components/PlayerUpdateDataComponent.h"
+#include "../Components/Singletons/SingletonComponent.h"
+#include "../Components/Singletons/SpatialGridSingleton.h"
+#include "PlayerCreateDataSystem.h"
+
+#include <tracy/Tracy.hpp>
+
+namespace VisibilitySystem
+{
+    typedef SystemAccess<Reads<RegistryStorage, SingletonComponent, SpatialGridSingleton, PlayerConnectionComponent, PlayerFieldDataComponent, PlayerPositionComponent>, Writes<PlayerUpdateDataComponent>> Access;
+
+    // Objects already visible stay visible up to this much further than the visibility range, so standing at the edge doesn't flicker
+    constexpr f32 VISIBILITY_LEAVE_MARGIN = 0.1f;
+
+    /*
+        Diffs what every player can see against what they were last sent. Objects that came into range get a create block,
+        objects that went out of range or stopped existing are listed in one out of range block, both go into the player's update accumulator.
+    */
+    void Update(entt::registry &registry)
+    {
+        SingletonComponent& singleton = registry.ctx<SingletonComponent>();
+        SpatialGridSingleton& spatialGrid = registry.ctx<SpatialGridSingleton>();
+        u32 lifeTimeInMS = static_cast<u32>(singleton.lifeTimeInMS);
+
+        f32 enterRangeSquared = spatialGrid.visibilityRange * spatialGrid.visibilityRange;
+        f32 leaveRange = spatialGrid.visibilityRange * (1.0f + VISIBILITY_LEAVE_MARGIN);
+
+        static u32 visibilityPass = 0;
+        visibilityPass++;
+
+        // Create blocks don't depend on the observer, so each one is built at most once per tick
+        static robin_hood::unordered_map<u32, Common::ByteBuffer> createBlocks;
+        createBlocks.clear();
+
+        auto view = registry.view<PlayerConnectionComponent, PlayerUpdateDataComponent, PlayerPositionComponent>();
+        view.each([&registry, &spatialGrid, &view, enterRangeSquared, leaveRange, lifeTimeInMS](const auto entity, PlayerConnectionComponent&, PlayerUpdateDataComponent& playerUpdateData, PlayerPositionComponent& playerPosition)
+        {
+            u32 observer = static_cast<u32>(entity);
+            UpdateData& updateData = playerUpdateData.updateAccumulator;
+
+            if (const SpatialGrid* grid = spatialGrid.FindGrid(playerPosition.mapId))
+            {
+                grid->QueryRadius(playerPosition.x, playerPosition.y, leaveRange, [&](const SpatialGrid::Entry& entry)
+                {
+                    if (entry.entity == observer)
+                        return;
+
+                    u64 characterGuid = view.get<PlayerConnectionComponent>(entry.entity).characterGuid;
+                    auto visibleGuid = playerUpdateData.visibleGuids.find(characterGuid);
+                    if (visibleGuid != playerUpdateData.visibleGuids.end())
+                    {
+                        visibleGuid->second = visibilityPass;
+                        return;
+                    }
+
+                    f32 deltaX = entry.x - playerPosition.x;
+                    f32 deltaY = entry.y - playerPosition.y;
+                    if (deltaX * deltaX + deltaY * deltaY > enterRangeSquared)
+                        return;
+
+                    auto createBlock = createBlocks.find(entry.entity);
+                    if (createBlock == createBlocks.end())
+                    {
+                        u16 publicUpdateFlag = (UPDATEFLAG_LIVING | UPDATEFLAG_STATIONARY_POSITION);
+                        const PlayerFieldDataComponent& fieldData = registry.get<PlayerFieldDataComponent>(entry.entity);
+                        const PlayerPositionComponent& position = view.get<PlayerPositionComponent>(entry.entity);
+
+                        createBlock = createBlocks.emplace(entry.entity, PlayerCreateDataSystem::BuildPlayerCreateBlock(characterGuid, UPDATETYPE_CREATE_OBJECT, publicUpdateFlag, UF_FLAG_PUBLIC, lifeTimeInMS, fieldData, position)).first;
+                    }
+
+                    updateData.AddBlock(createBlock->second);
+                    playerUpdateData.visibleGuids[characterGuid] = visibilityPass;
+                });
+            }
+
+            // Anything not seen during this pass is out of range, on another map or gone
+            for (auto itr = playerUpdateData.visibleGuids.begin(); itr != playerUpdateData.visibleGuids.end();)
+            {
+                if (itr->second != visibilityPass)
+                {
+                    updateData.AddGuid(itr->first);
+                    itr = playerUpdateData.visibleGuids.erase(itr);
+                }
+                else
+                {
+                    ++itr;
+                }
+            }
+        });
+    }
+}
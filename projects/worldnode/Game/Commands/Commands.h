@@ -56,7 +56,7 @@ namespace Commands
         PlayerPacketQueueSingleton& playerPacketQueue = _registry->ctx<PlayerPacketQueueSingleton>();
 
         Common::ByteBuffer redirect;
-        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, redirect, Common::Opcode::SMSG_REDIRECT_CLIENT));
+        playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), redirect, Common::Opcode::SMSG_REDIRECT_CLIENT));
 
         return true;
     }
@@ -74,7 +74,7 @@ namespace Commands_Character
                     achievementData.Write<u32>(((lt.tm_year - 100) << 24 | lt.tm_mon << 20 | (lt.tm_mday - 1) << 14 | lt.tm_wday << 11 | lt.tm_hour << 6 | lt.tm_min));
                     achievementData.Write<u32>(0);
 
-                    playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, achievementData, Common::Opcode::SMSG_ACHIEVEMENT_EARNED));
+                    playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), achievementData, Common::Opcode::SMSG_ACHIEVEMENT_EARNED));
                 }
             }
 
@@ -99,25 +99,25 @@ namespace Commands_Character
 
             Common::ByteBuffer speedChange;
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_WALK_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_WALK_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_WALK_SPEED_CHANGE));
 
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_RUN_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_RUN_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_RUN_SPEED_CHANGE));
 
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_RUN_BACK_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_RUN_BACK_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_RUN_BACK_SPEED_CHANGE));
 
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_SWIM_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_SWIM_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_SWIM_SPEED_CHANGE));
 
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_SWIM_BACK_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_SWIM_BACK_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_SWIM_BACK_SPEED_CHANGE));
 
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_FLIGHT_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_FLIGHT_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_FLIGHT_SPEED_CHANGE));
 
             CharacterUtils::BuildSpeedChangePacket(clientConnection.accountGuid, clientConnection.characterGuid, speed, Common::Opcode::SMSG_FORCE_FLIGHT_BACK_SPEED_CHANGE, speedChange);
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, speedChange, Common::Opcode::SMSG_FORCE_FLIGHT_BACK_SPEED_CHANGE));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), speedChange, Common::Opcode::SMSG_FORCE_FLIGHT_BACK_SPEED_CHANGE));
 
             clientConnection.SendNotification("Speed Updated: %f", speed);
             return true;
@@ -138,7 +138,7 @@ namespace Commands_Character
 
                 Common::ByteBuffer setFly;
                 CharacterUtils::BuildFlyModePacket(clientConnection.accountGuid, clientConnection.characterGuid, flightState == "on", setFly);
-                playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, setFly, flightState == "on" ? Common::Opcode::SMSG_MOVE_SET_CAN_FLY : Common::Opcode::SMSG_MOVE_UNSET_CAN_FLY));
+                playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), setFly, flightState == "on" ? Common::Opcode::SMSG_MOVE_SET_CAN_FLY : Common::Opcode::SMSG_MOVE_UNSET_CAN_FLY));
 
                 clientConnection.SendNotification("Flight Mode: %s", flightState.c_str());
                 return true;
@@ -178,7 +178,7 @@ namespace Commands_Character
 
             buffer.Write<u32>(0);
 
-            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket, buffer, Common::Opcode::MSG_MOVE_TELEPORT_ACK));
+            playerPacketQueue.packetQueue->enqueue(PacketQueueData(clientConnection.socket.get(), buffer, Common::Opcode::MSG_MOVE_TELEPORT_ACK));
 
             return true;
         }
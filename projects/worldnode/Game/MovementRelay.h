@@ -0,0 +1,95 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/Opcode/Opcode.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+struct HeartbeatRelayStep
+{
+    f32 distance; // Observers at least this far from the mover...
+    u32 interval; // ...only get every interval-th heartbeat
+};
+
+struct MovementRelaySettings
+{
+    std::vector<HeartbeatRelayStep> heartbeatCurve;
+};
+
+struct MovementRelayStats
+{
+    std::atomic<u64> relayedPackets;
+    std::atomic<u64> relayedBytes;
+    std::atomic<u64> coalescedPackets; // Heartbeats superseded by a later movement of the same mover within the tick, counted per observer
+    std::atomic<u64> coalescedBytes;
+    std::atomic<u64> decimatedPackets; // Heartbeats held back from distant observers
+    std::atomic<u64> decimatedBytes;
+};
+
+/*
+    Movement is relayed once per mover and tick. Heartbeats only refresh the position, so any later movement from the same mover
+    makes them redundant and distant observers can do with fewer of them, start, stop and every other transition always goes out.
+*/
+class MovementRelay
+{
+public:
+    // Server header in front of every movement packet, they never get large enough to need the long header
+    static constexpr u32 PACKET_HEADER_SIZE = 4;
+
+    static void Setup(const MovementRelaySettings& settings)
+    {
+        _heartbeatCurve.clear();
+        for (const HeartbeatRelayStep& step : settings.heartbeatCurve)
+        {
+            if (step.interval > 1)
+                _heartbeatCurve.push_back({ step.distance * step.distance, step.interval });
+        }
+
+        std::sort(_heartbeatCurve.begin(), _heartbeatCurve.end(), [](const HeartbeatRelayStep& a, const HeartbeatRelayStep& b) { return a.distance < b.distance; });
+    }
+    static MovementRelayStats& GetStats() { return _stats; }
+
+    static bool IsHeartbeat(u16 opcode) { return opcode == Common::Opcode::MSG_MOVE_HEARTBEAT; }
+
+    // Every heartbeat of a mover carries a sequence number, observers relay the ones that line up with the interval for their distance
+    static bool ShouldRelayHeartbeat(u32 heartbeatSequence, f32 distanceSquared)
+    {
+        u32 interval = 1;
+        for (const HeartbeatRelayStep& step : _heartbeatCurve)
+        {
+            if (distanceSquared < step.distance)
+                break;
+
+            interval = step.interval;
+        }
+
+        return heartbeatSequence % interval == 0;
+    }
+
+private:
+    inline static std::vector<HeartbeatRelayStep> _heartbeatCurve; // Distances are stored squared
+    inline static MovementRelayStats _stats = {};
+};
@@ -0,0 +1,196 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <limits>
+#include <robin_hood.h>
+#include <cmath>
+#include <vector>
+
+struct InterestSettings
+{
+    f32 gridCellSize = 50.0f;
+    f32 visibilityRange = 100.0f;
+    f32 sayRange = 25.0f;
+    f32 yellRange = 300.0f;
+    f32 emoteRange = 25.0f;
+};
+
+/*
+    Uniform grid over the x/y plane of a single map. Entities are bucketed by the cell their position falls in, so finding everything
+    around a point only looks at the handful of cells overlapping the query instead of every entity on the map.
+*/
+class SpatialGrid
+{
+public:
+    struct Entry
+    {
+        u32 entity;
+        f32 x;
+        f32 y;
+    };
+
+    SpatialGrid(f32 cellSize = 50.0f) : _cellSize(cellSize), _inverseCellSize(1.0f / cellSize) { }
+
+    void Insert(u32 entity, f32 x, f32 y)
+    {
+        if (_locations.find(entity) != _locations.end())
+        {
+            Move(entity, x, y);
+            return;
+        }
+
+        u64 cellKey = GetCellKey(x, y);
+        std::vector<Entry>& cell = _cells[cellKey];
+
+        _locations[entity] = { cellKey, static_cast<u32>(cell.size()) };
+        cell.push_back({ entity, x, y });
+    }
+
+    // Only touches the cells involved when the entity actually crossed into another one
+    void Move(u32 entity, f32 x, f32 y)
+    {
+        auto location = _locations.find(entity);
+        if (location == _locations.end())
+        {
+            Insert(entity, x, y);
+            return;
+        }
+
+        u64 cellKey = GetCellKey(x, y);
+        if (cellKey == location->second.cellKey)
+        {
+            Entry& entry = _cells[cellKey][location->second.index];
+            entry.x = x;
+            entry.y = y;
+            return;
+        }
+
+        RemoveFromCell(location->second);
+
+        std::vector<Entry>& cell = _cells[cellKey];
+        location->second = { cellKey, static_cast<u32>(cell.size()) };
+        cell.push_back({ entity, x, y });
+    }
+
+    void Remove(u32 entity)
+    {
+        auto location = _locations.find(entity);
+        if (location == _locations.end())
+            return;
+
+        RemoveFromCell(location->second);
+        _locations.erase(location);
+    }
+
+    bool Contains(u32 entity) const { return _locations.find(entity) != _locations.end(); }
+    size_t Size() const { return _locations.size(); }
+    size_t GetCellCount() const { return _cells.size(); }
+    f32 GetCellSize() const { return _cellSize; }
+
+    // Calls func(const Entry&) for every entity within radius of x, y
+    template <typename Func>
+    void QueryRadius(f32 x, f32 y, f32 radius, Func&& func) const
+    {
+        i32 minCellX = GetCellCoordinate(x - radius);
+        i32 maxCellX = GetCellCoordinate(x + radius);
+        i32 minCellY = GetCellCoordinate(y - radius);
+        i32 maxCellY = GetCellCoordinate(y + radius);
+        f32 radiusSquared = radius * radius;
+
+        for (i32 cellX = minCellX; cellX <= maxCellX; cellX++)
+        {
+            for (i32 cellY = minCellY; cellY <= maxCellY; cellY++)
+            {
+                auto cell = _cells.find(MakeCellKey(cellX, cellY));
+                if (cell == _cells.end())
+                    continue;
+
+                for (const Entry& entry : cell->second)
+                {
+                    f32 deltaX = entry.x - x;
+                    f32 deltaY = entry.y - y;
+                    if (deltaX * deltaX + deltaY * deltaY <= radiusSquared)
+                        func(entry);
+                }
+            }
+        }
+    }
+    void QueryRadius(f32 x, f32 y, f32 radius, std::vector<u32>& entities) const
+    {
+        QueryRadius(x, y, radius, [&entities](const Entry& entry) { entities.push_back(entry.entity); });
+    }
+
+    // Calls func(const Entry&) for every entity in the cell containing x, y and the cells up to cellRadius away from it
+    template <typename Func>
+    void QueryCellNeighbourhood(f32 x, f32 y, u32 cellRadius, Func&& func) const
+    {
+        i32 centerX = GetCellCoordinate(x);
+        i32 centerY = GetCellCoordinate(y);
+        i32 range = static_cast<i32>(cellRadius);
+
+        for (i32 cellX = centerX - range; cellX <= centerX + range; cellX++)
+        {
+            for (i32 cellY = centerY - range; cellY <= centerY + range; cellY++)
+            {
+                auto cell = _cells.find(MakeCellKey(cellX, cellY));
+                if (cell == _cells.end())
+                    continue;
+
+                for (const Entry& entry : cell->second)
+                {
+                    func(entry);
+                }
+            }
+        }
+    }
+
+private:
+    struct Location
+    {
+        u64 cellKey;
+        u32 index;
+    };
+
+    i32 GetCellCoordinate(f32 value) const { return static_cast<i32>(std::floor(value * _inverseCellSize)); }
+    u64 GetCellKey(f32 x, f32 y) const { return MakeCellKey(GetCellCoordinate(x), GetCellCoordinate(y)); }
+    static u64 MakeCellKey(i32 cellX, i32 cellY) { return (static_cast<u64>(static_cast<u32>(cellX)) << 32) | static_cast<u32>(cellY); }
+
+    // Swaps the last entry of the cell into the hole so removal stays O(1)
+    void RemoveFromCell(const Location& location)
+    {
+        std::vector<Entry>& cell = _cells[location.cellKey];
+        if (location.index + 1 != cell.size())
+        {
+            cell[location.index] = cell.back();
+            _locations[cell[location.index].entity].index = location.index;
+        }
+        cell.pop_back();
+    }
+
+    f32 _cellSize;
+    f32 _inverseCellSize;
+    robin_hood::unordered_map<u64, std::vector<Entry>> _cells;
+    robin_hood::unordered_map<u32, Location> _locations;
+};
@@ -23,7 +23,9 @@
 */
 #pragma once
 #include <string>
+#include <memory>
 #include <Networking/ByteBuffer.h>
+#include <Networking/PacketPool.h>
 #include "Connections/WorldConnection.h"
 
 struct Message
@@ -33,7 +35,7 @@ struct Message
     i32 code;
     i16 opcode;
     i32 account;
-    Common::ByteBuffer packet;
+    Common::PacketHandle packet;
 	std::string* message;
-    WorldConnection* connection;
+    std::shared_ptr<WorldConnection> connection;
 };
@@ -549,7 +549,7 @@ u32 ItemUpdateFieldFlags[CONTAINER_END] =
     UF_FLAG_PUBLIC,                                         // CONTAINER_FIELD_SLOT_1+70
     UF_FLAG_PUBLIC,                                         // CONTAINER_FIELD_SLOT_1+71
 };
-static u32 UnitUpdateFieldFlags[PLAYER_END] =
+constexpr u32 UnitUpdateFieldFlags[PLAYER_END] =
 {
     UF_FLAG_PUBLIC,                                         // OBJECT_FIELD_GUID
     UF_FLAG_PUBLIC,                                         // OBJECT_FIELD_GUID+1
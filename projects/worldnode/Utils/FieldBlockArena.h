@@ -0,0 +1,90 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+    Hands out fixed size, cache line aligned blocks from contiguous chunks so that every owner of a block shares one arena
+    instead of making its own heap allocation. Freed blocks go on a free list and are handed out again before a new chunk is made.
+*/
+template <size_t BlockSize, size_t BlocksPerChunk = 64>
+class FieldBlockArena
+{
+public:
+    static constexpr size_t BLOCK_ALIGNMENT = 64;
+    static constexpr size_t BLOCK_STRIDE = (BlockSize + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+
+    u8* Allocate()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_freeBlocks.empty())
+        {
+            AddChunk();
+        }
+
+        u8* block = _freeBlocks.back();
+        _freeBlocks.pop_back();
+        return block;
+    }
+
+    void Free(u8* block)
+    {
+        if (block == nullptr)
+            return;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _freeBlocks.push_back(block);
+    }
+
+    size_t GetChunkCount()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _chunks.size();
+    }
+
+private:
+    struct alignas(BLOCK_ALIGNMENT) Chunk
+    {
+        u8 data[BLOCK_STRIDE * BlocksPerChunk];
+    };
+
+    void AddChunk()
+    {
+        _chunks.push_back(std::make_unique<Chunk>());
+        u8* data = _chunks.back()->data;
+
+        // Push in reverse so blocks are handed out in address order
+        for (size_t i = BlocksPerChunk; i > 0; i--)
+        {
+            _freeBlocks.push_back(data + (i - 1) * BLOCK_STRIDE);
+        }
+    }
+
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<Chunk>> _chunks;
+    std::vector<u8*> _freeBlocks;
+};
@@ -0,0 +1,184 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/ByteBuffer.h>
+#include <cassert>
+
+#include "../NovusEnums.h"
+#include "UpdateMask.h"
+#include "../ECS/Components/PlayerFieldDataComponent.h"
+
+constexpr u32 PLAYER_UPDATE_MASK_WORDS = (PLAYER_END + CLIENT_UPDATE_MASK_BITS - 1) / CLIENT_UPDATE_MASK_BITS;
+static_assert(PLAYER_HOT_FIELD_COUNT % CLIENT_UPDATE_MASK_BITS == 0, "A mask word must never span the hot and cold field blocks");
+
+enum PlayerFieldTransform : u8
+{
+    PLAYER_FIELD_TRANSFORM_NONE,
+    PLAYER_FIELD_TRANSFORM_AURASTATE,
+    PLAYER_FIELD_TRANSFORM_DYNAMIC_FLAGS
+};
+
+/*
+    Only fields whose sent value differs from the stored one get a transform. The npc flags, unit flags, display id, bytes 2 and
+    faction template hooks only matter for creatures, gamemasters and cross faction groups which we don't have yet, so for players they are plain copies.
+*/
+constexpr PlayerFieldTransform GetPlayerFieldTransform(u16 index)
+{
+    return index == UNIT_FIELD_AURASTATE ? PLAYER_FIELD_TRANSFORM_AURASTATE :
+        index == UNIT_DYNAMIC_FLAGS ? PLAYER_FIELD_TRANSFORM_DYNAMIC_FLAGS : PLAYER_FIELD_TRANSFORM_NONE;
+}
+
+struct PlayerUpdateFieldTable
+{
+    u32 alwaysMask[PLAYER_UPDATE_MASK_WORDS]; // Dynamic and visible special info fields, sent no matter if they changed
+    u32 visibleMask[PLAYER_UPDATE_MASK_WORDS];
+    u32 transformMask[PLAYER_UPDATE_MASK_WORDS];
+    u16 candidates[PLAYER_END]; // Visible field indices in ascending order
+    u16 candidateCount;
+};
+
+constexpr PlayerUpdateFieldTable BuildPlayerUpdateFieldTable(u32 visibleFlags)
+{
+    PlayerUpdateFieldTable table{};
+    for (u16 index = 0; index < PLAYER_END; index++)
+    {
+        u32 flags = UnitUpdateFieldFlags[index];
+        u32 word = index / CLIENT_UPDATE_MASK_BITS;
+        u32 bit = 1u << (index % CLIENT_UPDATE_MASK_BITS);
+
+        if ((flags & UF_FLAG_DYNAMIC) || (flags & visibleFlags & UF_FLAG_SPECIAL_INFO))
+            table.alwaysMask[word] |= bit;
+
+        if (flags & visibleFlags)
+        {
+            table.visibleMask[word] |= bit;
+            table.candidates[table.candidateCount++] = index;
+        }
+
+        if (GetPlayerFieldTransform(index) != PLAYER_FIELD_TRANSFORM_NONE)
+            table.transformMask[word] |= bit;
+    }
+
+    return table;
+}
+
+inline constexpr PlayerUpdateFieldTable PlayerPublicFieldTable = BuildPlayerUpdateFieldTable(UF_FLAG_PUBLIC);
+inline constexpr PlayerUpdateFieldTable PlayerPartyFieldTable = BuildPlayerUpdateFieldTable(UF_FLAG_PUBLIC | UF_FLAG_PARTY_MEMBER);
+inline constexpr PlayerUpdateFieldTable PlayerSelfFieldTable = BuildPlayerUpdateFieldTable(UF_FLAG_PUBLIC | UF_FLAG_PRIVATE);
+
+inline const PlayerUpdateFieldTable& GetPlayerUpdateFieldTable(u32 visibleFlags)
+{
+    switch (visibleFlags)
+    {
+        case UF_FLAG_PUBLIC:
+            return PlayerPublicFieldTable;
+        case UF_FLAG_PUBLIC | UF_FLAG_PARTY_MEMBER:
+            return PlayerPartyFieldTable;
+        case UF_FLAG_PUBLIC | UF_FLAG_PRIVATE:
+            return PlayerSelfFieldTable;
+        default:
+            assert(false && "No update field table was built for these visible flags");
+            return PlayerPublicFieldTable;
+    }
+}
+
+// Fields that changed since the last update and that the receiver is allowed to see
+inline void BuildPlayerValuesMask(const PlayerFieldDataComponent& fieldData, const PlayerUpdateFieldTable& table, u32 (&mask)[PLAYER_UPDATE_MASK_WORDS])
+{
+    for (u32 i = 0; i < PLAYER_UPDATE_MASK_WORDS; i++)
+    {
+        mask[i] = table.alwaysMask[i];
+    }
+
+    for (u64 dirtyWords = fieldData.changesMask.GetDirtyWords(); dirtyWords != 0; dirtyWords &= dirtyWords - 1)
+    {
+        u32 word = FieldChangeMask<PLAYER_END>::CountTrailingZeros(dirtyWords);
+        mask[word] |= fieldData.changesMask.GetWord(word) & table.visibleMask[word];
+    }
+}
+
+// Every visible field that holds a value, used for creates where the receiver has no previous state
+inline void BuildPlayerCreateMask(const PlayerFieldDataComponent& fieldData, const PlayerUpdateFieldTable& table, u32 (&mask)[PLAYER_UPDATE_MASK_WORDS])
+{
+    for (u32 i = 0; i < PLAYER_UPDATE_MASK_WORDS; i++)
+    {
+        mask[i] = table.alwaysMask[i];
+    }
+
+    for (u16 i = 0; i < table.candidateCount; i++)
+    {
+        u16 index = table.candidates[i];
+        if (fieldData.GetFieldValue<u32>(index) != 0)
+            mask[index / CLIENT_UPDATE_MASK_BITS] |= 1u << (index % CLIENT_UPDATE_MASK_BITS);
+    }
+}
+
+/*
+    Writes the block count, the mask and then the value of every field set in the mask in index order.
+    Runs of neighbouring fields without a transform are copied in one go, a run never leaves its mask word so it never leaves its field block either.
+*/
+inline void WritePlayerFields(Common::ByteBuffer& buffer, const u32 (&mask)[PLAYER_UPDATE_MASK_WORDS], const PlayerUpdateFieldTable& table, const PlayerFieldDataComponent& fieldData)
+{
+    buffer.Write<u8>(PLAYER_UPDATE_MASK_WORDS);
+    buffer.Append(reinterpret_cast<const u8*>(mask), sizeof(mask));
+
+    for (u32 word = 0; word < PLAYER_UPDATE_MASK_WORDS; word++)
+    {
+        u32 bits = mask[word];
+        while (bits != 0)
+        {
+            u32 bit = FieldChangeMask<PLAYER_END>::CountTrailingZeros(bits);
+            u16 index = static_cast<u16>(word * CLIENT_UPDATE_MASK_BITS + bit);
+
+            if (table.transformMask[word] & (1u << bit))
+            {
+                u32 value = fieldData.GetFieldValue<u32>(index);
+                switch (GetPlayerFieldTransform(index))
+                {
+                    case PLAYER_FIELD_TRANSFORM_AURASTATE:
+                        // Per caster aura states, keeps the client from enabling spells when the aura isn't from the target
+                        value &= ~((1 << (14 - 1)) | (1 << (16 - 1)));
+                        break;
+                    case PLAYER_FIELD_TRANSFORM_DYNAMIC_FLAGS:
+                        value &= ~(0x4 | 0x08); // UNIT_DYNFLAG_TAPPED | UNIT_DYNFLAG_TAPPED_BY_PLAYER
+                        break;
+                    default:
+                        break;
+                }
+
+                buffer.Write<u32>(value);
+                bits &= bits - 1;
+                continue;
+            }
+
+            // Length of the run of untransformed set bits starting at bit
+            u64 run = static_cast<u64>(bits & ~table.transformMask[word]) >> bit;
+            u32 length = FieldChangeMask<PLAYER_END>::CountTrailingZeros(~run);
+
+            buffer.Append(fieldData.GetFieldPointer(index), length * 4);
+            bits &= ~static_cast<u32>(((1ull << length) - 1) << bit);
+        }
+    }
+}
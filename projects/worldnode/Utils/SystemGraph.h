@@ -0,0 +1,130 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/AtomicLock.h>
+#include <limits>
+#include <memory>
+#include <robin_hood.h>
+#include <taskflow/taskflow.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+    Builds the update taskflow from the access every system declares. Systems are added in the order
+    they should observe each other's results, a system waits for the last writer of everything it touches
+    and writers additionally wait for every reader since that writer. Systems without conflicts run concurrently.
+    A system taking a tf::SubflowBuilder& may spawn its own tasks, it returns the task that finishes last.
+*/
+class SystemGraph
+{
+public:
+    SystemGraph(tf::Framework& framework) : _framework(framework) { }
+
+    template <typename Access, typename Callable>
+    tf::Task Emplace(const std::string& name, Callable&& callable)
+    {
+#ifndef NDEBUG
+        tf::Task task;
+        if constexpr (std::is_invocable_v<Callable, tf::SubflowBuilder&>)
+        {
+            // Subflow systems return their last task, the counters stay held until it finished
+            task = _framework.emplace([callable = std::forward<Callable>(callable)](tf::SubflowBuilder& subflow) mutable
+            {
+                std::shared_ptr<typename Access::Locks> locks = std::make_shared<typename Access::Locks>();
+                typename Access::Scope scope;
+
+                tf::Task lastTask = callable(subflow);
+                subflow.emplace([locks]() mutable { locks.reset(); }).gather(lastTask);
+            });
+        }
+        else
+        {
+            task = _framework.emplace([callable = std::forward<Callable>(callable)]() mutable
+            {
+                typename Access::Guard guard;
+                callable();
+            });
+        }
+#else
+        tf::Task task = _framework.emplace(std::forward<Callable>(callable));
+#endif
+        task.name(name);
+
+        size_t index = _tasks.size();
+        std::vector<size_t> dependencies;
+
+        for (const void* key : Access::GetReads())
+        {
+            assert(std::find(Access::GetWrites().begin(), Access::GetWrites().end(), key) == Access::GetWrites().end());
+
+            ResourceState& state = _resources[key];
+            if (state.lastWriter != NO_WRITER)
+                dependencies.push_back(state.lastWriter);
+        }
+        for (const void* key : Access::GetWrites())
+        {
+            ResourceState& state = _resources[key];
+            if (state.lastWriter != NO_WRITER)
+                dependencies.push_back(state.lastWriter);
+
+            dependencies.insert(dependencies.end(), state.readers.begin(), state.readers.end());
+        }
+
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        for (size_t dependency : dependencies)
+        {
+            task.gather(_tasks[dependency]);
+        }
+
+        for (const void* key : Access::GetReads())
+        {
+            _resources[key].readers.push_back(index);
+        }
+        for (const void* key : Access::GetWrites())
+        {
+            ResourceState& state = _resources[key];
+            state.lastWriter = index;
+            state.readers.clear();
+        }
+
+        _tasks.push_back(task);
+        return task;
+    }
+
+private:
+    static constexpr size_t NO_WRITER = std::numeric_limits<size_t>::max();
+
+    struct ResourceState
+    {
+        size_t lastWriter = NO_WRITER;
+        std::vector<size_t> readers;
+    };
+
+    tf::Framework& _framework;
+    std::vector<tf::Task> _tasks;
+    robin_hood::unordered_map<const void*, ResourceState> _resources;
+};
@@ -2,14 +2,47 @@
 #include <NovusTypes.h>
 #include <Networking/ByteBuffer.h>
 #include <Networking/Opcode/Opcode.h>
+#include <Utils/DebugHandler.h>
 #include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+struct CompressionSettings
+{
+    i32 level = 1; // 1 - 9 (9 Being best)
+    u32 threshold = 1024; // Update packets over this many bytes get compressed
+};
+
+struct CompressionStats
+{
+    std::atomic<u64> packets;
+    std::atomic<u64> inputBytes;
+    std::atomic<u64> outputBytes;
+    std::atomic<u64> compressTimeNs; // Time spent inside deflate, summed over every thread that compressed
+    std::atomic<u64> failures;
+};
 
 class UpdateData
 {
 public:
     UpdateData() : _blockCount(0) { }
 
-    bool IsEmpty() { return _data.empty() && _nonVisibleGuids.empty(); }
+    static void SetupCompression(const CompressionSettings& settings)
+    {
+        _compressionLevel = std::clamp(settings.level, 1, 9);
+        _compressionThreshold = settings.threshold;
+    }
+    static const CompressionStats& GetCompressionStats() { return _compressionStats; }
+    bool IsEmpty() { return _blockCount == 0 && _nonVisibleGuids.empty(); }
+    u32 GetBlockCount() { return _blockCount; }
+
+    void Clear()
+    {
+        _blockCount = 0;
+        _nonVisibleGuids.clear();
+        _data.Clean();
+    }
 
     void AddBlock(Common::ByteBuffer const& block)
     {
@@ -23,7 +56,7 @@ public:
 
     bool Build(Common::ByteBuffer& packet, u16& opcode)
     {
-        Common::ByteBuffer buffer((4 + _nonVisibleGuids.empty() ? 0 : 1 + 4 + 9 * _nonVisibleGuids.size()) + _data._writePos);
+        Common::ByteBuffer buffer(4 + (_nonVisibleGuids.empty() ? 0 : 1 + 4 + 9 * _nonVisibleGuids.size()) + _data._writePos);
         buffer.Write<u32>(_nonVisibleGuids.empty() ? _blockCount : _blockCount + 1);
 
         if (!_nonVisibleGuids.empty())
@@ -40,14 +73,14 @@ public:
         buffer.Append(_data);
         size_t pSize = buffer._writePos;
 
-        if (pSize > 1024) // Update packets over 1kb gets compressed
+        if (pSize > _compressionThreshold)
         {
             u32 destsize = compressBound(uLong(pSize));
             packet.Resize(destsize + sizeof(u32));
             packet._writePos = packet.size();
 
             packet.Replace<u32>(0, u32(pSize));
-            Compress(const_cast<u8*>(packet.data()) + sizeof(u32), &destsize, (void*)buffer.data(), i32(pSize));
+            destsize = Compress(const_cast<u8*>(packet.data()) + sizeof(u32), destsize, buffer.data(), u32(pSize));
             if (destsize == 0)
                 return false;
 
@@ -70,64 +103,88 @@ private:
     std::vector<u64> _nonVisibleGuids;
     Common::ByteBuffer _data;
 
-    void Compress(void* dst, u32 *dst_size, void* src, i32 src_size)
+    // Every thread keeps one deflate stream alive and resets it between packets, instead of paying deflateInit/deflateEnd per packet
+    class DeflateStream
     {
-        z_stream c_stream;
-
-        c_stream.zalloc = static_cast<alloc_func>(nullptr);
-        c_stream.zfree = static_cast<free_func>(nullptr);
-        c_stream.opaque = static_cast<voidpf>(nullptr);
-
-        // default Z_BEST_SPEED (1)
-        i32 z_res = deflateInit(&c_stream, 1); // 1 - 9 (9 Being best)
-        if (z_res != Z_OK)
+    public:
+        DeflateStream() : _stream(), _level(0) { }
+        ~DeflateStream()
         {
-            std::cout << "Can't compress update packet (zlib: deflateInit) Error code: %i (%s)" << std::endl;
-            //TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflateInit) Error code: %i (%s)", z_res, zError(z_res));
-            *dst_size = 0;
-            return;
+            if (_level != 0)
+                deflateEnd(&_stream);
         }
 
-        c_stream.next_out = static_cast<Bytef*>(dst);
-        c_stream.avail_out = *dst_size;
-        c_stream.next_in = static_cast<Bytef*>(src);
-        c_stream.avail_in = static_cast<uInt>(src_size);
-
-        z_res = deflate(&c_stream, Z_NO_FLUSH);
-        if (z_res != Z_OK)
+        z_stream* Acquire(i32 level)
         {
-            std::cout << "Can't compress update packet (zlib: deflate) Error code: %i (%s)" << std::endl;
-            //TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflate) Error code: %i (%s)", z_res, zError(z_res));
-            *dst_size = 0;
-            return;
+            if (_level == level)
+            {
+                deflateReset(&_stream);
+                return &_stream;
+            }
+
+            if (_level != 0)
+                deflateEnd(&_stream);
+
+            _stream.zalloc = static_cast<alloc_func>(nullptr);
+            _stream.zfree = static_cast<free_func>(nullptr);
+            _stream.opaque = static_cast<voidpf>(nullptr);
+
+            i32 z_res = deflateInit(&_stream, level);
+            if (z_res != Z_OK)
+            {
+                NC_LOG_ERROR("Can't compress update packet (zlib: deflateInit) Error code: %i (%s)", z_res, zError(z_res));
+                _level = 0;
+                return nullptr;
+            }
+
+            _level = level;
+            return &_stream;
         }
 
-        if (c_stream.avail_in != 0)
+    private:
+        z_stream _stream;
+        i32 _level;
+    };
+
+    // Returns the compressed size, 0 if the packet couldn't be compressed
+    static u32 Compress(u8* dst, u32 dstSize, const u8* src, u32 srcSize)
+    {
+        thread_local DeflateStream deflateStream;
+
+        auto start = std::chrono::steady_clock::now();
+        z_stream* stream = deflateStream.Acquire(_compressionLevel);
+        if (!stream)
         {
-            std::cout << "Can't compress update packet (zlib: deflate not greedy)" << std::endl;
-            //TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflate not greedy)");
-            *dst_size = 0;
-            return;
+            _compressionStats.failures++;
+            return 0;
         }
 
-        z_res = deflate(&c_stream, Z_FINISH);
+        stream->next_out = static_cast<Bytef*>(dst);
+        stream->avail_out = dstSize;
+        stream->next_in = const_cast<Bytef*>(src);
+        stream->avail_in = static_cast<uInt>(srcSize);
+
+        // The output buffer is sized with compressBound, so a single finishing call always consumes everything
+        i32 z_res = deflate(stream, Z_FINISH);
         if (z_res != Z_STREAM_END)
         {
-            std::cout << "Can't compress update packet (zlib: deflate should report Z_STREAM_END instead %i (%s)" << std::endl;
-            //TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflate should report Z_STREAM_END instead %i (%s)", z_res, zError(z_res));
-            *dst_size = 0;
-            return;
+            NC_LOG_ERROR("Can't compress update packet (zlib: deflate should report Z_STREAM_END instead %i (%s))", z_res, zError(z_res));
+            _compressionStats.failures++;
+            return 0;
         }
 
-        z_res = deflateEnd(&c_stream);
-        if (z_res != Z_OK)
-        {
-            std::cout << "Can't compress update packet (zlib: deflateEnd) Error code: %i (%s)" << std::endl;
-            //TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflateEnd) Error code: %i (%s)", z_res, zError(z_res));
-            *dst_size = 0;
-            return;
-        }
+        u32 compressedSize = static_cast<u32>(stream->total_out);
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
 
-        *dst_size = c_stream.total_out;
+        _compressionStats.packets++;
+        _compressionStats.inputBytes += srcSize;
+        _compressionStats.outputBytes += compressedSize;
+        _compressionStats.compressTimeNs += static_cast<u64>(elapsed.count());
+
+        return compressedSize;
     }
-};
+
+    inline static i32 _compressionLevel = 1;
+    inline static u32 _compressionThreshold = 1024;
+    inline static CompressionStats _compressionStats = {};
+};
\ No newline at end of file
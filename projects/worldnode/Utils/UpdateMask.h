@@ -3,6 +3,10 @@
 #include <Networking/ByteBuffer.h>
 #include <bitset>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define CLIENT_UPDATE_MASK_BITS 32
 
 /* How to calculate size
@@ -76,4 +80,65 @@ private:
     u32 _fieldCount;
     u32 _blockCount;
     std::bitset<size> _bits;
+};
+
+/*
+    Change tracking for a fixed field count, one bit per 4 byte field like UpdateMask. On top of the bits it keeps one summary
+    bit per 32 bit mask word, so Any, Reset and walking the changes only touch the words that actually have something set.
+*/
+template <u32 FieldCount>
+class FieldChangeMask
+{
+public:
+    static constexpr u32 WORD_COUNT = (FieldCount + CLIENT_UPDATE_MASK_BITS - 1) / CLIENT_UPDATE_MASK_BITS;
+    static_assert(WORD_COUNT <= 64, "The dirty word summary only has 64 bits");
+
+    FieldChangeMask() : _dirtyWords(0)
+    {
+        for (u32 i = 0; i < WORD_COUNT; i++)
+        {
+            _words[i] = 0;
+        }
+    }
+
+    void SetBit(u32 index)
+    {
+        u32 word = index / CLIENT_UPDATE_MASK_BITS;
+        _words[word] |= 1u << (index % CLIENT_UPDATE_MASK_BITS);
+        _dirtyWords |= 1ull << word;
+    }
+    bool IsSet(u32 index) const
+    {
+        return (_words[index / CLIENT_UPDATE_MASK_BITS] & (1u << (index % CLIENT_UPDATE_MASK_BITS))) != 0;
+    }
+    bool Any() const
+    {
+        return _dirtyWords != 0;
+    }
+    void Reset()
+    {
+        for (u64 dirtyWords = _dirtyWords; dirtyWords != 0; dirtyWords &= dirtyWords - 1)
+        {
+            _words[CountTrailingZeros(dirtyWords)] = 0;
+        }
+        _dirtyWords = 0;
+    }
+
+    u32 GetWord(u32 word) const { return _words[word]; }
+    u64 GetDirtyWords() const { return _dirtyWords; }
+
+    static u32 CountTrailingZeros(u64 value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<u32>(index);
+#else
+        return static_cast<u32>(__builtin_ctzll(value));
+#endif
+    }
+
+private:
+    u32 _words[WORD_COUNT];
+    u64 _dirtyWords;
 };
\ No newline at end of file
@@ -13,7 +13,10 @@
 #include "ECS/Systems/CommandParserSystem.h"
 #include "ECS/Systems/PlayerCreateDataSystem.h"
 #include "ECS/Systems/ItemCreateDataSystem.h"
+#include "ECS/Systems/SpatialGridSystem.h"
+#include "ECS/Systems/VisibilitySystem.h"
 #include "ECS/Systems/PlayerUpdateDataSystem.h"
+#include "ECS/Systems/ChatSystem.h"
 #include "ECS/Systems/ClientUpdateSystem.h"
 #include "ECS/Systems/PlayerCreateSystem.h"
 #include "ECS/Systems/ItemCreateSystem.h"
@@ -29,17 +32,21 @@
 #include "ECS/Components/Singletons/PlayerPacketQueueSingleton.h"
 #include "ECS/Components/Singletons/ItemCreateQueueSingleton.h"
 #include "ECS/Components/Singletons/DBCDatabaseCacheSingleton.h"
+#include "ECS/Components/Singletons/SpatialGridSingleton.h"
+#include "ECS/Components/Singletons/ChatSingleton.h"
 
 // Game
 #include "Game/Commands/Commands.h"
 #include "Game/ObjectGuid/ObjectGuid.h"
+#include "Utils/SystemGraph.h"
 
-WorldNodeHandler::WorldNodeHandler(f32 targetTickRate)
+WorldNodeHandler::WorldNodeHandler(const TickSchedulerSettings& tickSettings, const InterestSettings& interestSettings)
     : _isRunning(false)
+    , _tickScheduler(tickSettings)
+    , _interestSettings(interestSettings)
     , _inputQueue(256)
     , _outputQueue(256)
 {
-    _targetTickRate = targetTickRate;
 }
 
 WorldNodeHandler::~WorldNodeHandler()
@@ -99,12 +106,19 @@ void WorldNodeHandler::Run()
     PlayerDeleteQueueSingleton& playerDeleteQueueSingleton = _updateFramework.registry.set<PlayerDeleteQueueSingleton>();
     PlayerPacketQueueSingleton& playerPacketQueueSingleton = _updateFramework.registry.set<PlayerPacketQueueSingleton>();
     ItemCreateQueueSingleton& itemCreateQueueComponent = _updateFramework.registry.set<ItemCreateQueueSingleton>();
+    SpatialGridSingleton& spatialGridSingleton = _updateFramework.registry.set<SpatialGridSingleton>();
+    ChatSingleton& chatSingleton = _updateFramework.registry.set<ChatSingleton>();
 
 	WorldDatabaseCacheSingleton& worldDatabaseCacheSingleton = _updateFramework.registry.set<WorldDatabaseCacheSingleton>();
 	CharacterDatabaseCacheSingleton& characterDatabaseCacheSingleton = _updateFramework.registry.set<CharacterDatabaseCacheSingleton>();
 	
     singletonComponent.worldNodeHandler = this;
     singletonComponent.deltaTime = 1.0f;
+    spatialGridSingleton.cellSize = _interestSettings.gridCellSize;
+    spatialGridSingleton.visibilityRange = _interestSettings.visibilityRange;
+    chatSingleton.sayRange = _interestSettings.sayRange;
+    chatSingleton.yellRange = _interestSettings.yellRange;
+    chatSingleton.emoteRange = _interestSettings.emoteRange;
 
     playerCreateQueueComponent.newPlayerQueue = new moodycamel::ConcurrentQueue<Message>(256);
     playerDeleteQueueSingleton.expiredEntityQueue = new moodycamel::ConcurrentQueue<ExpiredPlayerData>(256);
@@ -121,6 +135,7 @@ void WorldNodeHandler::Run()
     Commands::LoadCommands(_updateFramework.registry);
 
     Timer timer;
+    _tickScheduler.Start();
     while (true)
     {
         f32 deltaTime = timer.GetDeltaTime();
@@ -135,23 +150,7 @@ void WorldNodeHandler::Run()
 
         {
             ZoneScopedNC("WaitForTickRate", tracy::Color::AntiqueWhite1)
-
-            // Wait for tick rate, this might be an overkill implementation but it has the even tickrate I've seen - MPursche
-            f32 targetDelta = 1.0f / _targetTickRate;
-            {
-                ZoneScopedNC("Sleep", tracy::Color::AntiqueWhite1)
-                for (deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta - 0.0025f; deltaTime = timer.GetDeltaTime())
-                {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                }
-            }
-            {
-                ZoneScopedNC("Yield", tracy::Color::AntiqueWhite1)
-                for (deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta; deltaTime = timer.GetDeltaTime())
-                {
-                    std::this_thread::yield();
-                }
-            }
+            _tickScheduler.WaitForNextTick();
         }
 
         FrameMark
@@ -191,30 +190,20 @@ bool WorldNodeHandler::Update()
                 _outputQueue.enqueue(pongMessage);
             }
 
+            // Only CMSG_PLAYER_LOGIN comes through here, every other tick packet goes straight to its connection's inbound queue
             if (message.code == MSG_IN_FOWARD_PACKET)
             {
-                // Create Entity if it doesn't exist, otherwise add
-                if (static_cast<Common::Opcode>(static_cast<u16>(message.opcode)) == Common::Opcode::CMSG_PLAYER_LOGIN)
-                {
-                    ZoneScopedNC("LoginMessage", tracy::Color::Green3)
-                    _updateFramework.registry.ctx<PlayerCreateQueueSingleton>().newPlayerQueue->enqueue(message);
-                }
-                else
-                {
-                    ZoneScopedNC("ForwardMessage", tracy::Color::Green3)
-                    SingletonComponent& singletonComponent = _updateFramework.registry.ctx<SingletonComponent>();
-
-                    auto itr = singletonComponent.accountToEntityMap.find(static_cast<u32>(message.account));
-                    if (itr != singletonComponent.accountToEntityMap.end())
-                    {
-                        PlayerConnectionComponent& connection = _updateFramework.registry.get<PlayerConnectionComponent>(itr->second);
-                        connection.packets.push_back({ static_cast<u16>(message.opcode), false, message.packet });
-                    }
-                }
+                ZoneScopedNC("LoginMessage", tracy::Color::Green3)
+                _updateFramework.registry.ctx<PlayerCreateQueueSingleton>().newPlayerQueue->enqueue(message);
             }
         }
     }
 
+    {
+        ZoneScopedNC("DatabaseCallbacks", tracy::Color::Green3)
+        _databaseCallbacks.Run();
+    }
+
     UpdateSystems();
     return true;
 }
@@ -224,92 +213,118 @@ void WorldNodeHandler::SetupUpdateFramework()
     tf::Framework& framework = _updateFramework.framework;
     entt::registry& registry = _updateFramework.registry;
 
+    // Views create missing pools on demand which resizes the registry's pool list, create them all up front so concurrent systems only look them up
+    registry.reserve<PlayerConnectionComponent>(0);
+    registry.reserve<PlayerInitializeComponent>(0);
+    registry.reserve<PlayerFieldDataComponent>(0);
+    registry.reserve<PlayerUpdateDataComponent>(0);
+    registry.reserve<PlayerPositionComponent>(0);
+    registry.reserve<PlayerSpellStorageComponent>(0);
+    registry.reserve<PlayerSkillStorageComponent>(0);
+    registry.reserve<ItemDataComponent>(0);
+    registry.reserve<ItemInitializeComponent>(0);
+    registry.reserve<ItemFieldDataComponent>(0);
+
+    // Dependencies come from each system's declared Access, the order below only decides who observes whose writes
+    SystemGraph systemGraph(framework);
+
     // ConnectionSystem
-    tf::Task connectionSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<ConnectionSystem::Access>("ConnectionSystem", [&registry](tf::SubflowBuilder& subflow)
     {
         ZoneScopedNC("ConnectionSystem", tracy::Color::Orange2)
-        ConnectionSystem::Update(registry);
+        return ConnectionSystem::Update(registry, subflow);
     });
 
     // CommandParserSystem
-    tf::Task commandParserSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<CommandParserSystem::Access>("CommandParserSystem", [&registry]()
     {
         ZoneScopedNC("CommandParserSystem", tracy::Color::Blue2)
         CommandParserSystem::Update(registry);
     });
-    commandParserSystemTask.gather(connectionSystemTask);
 
     // PlayerInitializeSystem
-    tf::Task playerInitializeSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<PlayerInitializeSystem::Access>("PlayerInitializeSystem", [&registry]()
     {
         ZoneScopedNC("PlayerInitializeSystem", tracy::Color::Blue2)
-            PlayerInitializeSystem::Update(registry);
+        PlayerInitializeSystem::Update(registry);
     });
-    playerInitializeSystemTask.gather(commandParserSystemTask);
 
     // ItemInitializeSystem
-    tf::Task itemInitializeSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<ItemInitializeSystem::Access>("ItemInitializeSystem", [&registry]()
     {
         ZoneScopedNC("ItemInitializeSystem", tracy::Color::Blue2)
-            ItemInitializeSystem::Update(registry);
+        ItemInitializeSystem::Update(registry);
     });
-    itemInitializeSystemTask.gather(playerInitializeSystemTask);
 
     // PlayerCreateDataSystem
-    tf::Task playerCreateDataSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<PlayerCreateDataSystem::Access>("PlayerCreateDataSystem", [&registry]()
     {
         ZoneScopedNC("PlayerCreateDataSystem", tracy::Color::Blue2)
         PlayerCreateDataSystem::Update(registry);
     });
-    playerCreateDataSystemTask.gather(itemInitializeSystemTask);
 
     // ItemCreateDataSystem
-    tf::Task itemCreateDataSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<ItemCreateDataSystem::Access>("ItemCreateDataSystem", [&registry]()
     {
         ZoneScopedNC("ItemCreateDataSystem", tracy::Color::Blue2)
-            ItemCreateDataSystem::Update(registry);
+        ItemCreateDataSystem::Update(registry);
+    });
+
+    // SpatialGridSystem
+    systemGraph.Emplace<SpatialGridSystem::Access>("SpatialGridSystem", [&registry]()
+    {
+        ZoneScopedNC("SpatialGridSystem", tracy::Color::Blue2)
+        SpatialGridSystem::Update(registry);
+    });
+
+    // VisibilitySystem
+    systemGraph.Emplace<VisibilitySystem::Access>("VisibilitySystem", [&registry]()
+    {
+        ZoneScopedNC("VisibilitySystem", tracy::Color::Blue2)
+        VisibilitySystem::Update(registry);
     });
-    itemCreateDataSystemTask.gather(playerCreateDataSystemTask);
 
     // PlayerUpdateDataSystem
-    tf::Task playerUpdateDataSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<PlayerUpdateDataSystem::Access>("PlayerUpdateDataSystem", [&registry]()
     {
         ZoneScopedNC("PlayerUpdateDataSystem", tracy::Color::Yellow2)
         PlayerUpdateDataSystem::Update(registry);
     });
-    playerUpdateDataSystemTask.gather(itemCreateDataSystemTask);
+
+    // ChatSystem
+    systemGraph.Emplace<ChatSystem::Access>("ChatSystem", [&registry]()
+    {
+        ZoneScopedNC("ChatSystem", tracy::Color::Yellow2)
+        ChatSystem::Update(registry);
+    });
 
     // ClientUpdateSystem
-    tf::Task clientUpdateSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<ClientUpdateSystem::Access>("ClientUpdateSystem", [&registry](tf::SubflowBuilder& subflow)
     {
-        ZoneScopedNC("clientUpdateSystemTask", tracy::Color::Blue2)
-        ClientUpdateSystem::Update(registry);
+        ZoneScopedNC("ClientUpdateSystem", tracy::Color::Blue2)
+        return ClientUpdateSystem::Update(registry, subflow);
     });
-    clientUpdateSystemTask.gather(playerUpdateDataSystemTask);
 
     // PlayerCreateSystem
-    tf::Task playerCreateSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<PlayerCreateSystem::Access>("PlayerCreateSystem", [&registry]()
     {
         ZoneScopedNC("PlayerCreateSystem", tracy::Color::Blue2)
-            PlayerCreateSystem::Update(registry);
+        PlayerCreateSystem::Update(registry);
     });
-    playerCreateSystemTask.gather(clientUpdateSystemTask);
 
     // ItemCreateSystem
-    tf::Task itemCreateSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<ItemCreateSystem::Access>("ItemCreateSystem", [&registry]()
     {
         ZoneScopedNC("ItemCreateSystem", tracy::Color::Blue2)
-            ItemCreateSystem::Update(registry);
+        ItemCreateSystem::Update(registry);
     });
-    itemCreateSystemTask.gather(playerCreateSystemTask);
 
     // PlayerDeleteSystem
-    tf::Task playerDeleteSystemTask = framework.emplace([&registry]()
+    systemGraph.Emplace<PlayerDeleteSystem::Access>("PlayerDeleteSystem", [&registry]()
     {
         ZoneScopedNC("PlayerDeleteSystem", tracy::Color::Blue2)
         PlayerDeleteSystem::Update(registry);
     });
-    playerDeleteSystemTask.gather(itemCreateSystemTask);
 }
 
 void WorldNodeHandler::UpdateSystems()
@@ -24,8 +24,11 @@
 #pragma once
 #include <NovusTypes.h>
 #include <Utils/StringUtils.h>
+#include <Utils/TickScheduler.h>
+#include <Database/SQLCallbackQueue.h>
 #include "Utils/ConcurrentQueue.h"
 #include "Utils/MapLoader.h"
+#include "Game/SpatialGrid.h"
 #include "Message.h"
 #include <entt.hpp>
 #include <taskflow/taskflow.hpp>
@@ -59,7 +62,7 @@ class NovusConnection;
 class WorldNodeHandler
 {
 public:
-	WorldNodeHandler(f32 targetTickRate);
+	WorldNodeHandler(const TickSchedulerSettings& tickSettings, const InterestSettings& interestSettings);
 	~WorldNodeHandler();
 
 	void Start();
@@ -79,6 +82,11 @@ public:
         printMessage.message = new std::string(str);
         _outputQueue.enqueue(printMessage);
     }
+
+    TickStats GetTickStats() const { return _tickScheduler.GetStats(); }
+
+    // Database callbacks handed to this run at the start of the next tick, before any system touches the registry
+    SQLCallbackDispatcher GetDatabaseDispatcher() { return _databaseCallbacks.GetDispatcher(); }
 private:
 	void Run();
 	bool Update();
@@ -88,10 +96,12 @@ private:
 
 private:
 	bool _isRunning;
-    f32 _targetTickRate;
+    TickScheduler _tickScheduler;
+    InterestSettings _interestSettings;
 
 	moodycamel::ConcurrentQueue<Message> _inputQueue;
 	moodycamel::ConcurrentQueue<Message> _outputQueue;
 	FrameworkRegistryPair _updateFramework;
     MapLoader _mapLoader;
+    SQLCallbackQueue _databaseCallbacks;
 };
@@ -10,6 +10,8 @@
 #include "ConnectionHandlers/WorldConnectionHandler.h"
 
 #include "WorldNodeHandler.h"
+#include "Utils/UpdateData.h"
+#include "Game/MovementRelay.h"
 #include "Message.h"
 
 #include "ConsoleCommands.h"
@@ -50,6 +52,12 @@ i32 main()
     dbConnections[DATABASE_TYPE::WORLDSERVER] = DatabaseConnectionDetails(ConfigHandler::GetJsonObjectByKey("world_database"));
     dbConnections[DATABASE_TYPE::DBC] = DatabaseConnectionDetails(ConfigHandler::GetJsonObjectByKey("dbc_database"));
 
+    PreparedStatementSettings preparedStatementSettings;
+    preparedStatementSettings.enabled = ConfigHandler::GetOption<bool>("preparedStatements", true);
+    preparedStatementSettings.maxCachedStatements = ConfigHandler::GetOption<u32>("maxCachedStatements", 256);
+    DatabaseConnector::SetupPreparedStatements(preparedStatementSettings);
+    DatabaseConnector::SetupAsyncWorkers(ConfigHandler::GetOption<u32>("asyncWorkers", 2));
+
     /* Pass Database Information to Setup */
     DatabaseConnector::Setup(dbConnections);
 
@@ -60,18 +68,54 @@ i32 main()
 		return 0;
 	}
 
-    WorldNodeHandler worldNodeHandler(ConfigHandler::GetOption<f32>("tickRate", 30));
+    TickSchedulerSettings tickSettings;
+    tickSettings.tickRate = ConfigHandler::GetOption<f32>("tickRate", 30);
+    tickSettings.overrunPolicy = ConfigHandler::GetOption<std::string>("tickOverrunPolicy", "skip") == "catchup" ? TICK_OVERRUN_CATCH_UP : TICK_OVERRUN_SKIP;
+    tickSettings.maxCatchUpTicks = ConfigHandler::GetOption<u32>("maxCatchUpTicks", 5);
+    tickSettings.spinTime = std::chrono::microseconds(ConfigHandler::GetOption<u32>("tickSpinTime", 200));
+
+    InterestSettings interestSettings;
+    interestSettings.gridCellSize = ConfigHandler::GetOption<f32>("gridCellSize", 50.0f);
+    interestSettings.visibilityRange = ConfigHandler::GetOption<f32>("visibilityRange", 100.0f);
+    interestSettings.sayRange = ConfigHandler::GetOption<f32>("sayRange", 25.0f);
+    interestSettings.yellRange = ConfigHandler::GetOption<f32>("yellRange", 300.0f);
+    interestSettings.emoteRange = ConfigHandler::GetOption<f32>("emoteRange", 25.0f);
+
+    CompressionSettings compressionSettings;
+    compressionSettings.level = ConfigHandler::GetOption<i32>("compressionLevel", 1);
+    compressionSettings.threshold = ConfigHandler::GetOption<u32>("compressionThreshold", 1024);
+    UpdateData::SetupCompression(compressionSettings);
+
+    MovementRelaySettings movementRelaySettings;
+    std::vector<std::vector<f32>> heartbeatRelayCurve = ConfigHandler::GetOption<std::vector<std::vector<f32>>>("heartbeatRelayCurve", { { 40.0f, 2.0f }, { 70.0f, 4.0f } });
+    for (const std::vector<f32>& step : heartbeatRelayCurve)
+    {
+        if (step.size() == 2)
+            movementRelaySettings.heartbeatCurve.push_back({ step[0], static_cast<u32>(step[1]) });
+    }
+    MovementRelay::Setup(movementRelaySettings);
+
+    WorldNodeHandler worldNodeHandler(tickSettings, interestSettings);
     worldNodeHandler.Start();
 
-    asio::io_service io_service(2);
-    WorldConnectionHandler WorldConnectionHandler(io_service, ConfigHandler::GetOption<u16>("port", 8001), &worldNodeHandler);
+    FloodControlSettings floodControl;
+    floodControl.rate[Common::OPCODE_COST_LOW] = ConfigHandler::GetOption<f32>("floodControlLowCostRate", 0.0f);
+    floodControl.burst[Common::OPCODE_COST_LOW] = ConfigHandler::GetOption<f32>("floodControlLowCostBurst", 0.0f);
+    floodControl.rate[Common::OPCODE_COST_MEDIUM] = ConfigHandler::GetOption<f32>("floodControlMediumCostRate", 0.0f);
+    floodControl.burst[Common::OPCODE_COST_MEDIUM] = ConfigHandler::GetOption<f32>("floodControlMediumCostBurst", 0.0f);
+    floodControl.rate[Common::OPCODE_COST_HIGH] = ConfigHandler::GetOption<f32>("floodControlHighCostRate", 0.0f);
+    floodControl.burst[Common::OPCODE_COST_HIGH] = ConfigHandler::GetOption<f32>("floodControlHighCostBurst", 0.0f);
+    floodControl.dropRate = ConfigHandler::GetOption<f32>("floodControlDropRate", 0.0f);
+    floodControl.dropBurst = ConfigHandler::GetOption<f32>("floodControlDropBurst", 0.0f);
+    WorldConnection::SetupFloodControl(floodControl);
+    WorldConnection::SetupSendLimits(ConfigHandler::GetOption<u32>("sendHighWaterMark", 0), ConfigHandler::GetOption<u32>("sendMaxPendingBytes", 0), std::chrono::milliseconds(ConfigHandler::GetOption<u32>("sendStallTimeout", 0)));
+
+    Common::IoServicePool ioServicePool(ConfigHandler::GetOption<u16>("networkThreads", 1));
+    WorldConnectionHandler WorldConnectionHandler(ioServicePool, ConfigHandler::GetOption<u16>("port", 8001), ConfigHandler::GetOption<bool>("reusePort", false), &worldNodeHandler);
     WorldConnectionHandler.Start();
 
     srand(static_cast<u32>(time(NULL)));
-    std::thread run_thread([&]
-    {
-        io_service.run();
-    });
+    ioServicePool.Run();
 
     NC_LOG_SUCCESS("Worldnode running on port: %u", WorldConnectionHandler.GetPort());
 
@@ -117,10 +161,6 @@ i32 main()
 		std::cout << "-";
 	std::cout << std::endl;
 
-    io_service.stop();
-    while (!io_service.stopped())
-    {
-        std::this_thread::yield();
-    }
+    ioServicePool.Stop();
 	return 0;
 }
\ No newline at end of file